@@ -1,6 +1,7 @@
 @echo off
 REM Build script for OpenGL project
-REM Usage: build.bat [Debug|Release] [x64|Win32]
+REM Usage: build.bat [Debug|Release] [x64|Win32] [CountAllocations]
+REM CountAllocations builds main.cpp with GL_COUNT_ALLOCATIONS, for openGL.exe --check-alloc
 
 REM Change to the script's directory
 cd /d "%~dp0"
@@ -11,6 +12,9 @@ set PLATFORM=%~2
 if "%CONFIG%"=="" set CONFIG=Debug
 if "%PLATFORM%"=="" set PLATFORM=x64
 
+set EXTRA=
+if /i "%~3"=="CountAllocations" set EXTRA=/p:CountAllocations=true
+
 echo Building %CONFIG%|%PLATFORM% configuration...
 echo Working directory: %CD%
 
@@ -29,9 +33,9 @@ if exist "C:\Program Files\Microsoft Visual Studio\2022\Community\MSBuild\Curren
 if "%MSBUILD_PATH%"=="" (
     echo ERROR: MSBuild not found. Please install Visual Studio 2022 or 2019.
     echo Trying to use MSBuild from PATH...
-    MSBuild.exe opengl.sln /p:Configuration=%CONFIG% /p:Platform=%PLATFORM% /m
+    MSBuild.exe opengl.sln /p:Configuration=%CONFIG% /p:Platform=%PLATFORM% %EXTRA% /m
 ) else (
-    "%MSBUILD_PATH%" opengl.sln /p:Configuration=%CONFIG% /p:Platform=%PLATFORM% /m
+    "%MSBUILD_PATH%" opengl.sln /p:Configuration=%CONFIG% /p:Platform=%PLATFORM% %EXTRA% /m
 )
 
 if %ERRORLEVEL% EQU 0 (
@@ -1,9 +1,11 @@
 # PowerShell build script for OpenGL project
-# Usage: .\build.ps1 [Debug|Release] [x64|Win32]
+# Usage: .\build.ps1 [Debug|Release] [x64|Win32] [-CountAllocations]
+# -CountAllocations builds main.cpp with GL_COUNT_ALLOCATIONS, for openGL.exe --check-alloc
 
 param(
     [string]$Configuration = "Debug",
-    [string]$Platform = "x64"
+    [string]$Platform = "x64",
+    [switch]$CountAllocations
 )
 
 # Change to the script's directory (where opengl.sln is located)
@@ -37,7 +39,10 @@ if ($null -eq $msbuild) {
 Write-Host "Using MSBuild: $msbuild" -ForegroundColor Gray
 
 # Build the solution
-& $msbuild opengl.sln /p:Configuration=$Configuration /p:Platform=$Platform /m /v:minimal
+$extra = @()
+if ($CountAllocations) { $extra += "/p:CountAllocations=true" }
+
+& $msbuild opengl.sln /p:Configuration=$Configuration /p:Platform=$Platform @extra /m /v:minimal
 
 if ($LASTEXITCODE -eq 0) {
     Write-Host "`nBuild succeeded!" -ForegroundColor Green
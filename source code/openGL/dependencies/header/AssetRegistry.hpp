@@ -0,0 +1,124 @@
+#pragma once
+
+#include <PackedVertex.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gl {
+
+    struct Mesh;
+    struct EmbeddedTexture;
+
+    // ============ MESH ASSET ============
+    // GPU-resident meshes of one model file, shared by every Object that loaded it.
+    // Reference counted through shared_ptr; the GL buffers go away with the last user.
+    struct MeshAsset {
+        std::string path; // canonical
+        VertexFormat format = VertexFormat::Standard;
+        std::vector<std::shared_ptr<Mesh>> meshes;
+        std::vector<std::shared_ptr<EmbeddedTexture>> textures; // embedded in the model file
+    };
+
+    // ============ ASSET REGISTRY ============
+    // Maps model paths to live MeshAssets. Holds weak references only, so it never keeps an asset alive.
+    // A repeated request is a single hash lookup on the path as given; other spellings of the same
+    // file are resolved once through the canonical path and then remembered.
+    class AssetRegistry {
+    private:
+        std::mutex m_Mutex;
+        std::unordered_map<std::string, std::weak_ptr<MeshAsset>> m_Requested; // path as requested + format
+        std::unordered_map<std::string, std::weak_ptr<MeshAsset>> m_Canonical; // canonical path + format
+        size_t m_Hits = 0;
+        size_t m_Misses = 0;
+
+        static std::string key(const std::string& path, VertexFormat format) {
+            std::string k = path;
+            k += '|';
+            k += static_cast<char>('0' + static_cast<int>(format));
+            return k;
+        }
+
+    public:
+        static std::string canonicalPath(const std::string& path) {
+            std::error_code ec;
+            std::filesystem::path resolved = std::filesystem::weakly_canonical(path, ec);
+            std::string result = ec ? std::filesystem::path(path).lexically_normal().generic_string() : resolved.generic_string();
+#ifdef _WIN32
+            std::transform(result.begin(), result.end(), result.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+#endif
+            return result;
+        }
+
+        // Live asset for path in the given vertex format, or nullptr
+        std::shared_ptr<MeshAsset> find(const std::string& path, VertexFormat format) {
+            const std::string requested = key(path, format);
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            auto it = m_Requested.find(requested);
+            if (it != m_Requested.end()) {
+                if (auto asset = it->second.lock()) {
+                    m_Hits++;
+                    return asset;
+                }
+            }
+
+            auto canonical = m_Canonical.find(key(canonicalPath(path), format));
+            if (canonical != m_Canonical.end()) {
+                if (auto asset = canonical->second.lock()) {
+                    m_Requested[requested] = asset;
+                    m_Hits++;
+                    return asset;
+                }
+            }
+
+            m_Misses++;
+            return nullptr;
+        }
+
+        // Register freshly uploaded meshes. If another load registered the same asset first,
+        // that one is returned and the caller should use it instead.
+        std::shared_ptr<MeshAsset> insert(const std::string& path, VertexFormat format, std::vector<std::shared_ptr<Mesh>> meshes,
+            std::vector<std::shared_ptr<EmbeddedTexture>> textures = {}) {
+            const std::string canonicalKey = key(canonicalPath(path), format);
+
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            auto& slot = m_Canonical[canonicalKey];
+            auto asset = slot.lock();
+            if (!asset) {
+                asset = std::make_shared<MeshAsset>();
+                asset->path = canonicalPath(path);
+                asset->format = format;
+                asset->meshes = std::move(meshes);
+                asset->textures = std::move(textures);
+                slot = asset;
+            }
+            m_Requested[key(path, format)] = asset;
+            return asset;
+        }
+
+        // Drop entries whose asset has been released. Returns the number of live assets.
+        size_t purge() {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            std::erase_if(m_Requested, [](const auto& entry) { return entry.second.expired(); });
+            std::erase_if(m_Canonical, [](const auto& entry) { return entry.second.expired(); });
+            return m_Canonical.size();
+        }
+
+        size_t hits() const { return m_Hits; }
+
+        size_t misses() const { return m_Misses; }
+    };
+
+    AssetRegistry& getAssetRegistry() {
+        static AssetRegistry registry;
+        return registry;
+    }
+
+} // namespace gl
@@ -0,0 +1,1349 @@
+#pragma once
+
+#include <Mesh.hpp>
+#include <ModelLoader.hpp>
+#include <FrameUniforms.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include <iostream>
+
+// Ad-hoc engine benchmarks. They need a current GL context and are run from main with --bench-* flags.
+namespace gl::bench {
+
+    // Heap allocations made through global operator new; only counted with GL_COUNT_ALLOCATIONS
+    inline std::atomic<size_t> allocationCount{ 0 };
+    inline thread_local size_t threadAllocations = 0; // by the calling thread, unaffected by pool workers
+    inline std::atomic<size_t> allocatedBytes{ 0 }; // live
+    inline std::atomic<size_t> peakBytes{ 0 };
+
+    inline void resetPeak() { peakBytes.store(allocatedBytes.load()); }
+
+}
+
+#ifdef GL_COUNT_ALLOCATIONS
+// Replaces the global allocator for the whole program, so define GL_COUNT_ALLOCATIONS in exactly one translation unit.
+// Each block carries its size in a 16-byte header so live and peak bytes can be tracked.
+void* operator new(std::size_t size) {
+    gl::bench::allocationCount.fetch_add(1, std::memory_order_relaxed);
+    gl::bench::threadAllocations++;
+    unsigned char* block = static_cast<unsigned char*>(std::malloc(size + 16));
+    if (!block) throw std::bad_alloc();
+    std::memcpy(block, &size, sizeof(size));
+
+    size_t live = gl::bench::allocatedBytes.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t peak = gl::bench::peakBytes.load(std::memory_order_relaxed);
+    while (live > peak && !gl::bench::peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    return block + 16;
+}
+
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    unsigned char* block = static_cast<unsigned char*>(p) - 16;
+    size_t size;
+    std::memcpy(&size, block, sizeof(size));
+    gl::bench::allocatedBytes.fetch_sub(size, std::memory_order_relaxed);
+    std::free(block);
+}
+
+void operator delete(void* p, std::size_t) noexcept { operator delete(p); }
+#endif
+
+namespace gl::bench {
+
+    using clock = std::chrono::high_resolution_clock;
+
+    inline double elapsedMs(clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    }
+
+    // ============ MODEL LOAD ============
+    struct LoadTiming {
+        std::string path;
+        size_t meshCount = 0;
+        double coldMs = 0.0; // Assimp import + cache write
+        double warmMs = 0.0; // cache hit, mapped bytes straight to upload
+    };
+
+    LoadTiming modelLoad(const std::string& path, int iterations = 3) {
+        LoadTiming timing;
+        timing.path = path;
+
+        const uint64_t key = Object::cacheKey(path);
+        if (!key) {
+            std::cerr << "bench: cannot read " << path << std::endl;
+            return timing;
+        }
+
+        for (int i = 0; i < iterations; i++) {
+            getMeshCache().invalidate(key);
+
+            auto start = clock::now();
+            Object object;
+            object.loadModel(path);
+            timing.coldMs += elapsedMs(start);
+            timing.meshCount = object.meshes.size();
+        }
+
+        for (int i = 0; i < iterations; i++) {
+            auto start = clock::now();
+            Object object;
+            object.loadModel(path);
+            timing.warmMs += elapsedMs(start);
+        }
+
+        timing.coldMs /= iterations;
+        timing.warmMs /= iterations;
+        return timing;
+    }
+
+    void printModelLoad(const std::vector<std::string>& paths, int iterations = 3) {
+        double coldTotal = 0.0, warmTotal = 0.0;
+
+        std::printf("%-32s %8s %12s %12s %8s\n", "model", "meshes", "cold (ms)", "warm (ms)", "speedup");
+        for (const auto& path : paths) {
+            LoadTiming t = modelLoad(path, iterations);
+            coldTotal += t.coldMs;
+            warmTotal += t.warmMs;
+            std::printf("%-32s %8zu %12.2f %12.2f %7.1fx\n",
+                path.c_str(), t.meshCount, t.coldMs, t.warmMs, t.warmMs > 0.0 ? t.coldMs / t.warmMs : 0.0);
+        }
+        std::printf("%-32s %8s %12.2f %12.2f %7.1fx\n",
+            "total", "", coldTotal, warmTotal, warmTotal > 0.0 ? coldTotal / warmTotal : 0.0);
+    }
+
+    // ============ PARALLEL LOAD ============
+    // Cold imports (cache bypassed) of every path, one after another vs. through ModelLoader
+    void printParallelLoad(const std::vector<std::string>& paths, int iterations = 3) {
+        double serialMs = 0.0, parallelMs = 0.0;
+
+        for (int i = 0; i < iterations; i++) {
+            auto start = clock::now();
+            for (const auto& path : paths) {
+                Object object;
+                object.loadModel(path, false);
+            }
+            serialMs += elapsedMs(start);
+        }
+
+        for (int i = 0; i < iterations; i++) {
+            std::vector<std::shared_ptr<Object>> objects;
+            ModelLoader loader;
+
+            auto start = clock::now();
+            for (const auto& path : paths) {
+                objects.push_back(std::make_shared<Object>(path));
+                loader.loadAsync(objects.back(), path, false);
+            }
+            loader.finish();
+            parallelMs += elapsedMs(start);
+        }
+
+        serialMs /= iterations;
+        parallelMs /= iterations;
+
+        std::printf("%zu models, %zu worker threads\n", paths.size(), getThreadPool().size());
+        std::printf("serial:   %10.2f ms\n", serialMs);
+        std::printf("parallel: %10.2f ms (%.2fx)\n", parallelMs, parallelMs > 0.0 ? serialMs / parallelMs : 0.0);
+    }
+
+    // ============ MESH OPTIMISATION ============
+    // Per-mesh vertex count and post-transform cache efficiency before/after Mesh::optimize()
+    void printMeshOptimization(const std::vector<std::string>& paths) {
+        std::printf("%-32s %5s %9s %9s %7s %7s %7s %7s\n",
+            "model", "mesh", "verts", "welded", "ACMR", "ACMR'", "ATVR", "ATVR'");
+
+        for (const auto& path : paths) {
+            ImportedModel model;
+            if (!Object::importModel(path, model, false)) continue;
+
+            for (size_t i = 0; i < model.meshes.size(); i++) {
+                const auto& stats = model.meshes[i]->optimizeStats;
+                std::printf("%-32s %5zu %9zu %9zu %7.3f %7.3f %7.3f %7.3f\n",
+                    path.c_str(), i, stats.verticesBefore, stats.verticesAfter,
+                    stats.before.acmr, stats.after.acmr, stats.before.atvr, stats.after.atvr);
+            }
+        }
+    }
+
+    // ============ VERTEX FORMAT ============
+    // Memory footprint, estimated vertex fetch per draw and decode error of PackedVertex vs Mesh::Vertex
+    void printVertexFormats(const std::vector<std::string>& paths) {
+        std::printf("%-32s %9s %9s %11s %11s %11s %11s %10s %9s\n",
+            "model", "verts", "indices", "std (KB)", "packed (KB)", "std fetch", "pck fetch", "pos err", "nrm err");
+
+        for (const auto& path : paths) {
+            ImportedModel model;
+            if (!Object::importModel(path, model, false)) continue;
+
+            size_t vertexCount = 0, indexCount = 0;
+            size_t standardBytes = 0, packedBytes = 0;
+            double standardFetch = 0.0, packedFetch = 0.0;
+            float maxPositionError = 0.0f, maxNormalError = 0.0f;
+
+            for (const auto& mesh : model.meshes) {
+                vertexCount += mesh->vertices.size();
+                indexCount += mesh->indices.size();
+
+                size_t indexSize = mesh->vertices.size() <= 0xFFFF ? sizeof(uint16_t) : sizeof(unsigned int);
+                standardBytes += mesh->vertices.size() * sizeof(Mesh::Vertex) + mesh->indices.size() * sizeof(unsigned int);
+                packedBytes += mesh->vertices.size() * sizeof(PackedVertex) + mesh->indices.size() * indexSize;
+
+                // Vertices actually fetched by the post-transform cache misses of one draw
+                meshopt::CacheStats stats = meshopt::analyzeVertexCache(mesh->indices.data(), mesh->indices.size(), mesh->vertices.size());
+                standardFetch += double(stats.misses) * sizeof(Mesh::Vertex) + mesh->indices.size() * sizeof(unsigned int);
+                packedFetch += double(stats.misses) * sizeof(PackedVertex) + mesh->indices.size() * indexSize;
+
+                const glm::vec3 extent = mesh->getSize();
+                for (const auto& v : mesh->vertices) {
+                    PackedVertex p = packVertex(v.position, v.normal, v.texCoords, v.tangent, v.bitangent, mesh->minBounds, extent);
+
+                    glm::vec3 position = mesh->minBounds + glm::vec3(p.position[0], p.position[1], p.position[2]) / 65535.0f * extent;
+                    maxPositionError = glm::max(maxPositionError, glm::length(position - v.position));
+
+                    if (glm::dot(v.normal, v.normal) > 0.0f) {
+                        glm::vec3 normal = pack::octDecode(glm::vec2(p.normal[0], p.normal[1]) / 32767.0f);
+                        float cosine = glm::clamp(glm::dot(normal, glm::normalize(v.normal)), -1.0f, 1.0f);
+                        maxNormalError = glm::max(maxNormalError, glm::degrees(std::acos(cosine)));
+                    }
+                }
+            }
+
+            std::printf("%-32s %9zu %9zu %11.1f %11.1f %10.1fK %10.1fK %10.5f %7.3fdeg\n",
+                path.c_str(), vertexCount, indexCount,
+                standardBytes / 1024.0, packedBytes / 1024.0,
+                standardFetch / 1024.0, packedFetch / 1024.0,
+                maxPositionError, maxNormalError);
+        }
+    }
+
+    // ============ LOD ============
+    // LOD chain per model, then triangles submitted for N copies spread along the view direction,
+    // at the default and the two scoped FOVs of player::processInput
+    void printLods(const std::vector<std::string>& paths, float viewportHeight = 540.0f, float pixelError = 1.0f) {
+        std::printf("%-32s %5s %4s %10s %12s\n", "model", "mesh", "lod", "triangles", "error");
+
+        std::vector<std::shared_ptr<Mesh>> meshes;
+        for (const auto& path : paths) {
+            ImportedModel model;
+            if (!Object::importModel(path, model, false)) continue;
+
+            for (size_t i = 0; i < model.meshes.size(); i++) {
+                const auto& mesh = model.meshes[i];
+                for (size_t l = 0; l < mesh->lodCount(); l++) {
+                    Mesh::Lod lod = mesh->getLod(l);
+                    std::printf("%-32s %5zu %4zu %10u %12.6f\n", path.c_str(), i, l, lod.indexCount / 3, lod.error);
+                }
+                meshes.push_back(mesh);
+            }
+        }
+        if (meshes.empty()) return;
+
+        std::printf("\n%8s %6s %14s %14s %8s\n", "objects", "fov", "full tris", "lod tris", "ratio");
+        for (float fov : { 60.0f, 35.0f, 20.0f }) {
+            const float lodScale = viewportHeight / (2.0f * std::tan(glm::radians(fov) * 0.5f)) / pixelError;
+
+            for (size_t count : { 10, 100, 1000, 10000 }) {
+                size_t full = 0, selected = 0;
+                for (size_t n = 0; n < count; n++) {
+                    // 1 unit apart, starting 2 units in front of the eye
+                    float distance = 2.0f + float(n);
+                    for (const auto& mesh : meshes) {
+                        float radius = glm::length(mesh->getExtents());
+                        size_t lod = mesh->selectLod(glm::max(distance - radius, 0.0f), lodScale);
+                        full += mesh->indices.size() / 3;
+                        selected += mesh->getLod(lod).indexCount / 3;
+                    }
+                }
+                std::printf("%8zu %6.0f %14zu %14zu %7.3fx\n", count, fov, full, selected, full ? double(selected) / double(full) : 0.0);
+            }
+        }
+    }
+
+    // ============ MESHLET CULLING ============
+    // Triangles culled per frame by meshlet frustum and cone culling, orbiting each model at its
+    // bounding radius with the default and scoped FOVs of player::processInput
+    void printMeshletCulling(const std::vector<std::string>& paths, float aspect = 16.0f / 9.0f, int views = 16) {
+        std::printf("%-32s %5s %9s %10s %12s %12s %8s\n", "model", "fov", "meshlets", "triangles", "frustum", "cone", "culled");
+
+        for (const auto& path : paths) {
+            ImportedModel model;
+            if (!Object::importModel(path, model, false)) continue;
+
+            glm::vec3 minBounds(FLT_MAX), maxBounds(-FLT_MAX);
+            for (auto& mesh : model.meshes) {
+                if (mesh->meshlets.empty()) mesh->buildMeshlets();
+                minBounds = glm::min(minBounds, mesh->minBounds);
+                maxBounds = glm::max(maxBounds, mesh->maxBounds);
+            }
+            const glm::vec3 center = (minBounds + maxBounds) * 0.5f;
+            const float radius = glm::length(maxBounds - minBounds) * 0.5f;
+
+            std::vector<MeshletRange> ranges;
+            for (float fov : { 60.0f, 35.0f, 20.0f }) {
+                const glm::mat4 projection = glm::infinitePerspective(glm::radians(fov), aspect, 0.1f);
+
+                MeshletCullStats stats;
+                for (int v = 0; v < views; v++) {
+                    float angle = glm::two_pi<float>() * float(v) / float(views);
+                    glm::vec3 eye = center + glm::vec3(std::cos(angle), 0.3f, std::sin(angle)) * (radius * 1.5f);
+                    Frustum frustum = Frustum::fromMatrix(projection * glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f)));
+
+                    for (const auto& mesh : model.meshes) {
+                        ranges.clear();
+                        meshopt::cullMeshlets(ranges, mesh->meshlets.data(), mesh->meshlets.size(), glm::mat4(1.0f), &frustum, &eye, &stats);
+                    }
+                }
+
+                const double frames = double(views);
+                const size_t culled = stats.frustumCulled + stats.coneCulled;
+                std::printf("%-32s %5.0f %9.0f %10.0f %12.0f %12.0f %7.1f%%\n",
+                    path.c_str(), fov, stats.meshlets / frames, stats.triangles / frames,
+                    stats.frustumCulled / frames, stats.coneCulled / frames,
+                    stats.triangles ? 100.0 * double(culled) / double(stats.triangles) : 0.0);
+            }
+        }
+    }
+
+    // ============ ASSET REGISTRY ============
+    // copies Objects loading the same file: the first one imports and uploads, the rest share it
+    void printAssetRegistry(const std::string& path, int copies = 10) {
+        std::vector<std::shared_ptr<Object>> objects;
+        const size_t hitsBefore = getAssetRegistry().hits();
+
+        auto start = clock::now();
+        objects.push_back(std::make_shared<Object>(path));
+        objects.back()->loadModel(path);
+        const double firstMs = elapsedMs(start);
+
+        start = clock::now();
+        for (int i = 1; i < copies; i++) {
+            objects.push_back(std::make_shared<Object>(path));
+            objects.back()->loadModel(path);
+        }
+        const double restMs = elapsedMs(start);
+
+        size_t gpuBytes = 0;
+        for (const auto& mesh : objects.front()->meshes) gpuBytes += mesh->gpuBytes();
+
+        std::printf("%s x%d\n", path.c_str(), copies);
+        std::printf("first load:      %10.3f ms\n", firstMs);
+        std::printf("shared loads:    %10.3f ms each\n", copies > 1 ? restMs / (copies - 1) : 0.0);
+        std::printf("registry hits:   %10zu\n", getAssetRegistry().hits() - hitsBefore);
+        std::printf("GPU memory:      %10.1f KB (held once, %ld refs on the first mesh)\n",
+            gpuBytes / 1024.0, objects.front()->meshes.empty() ? 0L : long(objects.front()->meshes[0].use_count()));
+    }
+
+    // ============ GLB LOADING ============
+    // Parse + convert time and peak heap of Assimp vs the native GLB reader, then the zero-copy
+    // stream upload. Import-time optimisation is left out since it is the same for both parsers.
+    // Peak heap needs GL_COUNT_ALLOCATIONS.
+    void printGlbLoad(const std::vector<std::string>& paths, int iterations = 3) {
+        std::printf("%-32s %12s %12s %12s %12s %12s %12s\n",
+            "model", "assimp (ms)", "native (ms)", "stream (ms)", "assimp KB", "native KB", "stream KB");
+
+        for (const auto& path : paths) {
+            double assimpMs = 0.0, nativeMs = 0.0, streamMs = 0.0;
+            size_t assimpPeak = 0, nativePeak = 0, streamPeak = 0;
+
+            for (int i = 0; i < iterations; i++) {
+                resetPeak();
+                size_t base = allocatedBytes.load();
+                auto start = clock::now();
+                {
+                    Assimp::Importer importer;
+                    const aiScene* scene = importer.ReadFile(path, GL_MODEL_IMPORT_FLAGS);
+                    std::vector<std::shared_ptr<Mesh>> meshes;
+                    for (unsigned int m = 0; scene && m < scene->mNumMeshes; m++) meshes.push_back(Object::convertMesh(scene->mMeshes[m]));
+                }
+                assimpMs += elapsedMs(start);
+                assimpPeak = std::max(assimpPeak, peakBytes.load() - base);
+
+                resetPeak();
+                base = allocatedBytes.load();
+                start = clock::now();
+                {
+                    GlbFile file;
+                    std::vector<GlbPrimitive> primitives;
+                    std::vector<std::shared_ptr<Mesh>> meshes;
+                    if (file.open(path) && file.collectPrimitives(primitives)) {
+                        for (const auto& prim : primitives) meshes.push_back(Object::convertPrimitive(prim, GL_GLB_FLIP_V));
+                    }
+                }
+                nativeMs += elapsedMs(start);
+                nativePeak = std::max(nativePeak, peakBytes.load() - base);
+
+                resetPeak();
+                base = allocatedBytes.load();
+                start = clock::now();
+                {
+                    Object object;
+                    object.loadGlbStreams(path);
+                }
+                streamMs += elapsedMs(start);
+                streamPeak = std::max(streamPeak, peakBytes.load() - base);
+            }
+
+            std::printf("%-32s %12.2f %12.2f %12.2f %12.1f %12.1f %12.1f\n", path.c_str(),
+                assimpMs / iterations, nativeMs / iterations, streamMs / iterations,
+                assimpPeak / 1024.0, nativePeak / 1024.0, streamPeak / 1024.0);
+        }
+    }
+
+    // ============ TEXTURE DECODE ============
+    // Per-stage import timings with embedded textures (cache bypassed). convert and decode are summed over
+    // threads, stage is the wall time of the parallel stage they share; "parallel" is their ratio.
+    void printTextureDecode(const std::vector<std::string>& paths) {
+        std::printf("%-32s %9s %11s %10s %10s %8s %9s %7s %9s %11s\n",
+            "model", "parse", "convert", "decode", "stage", "parallel", "total", "images", "MB", "upload (ms)");
+
+        for (const auto& path : paths) {
+            ImportedModel model;
+            if (!Object::importModel(path, model, false)) continue;
+
+            Object object;
+            object.addModel(model);
+            const ImportTimings& t = object.importTimings;
+            std::printf("%-32s %9.2f %11.2f %10.2f %10.2f %7.2fx %9.2f %7zu %9.2f %11.2f\n", path.c_str(),
+                t.parseMs, t.convertMs, t.decodeMs, t.parallelMs,
+                t.parallelMs > 0.0 ? (t.convertMs + t.decodeMs) / t.parallelMs : 0.0,
+                t.totalMs, t.images, t.imageBytes / (1024.0 * 1024.0), t.uploadMs);
+        }
+    }
+
+    // Position of copy i in a cube of count copies in front of a camera looking down -z
+    inline glm::vec3 gridPosition(size_t i, size_t count) {
+        const int side = int(std::ceil(std::cbrt(double(count))));
+        return glm::vec3(float(i % side), float(i / side % side), -float(i / side / side)) * 3.0f - float(side);
+    }
+
+    // Camera looking down -z at a cube of count copies of path, which all share one asset
+    inline bool fillScene(Scene& scene, const std::string& path, size_t count, std::vector<std::shared_ptr<Object>>& objects) {
+        objects.clear();
+        for (size_t i = 0; i < count; i++) {
+            auto obj = scene.addObject(path);
+            obj->position = gridPosition(i, count);
+            if (!obj->loadModel(path)) return false;
+            objects.push_back(obj);
+        }
+        return true;
+    }
+
+    inline void setCamera(const camera& cam, const glm::mat4& projection) {
+        GLint viewport[4] = {};
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        getFrameUniforms().upload(FrameUniforms::fromCamera(cam, projection, float(viewport[2]), float(viewport[3])));
+    }
+
+    // ============ GEOMETRY POOL ============
+    // copies objects per model in one Scene: VAO binds saved by drawing from the shared pools, pool
+    // occupancy, and compaction after half the models are dropped
+    void printGeometryPool(const std::vector<std::string>& paths, const std::shared_ptr<shader>& program,
+        float viewportHeight, int copies = 16)
+    {
+        auto printPool = [](const char* label) {
+            auto st = getGeometryPool(VertexFormat::Standard).stats();
+            std::printf("%-20s %8zu blocks %10.2f MB used %10.2f MB capacity %6zu free ranges %4zu relocations\n", label,
+                st.blocks, (st.vertexBytes + st.indexBytes) / (1024.0 * 1024.0), st.capacityBytes / (1024.0 * 1024.0),
+                st.freeRanges, st.relocations);
+        };
+
+        camera cam(glm::vec3(0.0f, 0.0f, 30.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        setCamera(cam, glm::perspective(glm::radians(cam.getFov()), 16.0f / 9.0f, 0.1f, 1000.0f));
+        Scene scene("geometry pool");
+        size_t meshes = 0;
+        for (size_t p = 0; p < paths.size(); p++) {
+            for (int c = 0; c < copies; c++) {
+                auto obj = scene.addObject(paths[p] + "#" + std::to_string(c));
+                obj->shader = program;
+                obj->position = glm::vec3(float(c % 8) * 4.0f - 14.0f, float(p) * 4.0f - 10.0f, -float(c / 8) * 4.0f);
+                if (!obj->loadModel(paths[p])) break;
+                meshes += obj->meshes.size();
+            }
+        }
+        printPool("after load");
+
+        scene.render(cam, viewportHeight);
+        glFinish();
+        const BindStats& binds = scene.getBindStats();
+        std::printf("%zu objects, %zu mesh draws: %zu VAO binds, %zu saved (per-mesh VAOs: %zu binds, %zu buffer objects; pooled: 3)\n",
+            scene.getObjectCount(), binds.draws, binds.vaoBinds, binds.saved(), binds.draws, meshes * 3);
+
+        // Drop every other model so the pool is left with holes, then close them
+        for (size_t p = 0; p < paths.size(); p += 2) {
+            for (int c = 0; c < copies; c++) scene.removeObject(paths[p] + "#" + std::to_string(c));
+        }
+        getAssetRegistry().purge();
+        printPool("after release");
+
+        auto start = clock::now();
+        getGeometryPool(VertexFormat::Standard).compact();
+        glFinish();
+        const double compactMs = elapsedMs(start);
+        printPool("after compact");
+        std::printf("compaction took %.2f ms\n", compactMs);
+    }
+
+    // ============ MULTI-DRAW ============
+    // CPU time of Scene::render for growing copies of one model: one draw per mesh per object against
+    // batched multi-draw indirect, and the batched GL 3.3 fallback. Lower is better; the indirect column
+    // should stay nearly flat in draw calls as objects are added.
+    void printMultiDraw(const std::string& path, float viewportHeight, std::vector<size_t> counts = { 1000, 10000, 100000 }, int frames = 10) {
+        auto perObjectShader = std::make_shared<shader>("resource/shader/vert.glsl", "resource/shader/frag.glsl");
+        auto instancedShader = std::make_shared<shader>("resource/shader/vert_instanced.glsl", "resource/shader/frag.glsl");
+
+        camera cam(glm::vec3(0.0f, 0.0f, 60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        const glm::mat4 projection = glm::perspective(glm::radians(cam.getFov()), 16.0f / 9.0f, 0.1f, 1000.0f);
+        setCamera(cam, projection);
+
+        std::printf("%s, indirect %s\n", path.c_str(), MultiDrawQueue::indirectSupported() ? "supported" : "not supported");
+        std::printf("%9s %14s %10s %14s %10s %8s %14s %10s\n",
+            "objects", "per-obj (ms)", "calls", "indirect (ms)", "calls", "buckets", "fallback (ms)", "calls");
+
+        for (size_t count : counts) {
+            Scene scene("multi-draw");
+            std::vector<std::shared_ptr<Object>> objects;
+            if (!fillScene(scene, path, count, objects)) return;
+
+            auto measure = [&](const std::shared_ptr<shader>& program, bool batched, bool indirect) {
+                for (auto& obj : objects) obj->shader = program;
+                scene.setBatched(batched);
+                scene.getDrawQueue().useIndirect = indirect;
+                scene.render(cam, projection, viewportHeight); // warm up bucket storage
+                glFinish();
+
+                auto start = clock::now();
+                for (int f = 0; f < frames; f++) scene.render(cam, projection, viewportHeight);
+                const double ms = elapsedMs(start) / frames;
+                glFinish();
+                return ms;
+            };
+
+            const double perObjectMs = measure(perObjectShader, false, false);
+            const size_t perObjectCalls = scene.getBindStats().draws;
+            const double indirectMs = measure(instancedShader, true, true);
+            const MultiDrawStats indirect = scene.getDrawQueue().stats();
+            const double fallbackMs = measure(instancedShader, true, false);
+            const MultiDrawStats fallback = scene.getDrawQueue().stats();
+
+            std::printf("%9zu %14.3f %10zu %14.3f %10zu %8zu %14.3f %10zu\n", count,
+                perObjectMs, perObjectCalls, indirectMs, indirect.drawCalls, indirect.buckets, fallbackMs, fallback.drawCalls);
+        }
+    }
+
+    // ============ INSTANCING ============
+    // Frame time of count copies of one model: a draw and a model uniform per mesh per object, against
+    // Scene's automatic instancing. cpu is the submission time, frame includes glFinish.
+    void printInstancing(const std::string& path, float viewportHeight, std::vector<size_t> counts = { 10000, 50000, 100000 }, int frames = 10) {
+        auto perObjectShader = std::make_shared<shader>("resource/shader/vert.glsl", "resource/shader/frag.glsl");
+        auto instancedShader = std::make_shared<shader>("resource/shader/vert_instanced.glsl", "resource/shader/frag.glsl");
+
+        camera cam(glm::vec3(0.0f, 0.0f, 60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        const glm::mat4 projection = glm::perspective(glm::radians(cam.getFov()), 16.0f / 9.0f, 0.1f, 1000.0f);
+        setCamera(cam, projection);
+
+        std::printf("%s\n", path.c_str());
+        std::printf("%9s %12s %12s %10s %12s %12s %10s %10s\n",
+            "objects", "cpu (ms)", "frame (ms)", "draws", "inst cpu", "inst frame", "draws", "visible");
+
+        for (size_t count : counts) {
+            Scene scene("instancing");
+            std::vector<std::shared_ptr<Object>> objects;
+            if (!fillScene(scene, path, count, objects)) return;
+
+            double cpuMs = 0.0, frameMs = 0.0;
+            auto measure = [&](const std::shared_ptr<shader>& program, bool instancing) {
+                for (auto& obj : objects) obj->shader = program;
+                scene.setInstancing(instancing);
+                scene.render(cam, projection, viewportHeight);
+                glFinish();
+
+                cpuMs = frameMs = 0.0;
+                for (int f = 0; f < frames; f++) {
+                    auto start = clock::now();
+                    scene.render(cam, projection, viewportHeight);
+                    cpuMs += elapsedMs(start);
+                    glFinish();
+                    frameMs += elapsedMs(start);
+                }
+                cpuMs /= frames;
+                frameMs /= frames;
+            };
+
+            measure(perObjectShader, false);
+            const double perObjectCpu = cpuMs, perObjectFrame = frameMs;
+            const size_t perObjectDraws = scene.getBindStats().draws;
+            measure(instancedShader, true);
+            const InstanceStats& st = scene.getInstanceStats();
+
+            std::printf("%9zu %12.3f %12.3f %10zu %12.3f %12.3f %10zu %10zu\n", count,
+                perObjectCpu, perObjectFrame, perObjectDraws, cpuMs, frameMs, st.drawCalls, st.instances);
+        }
+    }
+
+    // ============ STREAM BUFFER ============
+    // Per-frame upload of instance-sized data: glBufferData orphaning every frame against StreamBuffer
+    // (persistent map where supported). Times are CPU per frame; waits count frames that stalled on a fence.
+    void printStreamBuffer(std::vector<size_t> sizes = { 64u << 10, 1u << 20, 4u << 20 }, int frames = 300) {
+        std::printf("persistent mapping %s\n", StreamBuffer::persistentSupported() ? "supported" : "not supported");
+        std::printf("%10s %16s %16s %16s %8s\n", "KB/frame", "orphan (ms)", "coherent (ms)", "explicit (ms)", "waits");
+
+        for (size_t size : sizes) {
+            std::vector<unsigned char> data(size, 0x5a);
+
+            GLuint buffer = 0;
+            glGenBuffers(1, &buffer);
+            getGLState().bindBuffer(GL_ARRAY_BUFFER, buffer);
+            auto start = clock::now();
+            for (int f = 0; f < frames; f++) {
+                glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+                glBufferSubData(GL_ARRAY_BUFFER, 0, size, data.data());
+            }
+            const double orphanMs = elapsedMs(start) / frames;
+            glFinish();
+            getGLState().deleteBuffers(1, &buffer);
+
+            auto streamed = [&](bool coherent, size_t& waits) {
+                StreamBuffer stream(GL_ARRAY_BUFFER, size, coherent);
+                auto begin = clock::now();
+                for (int f = 0; f < frames; f++) {
+                    stream.beginFrame();
+                    stream.write(data.data(), size);
+                }
+                const double ms = elapsedMs(begin) / frames;
+                glFinish();
+                waits += stream.stats().waits;
+                return ms;
+            };
+            size_t waits = 0;
+            const double coherentMs = streamed(true, waits);
+            const double explicitMs = streamed(false, waits);
+
+            std::printf("%10zu %16.4f %16.4f %16.4f %8zu\n", size >> 10, orphanMs, coherentMs, explicitMs, waits);
+        }
+    }
+
+    // ============ STATE CACHE ============
+    // GL state calls of one per-object Scene::render frame, as issued/skipped by the state cache.
+    // Objects share one model and program, so nearly every bind after the first object should be skipped.
+    void printStateCache(const std::string& path, float viewportHeight, std::vector<size_t> counts = { 1000, 10000 }) {
+        auto program = std::make_shared<shader>("resource/shader/vert.glsl", "resource/shader/frag.glsl");
+
+        camera cam(glm::vec3(0.0f, 0.0f, 60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        const glm::mat4 projection = glm::perspective(glm::radians(cam.getFov()), 16.0f / 9.0f, 0.1f, 1000.0f);
+        setCamera(cam, projection);
+
+        std::printf("%s\n", path.c_str());
+        std::printf("%9s %14s %14s %14s %14s %14s %14s\n",
+            "objects", "program", "vertex array", "buffer", "texture", "uniform", "fixed func");
+
+        for (size_t count : counts) {
+            Scene scene("state-cache");
+            std::vector<std::shared_ptr<Object>> objects;
+            if (!fillScene(scene, path, count, objects)) return;
+            for (auto& obj : objects) obj->shader = program;
+
+            scene.render(cam, projection, viewportHeight); // first frame sets sampler uniforms
+            scene.render(cam, projection, viewportHeight);
+            glFinish();
+
+            const StateStats& state = scene.getStateStats();
+            auto column = [](const StateCounter& c) {
+                char text[32];
+                std::snprintf(text, sizeof(text), "%zu/%zu", c.issued, c.skipped);
+                std::printf(" %14s", text);
+            };
+            std::printf("%9zu", count);
+            for (const StateCounter* c : { &state.program, &state.vertexArray, &state.buffer, &state.texture, &state.uniform, &state.fixedFunction }) column(*c);
+            std::printf("\n");
+            std::printf("%9s issued %zu, skipped %zu\n", "", state.issued(), state.skipped());
+        }
+    }
+
+    // ============ RENDER QUEUE ============
+    // Radix sort of random draw keys against std::sort, then a scene whose objects cycle through three
+    // programs and four materials, submitted in object order and sorted. Changes are program / material / VAO
+    // switches in submission order; GL is what the state cache let through.
+    void printRenderQueue(const std::string& path, float viewportHeight, std::vector<size_t> counts = { 1000, 10000 }, int frames = 10) {
+        std::printf("%9s %14s %14s\n", "keys", "radix (ms)", "std::sort (ms)");
+        for (size_t n : { size_t(10000), size_t(100000), size_t(1000000) }) {
+            std::vector<SortItem> keys(n), items, scratch;
+            uint64_t seed = 0x9e3779b97f4a7c15ull;
+            for (size_t i = 0; i < n; i++) {
+                seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+                keys[i] = { seed, uint32_t(i) };
+            }
+
+            items = keys;
+            auto start = clock::now();
+            radixSort(items, scratch);
+            const double radixMs = elapsedMs(start);
+
+            items = keys;
+            start = clock::now();
+            std::sort(items.begin(), items.end(), [](const SortItem& a, const SortItem& b) { return a.key < b.key; });
+            std::printf("%9zu %14.3f %14.3f\n", n, radixMs, elapsedMs(start));
+        }
+
+        std::shared_ptr<shader> programs[3] = {
+            std::make_shared<shader>("resource/shader/vert.glsl", "resource/shader/frag.glsl"),
+            std::make_shared<shader>("resource/shader/vert.glsl", "resource/shader/frag.glsl"),
+            std::make_shared<shader>("resource/shader/vert_instanced.glsl", "resource/shader/frag.glsl"),
+        };
+        GLuint materials[4] = {};
+        glGenTextures(4, materials);
+        for (GLuint i = 0; i < 4; i++) {
+            const unsigned char texel[4] = { static_cast<unsigned char>(64 * i), 128, 255, 255 };
+            getGLState().bindTexture(0, GL_TEXTURE_2D, materials[i]);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+        }
+
+        camera cam(glm::vec3(0.0f, 0.0f, 60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        const glm::mat4 projection = glm::perspective(glm::radians(cam.getFov()), 16.0f / 9.0f, 0.1f, 1000.0f);
+        setCamera(cam, projection);
+
+        std::printf("%s\n", path.c_str());
+        std::printf("%9s %8s %10s %22s %10s %10s\n", "objects", "order", "cpu (ms)", "changes (p/m/vao)", "GL calls", "sort (ms)");
+        for (size_t count : counts) {
+            Scene scene("render queue");
+            std::vector<std::shared_ptr<Object>> objects;
+            if (!fillScene(scene, path, count, objects)) break;
+            for (size_t i = 0; i < objects.size(); i++) {
+                objects[i]->shader = programs[i % 3];
+                objects[i]->textures = { { slot::BASE_COLOR, materials[i % 4] } };
+            }
+            scene.setSorted(true);
+
+            for (bool sort : { false, true }) {
+                scene.getRenderQueue().sortEnabled = sort;
+                scene.render(cam, projection, viewportHeight);
+                glFinish();
+
+                auto start = clock::now();
+                for (int f = 0; f < frames; f++) scene.render(cam, projection, viewportHeight);
+                const double ms = elapsedMs(start) / frames;
+                glFinish();
+
+                const RenderQueueStats& st = scene.getRenderQueue().stats();
+                const StateChanges& changes = sort ? st.sorted : st.unsorted;
+                char text[32];
+                std::snprintf(text, sizeof(text), "%zu/%zu/%zu", changes.program, changes.material, changes.vertexArray);
+                std::printf("%9zu %8s %10.3f %22s %10zu %10.3f\n", count, sort ? "sorted" : "objects", ms, text,
+                    scene.getStateStats().issued(), st.sortMs);
+            }
+        }
+        getGLState().deleteTextures(4, materials);
+    }
+
+    // ============ RENDER THREAD ============
+    // Frames of a scene whose objects all turn a little every frame (the simulation), drawn three ways:
+    // Scene::render on this thread, a CommandList recorded and executed on this thread, and the same list
+    // handed to a RenderThread so recording frame N overlaps executing frame N-1. Times are per frame,
+    // including glFinish at the end of the run.
+    void printRenderThread(const std::string& path, float viewportHeight, std::vector<size_t> counts = { 1000, 10000 }, int frames = 60) {
+        auto program = std::make_shared<shader>("resource/shader/vert.glsl", "resource/shader/frag.glsl");
+        GLFWwindow* context = glfwGetCurrentContext();
+
+        camera cam(glm::vec3(0.0f, 0.0f, 60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        const glm::mat4 projection = glm::perspective(glm::radians(cam.getFov()), 16.0f / 9.0f, 0.1f, 1000.0f);
+        GLint viewport[4] = {};
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        const FrameUniforms frameUniforms = FrameUniforms::fromCamera(cam, projection, float(viewport[2]), float(viewport[3]));
+
+        std::printf("%s\n", path.c_str());
+        std::printf("%9s %14s %14s %14s %14s\n", "objects", "direct (ms)", "list (ms)", "threaded (ms)", "sim wait (ms)");
+
+        for (size_t count : counts) {
+            Scene scene("render thread");
+            std::vector<std::shared_ptr<Object>> objects;
+            if (!fillScene(scene, path, count, objects)) return;
+            for (auto& obj : objects) obj->shader = program;
+            scene.setSorted(true);
+
+            const glm::quat spin = glm::angleAxis(0.01f, glm::vec3(0.0f, 1.0f, 0.0f));
+            auto simulate = [&]() {
+                for (auto& obj : objects) obj->rotation = spin * obj->rotation;
+            };
+
+            getFrameUniforms().upload(frameUniforms);
+            auto start = clock::now();
+            for (int f = 0; f < frames; f++) {
+                simulate();
+                scene.render(cam, projection, viewportHeight);
+            }
+            glFinish();
+            const double directMs = elapsedMs(start) / frames;
+
+            CommandList inlineList;
+            start = clock::now();
+            for (int f = 0; f < frames; f++) {
+                simulate();
+                inlineList.frame(frameUniforms);
+                scene.record(inlineList, cam, projection, viewportHeight);
+                RenderThread::execute(inlineList, context);
+                inlineList.reset();
+            }
+            glFinish();
+            const double listMs = elapsedMs(start) / frames;
+
+            RenderThread renderThread;
+            renderThread.start(context);
+            start = clock::now();
+            for (int f = 0; f < frames; f++) {
+                simulate();
+                CommandList& list = renderThread.begin();
+                list.frame(frameUniforms);
+                scene.record(list, cam, projection, viewportHeight);
+                if (f + 1 == frames) list.run([]() { glFinish(); });
+                renderThread.submit();
+            }
+            renderThread.stop();
+            const double threadedMs = elapsedMs(start) / frames;
+            glfwMakeContextCurrent(context);
+
+            std::printf("%9zu %14.3f %14.3f %14.3f %14.3f\n", count, directMs, listMs, threadedMs,
+                renderThread.stats().simulationWaitMs / frames);
+        }
+    }
+
+    // ============ DEPTH PRE-PASS ============
+    // A grid of objects several deep along the view axis, drawn in object order, sorted front to back, and
+    // with the depth pre-pass. Overdraw is shaded samples per viewport pixel from occlusion queries; times
+    // are per frame including glFinish.
+    void printDepthPrepass(const std::string& path, float viewportHeight, std::vector<size_t> counts = { 1000, 10000 }, int frames = 10) {
+        auto program = std::make_shared<shader>("resource/shader/vert.glsl", "resource/shader/frag.glsl");
+
+        camera cam(glm::vec3(0.0f, 0.0f, 60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        const glm::mat4 projection = glm::perspective(glm::radians(cam.getFov()), 16.0f / 9.0f, 0.1f, 1000.0f);
+        setCamera(cam, projection);
+
+        std::printf("%s\n", path.c_str());
+        std::printf("%9s %9s %10s %10s %12s %12s\n", "objects", "mode", "frame (ms)", "overdraw", "depth/pixel", "depth draws");
+        for (size_t count : counts) {
+            Scene scene("depth prepass");
+            std::vector<std::shared_ptr<Object>> objects;
+            if (!fillScene(scene, path, count, objects)) return;
+            for (auto& obj : objects) obj->shader = program;
+            scene.setOverdrawCounting(true);
+
+            auto measure = [&](const char* mode, bool sorted, bool prepass) {
+                scene.setSorted(sorted);
+                scene.setDepthPrepass(prepass);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                scene.render(cam, projection, viewportHeight);
+                glFinish();
+
+                auto start = clock::now();
+                for (int f = 0; f < frames + GL_SAMPLE_COUNTER_LATENCY; f++) {
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    scene.render(cam, projection, viewportHeight);
+                }
+                glFinish();
+                const double ms = elapsedMs(start) / (frames + GL_SAMPLE_COUNTER_LATENCY);
+
+                const OverdrawStats st = scene.getOverdrawStats();
+                std::printf("%9zu %9s %10.3f %10.2f %12.2f %12zu\n", count, mode, ms, st.overdraw(),
+                    st.pixels ? double(st.depthSamples) / double(st.pixels) : 0.0, prepass ? scene.getRenderQueue().stats().depthDraws : size_t(0));
+            };
+            measure("objects", false, false);
+            measure("sorted", true, false);
+            measure("prepass", true, true);
+        }
+    }
+
+    // ============ OCCLUSION ============
+    // A grid of objects behind a large occluder (the same model scaled up), drawn without occlusion culling,
+    // with the CPU readback path and, where GL 4.3 compute is available, the GPU path. Frames include glFinish;
+    // the first GL_HIZ_FRAMES + 1 frames, before results arrive, are not timed.
+    void printOcclusion(const std::string& path, float viewportHeight, std::vector<size_t> counts = { 1000, 10000 }, int frames = 10) {
+        auto program = std::make_shared<shader>("resource/shader/vert.glsl", "resource/shader/frag.glsl");
+
+        camera cam(glm::vec3(0.0f, 0.0f, 60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        const glm::mat4 projection = glm::perspective(glm::radians(cam.getFov()), 16.0f / 9.0f, 0.1f, 1000.0f);
+        setCamera(cam, projection);
+
+        std::printf("%s\n", path.c_str());
+        std::printf("%9s %6s %10s %10s %10s\n", "objects", "mode", "frame (ms)", "tested", "occluded");
+        for (size_t count : counts) {
+            for (int mode = 0; mode < 3; mode++) {
+                Scene scene("occlusion");
+                std::vector<std::shared_ptr<Object>> objects;
+                if (!fillScene(scene, path, count, objects)) return;
+                for (auto& obj : objects) obj->shader = program;
+
+                auto wall = scene.addObject("occluder");
+                if (!wall->loadModel(path)) return;
+                wall->shader = program;
+                wall->position = glm::vec3(0.0f, 0.0f, 30.0f);
+                wall->scale = glm::vec3(20.0f);
+
+                scene.setOcclusionCulling(mode > 0);
+                scene.getOcclusionCuller().useCompute = mode == 2;
+
+                for (int f = 0; f < GL_HIZ_FRAMES + 1; f++) {
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    scene.render(cam, projection, viewportHeight);
+                    glFinish();
+                }
+                if (mode == 2 && !scene.getOcclusionCuller().computeSupported()) break;
+
+                auto start = clock::now();
+                for (int f = 0; f < frames; f++) {
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    scene.render(cam, projection, viewportHeight);
+                }
+                glFinish();
+                const double ms = elapsedMs(start) / frames;
+
+                const OcclusionStats& st = scene.getOcclusionStats();
+                std::printf("%9zu %6s %10.3f %10zu %10zu\n", count, mode == 0 ? "off" : mode == 1 ? "cpu" : "gpu", ms,
+                    st.tested, st.occluded);
+            }
+        }
+    }
+
+    // ============ FRUSTUM CULLING ============
+    // count random world-space boxes against a perspective frustum: Frustum::intersectsAabb over an array of
+    // boxes, then cullAabbs over the SoA arrays with each path this CPU has. Rate is boxes tested per second.
+    void printFrustumCulling(size_t count = 100000, int iterations = 200) {
+        struct Box { glm::vec3 minBounds, maxBounds; };
+        std::vector<Box> boxes(count);
+        AabbSoA soa;
+        uint64_t seed = 0x9e3779b97f4a7c15ull;
+        auto random = [&]() {
+            seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+            return float(seed >> 40) / float(1 << 24);
+        };
+        for (Box& box : boxes) {
+            const glm::vec3 center = glm::vec3(random(), random(), random()) * 1000.0f - 500.0f;
+            const glm::vec3 extent = glm::vec3(random(), random(), random()) * 4.0f + 0.1f;
+            box = { center - extent, center + extent };
+            soa.push_back(box.minBounds, box.maxBounds);
+        }
+
+        const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+        const Frustum frustum = Frustum::fromMatrix(projection * glm::lookAt(glm::vec3(0.0f), glm::vec3(1.0f, 0.2f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+
+        std::printf("%zu boxes\n", count);
+        std::printf("%-14s %10s %14s %10s\n", "path", "ms", "Mboxes/s", "visible");
+        auto report = [&](const char* name, double ms, size_t visible) {
+            std::printf("%-14s %10.4f %14.1f %10zu\n", name, ms, double(count) / (ms * 1000.0), visible);
+        };
+
+        std::vector<uint32_t> visible;
+        visible.reserve(count);
+        auto start = clock::now();
+        for (int it = 0; it < iterations; it++) {
+            visible.clear();
+            for (size_t i = 0; i < count; i++) {
+                if (frustum.intersectsAabb(boxes[i].minBounds, boxes[i].maxBounds)) visible.push_back(uint32_t(i));
+            }
+        }
+        report("AoS scalar", elapsedMs(start) / iterations, visible.size());
+
+        const CullPath best = bestCullPath();
+        const std::pair<CullPath, const char*> paths[] = { { CullPath::Scalar, "SoA scalar" }, { CullPath::SSE, "SoA SSE" }, { CullPath::AVX, "SoA AVX" } };
+        for (const auto& [path, name] : paths) {
+            if (path > best) break;
+            start = clock::now();
+            for (int it = 0; it < iterations; it++) {
+                visible.clear();
+                cullAabbs(frustum, soa, visible, path);
+            }
+            report(name, elapsedMs(start) / iterations, visible.size());
+        }
+    }
+
+    // ============ SPATIAL INDEX ============
+    // DynamicBvh against a linear scan of the same boxes: build, a frame of small moves, and per-query time of
+    // box, sphere, ray (nearest hit) and frustum queries. Both sides test the real boxes and must agree.
+    void printBvh(size_t count = 100000, int queries = 1000) {
+        struct Box { glm::vec3 minBounds, maxBounds; };
+        std::vector<Box> boxes(count);
+        uint64_t seed = 0x9e3779b97f4a7c15ull;
+        auto random = [&]() {
+            seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+            return float(seed >> 40) / float(1 << 24);
+        };
+        auto randomPoint = [&]() { return glm::vec3(random(), random(), random()) * 1000.0f - 500.0f; };
+        for (Box& box : boxes) {
+            const glm::vec3 extent = glm::vec3(random(), random(), random()) * 4.0f + 0.1f;
+            const glm::vec3 center = randomPoint();
+            box = { center - extent, center + extent };
+        }
+
+        DynamicBvh bvh;
+        std::vector<int32_t> proxies(count);
+        auto start = clock::now();
+        for (size_t i = 0; i < count; i++) proxies[i] = bvh.createProxy(boxes[i].minBounds, boxes[i].maxBounds, &boxes[i]);
+        const double buildMs = elapsedMs(start);
+
+        start = clock::now();
+        for (size_t i = 0; i < count; i++) {
+            const glm::vec3 step = (glm::vec3(random(), random(), random()) - 0.5f) * 0.3f;
+            boxes[i].minBounds += step;
+            boxes[i].maxBounds += step;
+            bvh.moveProxy(proxies[i], boxes[i].minBounds, boxes[i].maxBounds);
+        }
+        const double moveMs = elapsedMs(start);
+
+        std::printf("%zu boxes: build %.2f ms, move all %.2f ms (%zu reinserted), height %d, area ratio %.1f\n",
+            count, buildMs, moveMs, bvh.reinserts(), bvh.height(), bvh.areaRatio());
+        std::printf("%-10s %14s %14s %10s %10s\n", "query", "linear us", "bvh us", "speedup", "hits");
+
+        auto overlaps = [](const Box& box, const glm::vec3& minBounds, const glm::vec3& maxBounds) {
+            return glm::all(glm::lessThanEqual(box.minBounds, maxBounds)) && glm::all(glm::greaterThanEqual(box.maxBounds, minBounds));
+        };
+        auto inSphere = [](const Box& box, const glm::vec3& center, float radius) {
+            const glm::vec3 d = glm::clamp(center, box.minBounds, box.maxBounds) - center;
+            return glm::dot(d, d) <= radius * radius;
+        };
+        auto box = [&](int32_t proxy) { return *static_cast<const Box*>(bvh.getUserData(proxy)); };
+
+        // linear(q) and indexed(q) return a checksum of query q's result
+        auto compare = [&](const char* name, auto&& linear, auto&& indexed) {
+            size_t linearHits = 0, bvhHits = 0;
+            uint64_t seedBefore = seed;
+            auto start = clock::now();
+            for (int q = 0; q < queries; q++) linearHits += linear();
+            const double linearUs = elapsedMs(start) * 1000.0 / queries;
+            seed = seedBefore; // same queries again
+            start = clock::now();
+            for (int q = 0; q < queries; q++) bvhHits += indexed();
+            const double bvhUs = elapsedMs(start) * 1000.0 / queries;
+            std::printf("%-10s %14.2f %14.2f %9.1fx %10zu%s\n", name, linearUs, bvhUs, linearUs / bvhUs, bvhHits,
+                linearHits == bvhHits ? "" : "  MISMATCH");
+        };
+
+        compare("box", [&]() {
+            const glm::vec3 c = randomPoint(), e(20.0f);
+            size_t hits = 0;
+            for (const Box& b : boxes) hits += overlaps(b, c - e, c + e);
+            return hits;
+        }, [&]() {
+            const glm::vec3 c = randomPoint(), e(20.0f);
+            size_t hits = 0;
+            bvh.queryAabb(c - e, c + e, [&](int32_t proxy) { hits += overlaps(box(proxy), c - e, c + e); return true; });
+            return hits;
+        });
+
+        compare("sphere", [&]() {
+            const glm::vec3 c = randomPoint();
+            size_t hits = 0;
+            for (const Box& b : boxes) hits += inSphere(b, c, 25.0f);
+            return hits;
+        }, [&]() {
+            const glm::vec3 c = randomPoint();
+            size_t hits = 0;
+            bvh.querySphere(c, 25.0f, [&](int32_t proxy) { hits += inSphere(box(proxy), c, 25.0f); return true; });
+            return hits;
+        });
+
+        // Checksum: index of the nearest box hit, + 1
+        compare("ray", [&]() {
+            const glm::vec3 origin = randomPoint(), inverse = 1.0f / glm::normalize(randomPoint());
+            float nearest = 2000.0f, t;
+            size_t hit = 0;
+            for (size_t i = 0; i < count; i++) {
+                if (rayAabb(origin, inverse, boxes[i].minBounds, boxes[i].maxBounds, nearest, t) && t < nearest) {
+                    nearest = t;
+                    hit = i + 1;
+                }
+            }
+            return hit;
+        }, [&]() {
+            const glm::vec3 origin = randomPoint(), inverse = 1.0f / glm::normalize(randomPoint());
+            float nearest = 2000.0f, t;
+            size_t hit = 0;
+            bvh.raycast(origin, 1.0f / inverse, nearest, [&](int32_t proxy) {
+                const Box& b = *static_cast<const Box*>(bvh.getUserData(proxy));
+                if (rayAabb(origin, inverse, b.minBounds, b.maxBounds, nearest, t) && t < nearest) {
+                    nearest = t;
+                    hit = size_t(&b - boxes.data()) + 1;
+                }
+                return nearest;
+            });
+            return hit;
+        });
+
+        const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 150.0f);
+        auto randomFrustum = [&]() {
+            const glm::vec3 eye = randomPoint();
+            return Frustum::fromMatrix(projection * glm::lookAt(eye, eye + randomPoint(), glm::vec3(0.0f, 1.0f, 0.0f)));
+        };
+        compare("frustum", [&]() {
+            const Frustum frustum = randomFrustum();
+            size_t hits = 0;
+            for (const Box& b : boxes) hits += frustum.intersectsAabb(b.minBounds, b.maxBounds);
+            return hits;
+        }, [&]() {
+            const Frustum frustum = randomFrustum();
+            size_t hits = 0;
+            bvh.queryFrustum(frustum, [&](int32_t proxy) { hits += frustum.intersectsAabb(box(proxy).minBounds, box(proxy).maxBounds); return true; });
+            return hits;
+        });
+    }
+
+    // ============ SCENE LOOKUP ============
+    // Scene object lookup by linear name scan, hashed name index and handle, and remove + re-add churn with
+    // and without the name index
+    void printSceneLookup(size_t count = 100000, size_t lookups = 10000) {
+        Scene scene("lookup");
+        std::vector<std::string> names(count);
+        std::vector<SlotHandle> handles(count);
+        for (size_t i = 0; i < count; i++) {
+            names[i] = "object#" + std::to_string(i);
+            handles[i] = scene.addObject(names[i])->handle;
+        }
+
+        uint64_t seed = 0x9e3779b97f4a7c15ull;
+        auto random = [&]() {
+            seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+            return size_t(seed % count);
+        };
+
+        std::printf("%zu objects\n", count);
+        std::printf("%-24s %12s\n", "operation", "ns/op");
+        auto report = [&](const char* name, double ms, size_t ops) { std::printf("%-24s %12.1f\n", name, ms * 1e6 / double(ops)); };
+
+        size_t found = 0;
+        auto start = clock::now();
+        for (size_t i = 0; i < lookups / 100; i++) found += scene.findHandle(names[random()]) ? 1 : 0;
+        report("findHandle, scan", elapsedMs(start), lookups / 100);
+
+        scene.setNameIndex(true);
+        start = clock::now();
+        for (size_t i = 0; i < lookups; i++) found += scene.findHandle(names[random()]) ? 1 : 0;
+        report("findHandle, indexed", elapsedMs(start), lookups);
+
+        start = clock::now();
+        for (size_t i = 0; i < lookups; i++) found += scene.getObject(handles[random()]) ? 1 : 0;
+        report("getObject(handle)", elapsedMs(start), lookups);
+
+        for (bool indexed : { false, true }) {
+            scene.setNameIndex(indexed);
+            const size_t churn = indexed ? lookups : lookups / 100;
+            start = clock::now();
+            for (size_t i = 0; i < churn; i++) {
+                const size_t victim = random();
+                scene.removeObject(names[victim]);
+                handles[victim] = scene.addObject(names[victim])->handle;
+            }
+            report(indexed ? "remove + add, indexed" : "remove + add, scan", elapsedMs(start), churn);
+        }
+
+        // A removed object's handle must not reach whatever reuses its slot
+        const SlotHandle stale = handles[0];
+        scene.removeObject(stale);
+        handles[0] = scene.addObject(names[0])->handle;
+        std::printf("stale handle %s, %zu found\n", scene.getObject(stale) ? "RESOLVED" : "rejected", found);
+    }
+
+    // ============ ENTITIES ============
+    // count copies of path as instanced Objects and as Scene entities, all moved every frame: update (the
+    // move plus Scene::update, which for Objects includes the spatial index refit), render() CPU time and
+    // frame time to glFinish
+    void printEntities(const std::string& path, float viewportHeight, size_t count = 100000, int frames = 10) {
+        auto instancedShader = std::make_shared<shader>("resource/shader/vert_instanced.glsl", "resource/shader/frag.glsl");
+
+        camera cam(glm::vec3(0.0f, 0.0f, 60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        const glm::mat4 projection = glm::perspective(glm::radians(cam.getFov()), 16.0f / 9.0f, 0.1f, 1000.0f);
+        setCamera(cam, projection);
+
+        std::printf("%s, %zu copies\n", path.c_str(), count);
+        std::printf("%-10s %12s %12s %12s %10s %10s\n", "layout", "update (ms)", "cpu (ms)", "frame (ms)", "draws", "visible");
+
+        // move(f) changes every transform for frame f; stats() returns { draw calls, visible }
+        auto measure = [&](const char* name, Scene& scene, auto&& move, auto&& stats) {
+            scene.update(0.0f);
+            scene.render(cam, projection, viewportHeight);
+            glFinish();
+
+            double updateMs = 0.0, cpuMs = 0.0, frameMs = 0.0;
+            for (int f = 0; f < frames; f++) {
+                auto start = clock::now();
+                move(f);
+                scene.update(1.0f / 60.0f);
+                updateMs += elapsedMs(start);
+
+                start = clock::now();
+                scene.render(cam, projection, viewportHeight);
+                cpuMs += elapsedMs(start);
+                glFinish();
+                frameMs += elapsedMs(start);
+            }
+            const auto [draws, visible] = stats();
+            std::printf("%-10s %12.3f %12.3f %12.3f %10zu %10zu\n", name, updateMs / frames, cpuMs / frames, frameMs / frames, draws, visible);
+        };
+        auto step = [](int f) { return (f & 1) ? 0.01f : -0.01f; };
+
+        {
+            Scene scene("objects");
+            std::vector<std::shared_ptr<Object>> objects;
+            if (!fillScene(scene, path, count, objects)) return;
+            for (auto& obj : objects) obj->shader = instancedShader;
+            scene.setInstancing(true);
+            measure("objects", scene, [&](int f) {
+                for (auto& obj : objects) obj->position.y += step(f);
+            }, [&]() {
+                return std::pair<size_t, size_t>(scene.getInstanceStats().drawCalls, scene.getInstanceStats().instances);
+            });
+        }
+
+        {
+            Scene scene("entities");
+            Object prototype(path);
+            prototype.shader = instancedShader;
+            if (!prototype.loadModel(path)) return;
+            for (size_t i = 0; i < count; i++) {
+                prototype.position = gridPosition(i, count);
+                scene.addEntity(prototype);
+            }
+            measure("entities", scene, [&](int f) {
+                const float dy = step(f);
+                scene.getEntities().parallelEach<Transform>([dy](Entity, Transform& transform) { transform.position.y += dy; });
+            }, [&]() {
+                const EntityStats& st = scene.getEntityStats();
+                return std::pair<size_t, size_t>(st.drawCalls, st.entities - st.culled);
+            });
+        }
+    }
+
+    // ============ TRANSFORM HIERARCHY ============
+    // roots trees of depth 4 and fan-out 4 (85 nodes each). Rebuilding every world matrix from translate,
+    // rotate and scale each frame, as getModelMatrix does, against TransformHierarchy::update with a share
+    // of the nodes (picked at random, so subtrees overlap) changed since the last frame
+    void printTransformHierarchy(size_t roots = 1200, int frames = 20) {
+        struct Local { glm::vec3 position; glm::quat rotation; glm::vec3 scale; uint32_t parent; };
+        std::vector<Local> locals; // parents before children
+        std::vector<SlotHandle> nodes;
+        TransformHierarchy hierarchy;
+
+        uint64_t seed = 0x9e3779b97f4a7c15ull;
+        auto random = [&]() {
+            seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+            return float(seed >> 40) / float(1 << 24);
+        };
+        auto add = [&](uint32_t parent) {
+            const Local local{ glm::vec3(random(), random(), random()) * 4.0f - 2.0f,
+                glm::angleAxis(random() * 6.2831853f, glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(1.0f), parent };
+            nodes.push_back(hierarchy.create(parent == UINT32_MAX ? SlotHandle() : nodes[parent]));
+            hierarchy.setLocal(nodes.back(), local.position, local.rotation, local.scale);
+            locals.push_back(local);
+            return uint32_t(locals.size() - 1);
+        };
+        std::vector<uint32_t> level, next;
+        for (size_t r = 0; r < roots; r++) level.push_back(add(UINT32_MAX));
+        for (int depth = 1; depth < 4; depth++) {
+            next.clear();
+            for (uint32_t parent : level) {
+                for (int c = 0; c < 4; c++) next.push_back(add(parent));
+            }
+            std::swap(level, next);
+        }
+        hierarchy.update();
+
+        std::vector<glm::mat4> world(locals.size());
+        auto start = clock::now();
+        for (int f = 0; f < frames; f++) {
+            for (size_t i = 0; i < locals.size(); i++) {
+                const Local& l = locals[i];
+                glm::mat4 model = glm::translate(glm::mat4(1.0f), l.position) * glm::mat4_cast(l.rotation);
+                model = glm::scale(model, l.scale);
+                world[i] = l.parent == UINT32_MAX ? model : world[l.parent] * model;
+            }
+        }
+        const double fullMs = elapsedMs(start) / frames;
+
+        std::printf("%zu nodes in %zu trees\n", locals.size(), roots);
+        std::printf("%-22s %10s %12s %8s\n", "", "ms", "recomputed", "levels");
+        std::printf("%-22s %10.3f %12zu %8s\n", "rebuild all", fullMs, locals.size(), "-");
+
+        for (float share : { 0.001f, 0.01f, 0.1f, 1.0f }) {
+            const size_t changed = std::max<size_t>(1, size_t(share * float(locals.size())));
+            double ms = 0.0;
+            size_t recomputed = 0;
+            for (int f = 0; f < frames; f++) {
+                const float dy = (f & 1) ? 0.01f : -0.01f;
+                start = clock::now();
+                for (size_t k = 0; k < changed; k++) {
+                    const size_t i = share >= 1.0f ? k : size_t(random() * float(locals.size())) % locals.size();
+                    locals[i].position.y += dy;
+                    hierarchy.setPosition(nodes[i], locals[i].position);
+                }
+                hierarchy.update();
+                ms += elapsedMs(start);
+                recomputed += hierarchy.stats().recomputed;
+            }
+            char label[32];
+            std::snprintf(label, sizeof(label), "update, %g%% changed", share * 100.0f);
+            std::printf("%-22s %10.3f %12zu %8zu\n", label, ms / frames, recomputed / frames, hierarchy.stats().levels);
+        }
+    }
+
+    // ============ ALLOCATIONS ============
+    // Checks that Object::convertMesh (the construction path) costs one heap allocation per non-empty stream
+    // (vertices, indices) plus the make_shared block, and prints what Mesh::prepare() allocates on top.
+    // Needs a build that counts allocations (build.ps1 -CountAllocations); false if it does not, or if any
+    // mesh allocates a different number of times.
+    bool checkMeshAllocations(const std::vector<std::string>& paths) {
+#ifndef GL_COUNT_ALLOCATIONS
+        std::cerr << "alloc check: build with GL_COUNT_ALLOCATIONS defined (build.ps1 -CountAllocations)" << std::endl;
+        return false;
+#else
+        std::printf("%-32s %7s %12s %12s %14s\n", "model", "meshes", "build/mesh", "mismatched", "prepare/mesh");
+
+        bool passed = true;
+        size_t checked = 0;
+        for (const auto& path : paths) {
+            Assimp::Importer importer;
+            const aiScene* scene = importer.ReadFile(path, GL_MODEL_IMPORT_FLAGS);
+            if (!scene || !scene->mNumMeshes) {
+                std::cerr << "alloc check: cannot import " << path << std::endl;
+                passed = false;
+                continue;
+            }
+
+            size_t buildTotal = 0, optimizeTotal = 0, mismatched = 0;
+            for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+                const aiMesh* source = scene->mMeshes[i];
+                size_t indexCount = 0;
+                for (unsigned int f = 0; f < source->mNumFaces; f++) indexCount += source->mFaces[f].mNumIndices;
+                const size_t expected = (source->mNumVertices ? 1 : 0) + (indexCount ? 1 : 0) + 1;
+
+                size_t before = threadAllocations;
+                std::shared_ptr<Mesh> mesh = Object::convertMesh(source);
+                const size_t build = threadAllocations - before;
+                if (build != expected) {
+                    std::cerr << "alloc check: " << path << " mesh " << i << ": " << build
+                        << " allocations, expected " << expected << std::endl;
+                    mismatched++;
+                }
+
+                before = threadAllocations;
+                mesh->prepare();
+                optimizeTotal += threadAllocations - before;
+                buildTotal += build;
+                checked++;
+            }
+
+            const double meshes = double(scene->mNumMeshes);
+            std::printf("%-32s %7u %12.2f %12zu %14.1f\n",
+                path.c_str(), scene->mNumMeshes, buildTotal / meshes, mismatched, optimizeTotal / meshes);
+            if (mismatched) passed = false;
+        }
+
+        if (!checked) passed = false;
+        std::printf("alloc check: %s\n", passed ? "passed" : "FAILED");
+        return passed;
+#endif
+    }
+
+} // namespace gl::bench
@@ -0,0 +1,359 @@
+#pragma once
+
+#include <glm.hpp>
+
+#include <Culling.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace gl {
+
+    // Slab test of origin + t * direction, t in [0, maxDistance], against a box; enter is the first t inside.
+    // inverseDirection = 1 / direction, with infinities for zero components.
+    inline bool rayAabb(const glm::vec3& origin, const glm::vec3& inverseDirection, const glm::vec3& minBounds, const glm::vec3& maxBounds,
+                        float maxDistance, float& enter) {
+        const glm::vec3 t0 = (minBounds - origin) * inverseDirection;
+        const glm::vec3 t1 = (maxBounds - origin) * inverseDirection;
+        const glm::vec3 tMin = glm::min(t0, t1), tMax = glm::max(t0, t1);
+        enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+        const float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, maxDistance));
+        return enter <= exit;
+    }
+
+    // ============ DYNAMIC BVH ============
+    // Incrementally updated AABB tree over moving boxes (after Box2D's b2DynamicTree). Each proxy is a leaf
+    // holding a fat box, the real box grown by margin, so small moves leave the tree alone; a leaf is
+    // reinserted only once its box leaves the fat one. Insertion descends by surface area heuristic (the
+    // cheapest sibling by added area), and every node on the way back up is rebalanced with a tree rotation
+    // when its children's heights differ by more than one, keeping queries O(log n).
+    //
+    // Queries report proxies whose fat box passes the test, so results can include boxes up to margin away;
+    // callers refine with the real bounds where that matters. Not thread-safe for concurrent updates.
+    class DynamicBvh {
+    public:
+        static constexpr int32_t NONE = -1;
+
+        struct Node {
+            glm::vec3 minBounds = glm::vec3(0.0f); // fat for leaves
+            glm::vec3 maxBounds = glm::vec3(0.0f);
+            int32_t parent = NONE;                 // next free node while on the free list
+            int32_t child1 = NONE;                 // NONE for leaves
+            int32_t child2 = NONE;
+            int32_t height = -1;                   // 0 for leaves, -1 when free
+            void* userData = nullptr;
+
+            bool isLeaf() const { return child1 == NONE; }
+        };
+
+    private:
+        std::vector<Node> m_Nodes;
+        int32_t m_Root = NONE;
+        int32_t m_FreeList = NONE;
+        size_t m_ProxyCount = 0;
+        size_t m_Reinserts = 0;
+
+        // Half the surface area; only compared
+        static float area(const glm::vec3& minBounds, const glm::vec3& maxBounds) {
+            const glm::vec3 d = maxBounds - minBounds;
+            return d.x * d.y + d.y * d.z + d.z * d.x;
+        }
+
+        static float unionArea(const Node& a, const Node& b) {
+            return area(glm::min(a.minBounds, b.minBounds), glm::max(a.maxBounds, b.maxBounds));
+        }
+
+        void setUnion(Node& node, const Node& a, const Node& b) {
+            node.minBounds = glm::min(a.minBounds, b.minBounds);
+            node.maxBounds = glm::max(a.maxBounds, b.maxBounds);
+        }
+
+        int32_t allocateNode() {
+            if (m_FreeList == NONE) {
+                m_Nodes.emplace_back();
+                return static_cast<int32_t>(m_Nodes.size() - 1);
+            }
+            const int32_t index = m_FreeList;
+            m_FreeList = m_Nodes[index].parent;
+            m_Nodes[index] = Node();
+            return index;
+        }
+
+        void freeNode(int32_t index) {
+            m_Nodes[index] = Node();
+            m_Nodes[index].parent = m_FreeList;
+            m_FreeList = index;
+        }
+
+        // Point the parent of oldChild (or the root) at newChild
+        void replaceChild(int32_t parent, int32_t oldChild, int32_t newChild) {
+            if (parent == NONE) m_Root = newChild;
+            else if (m_Nodes[parent].child1 == oldChild) m_Nodes[parent].child1 = newChild;
+            else m_Nodes[parent].child2 = newChild;
+        }
+
+        // Rotate the taller grandchild up if index's subtrees differ in height by more than one.
+        // Returns the node now at index's position.
+        int32_t balance(int32_t iA) {
+            Node& A = m_Nodes[iA];
+            if (A.isLeaf() || A.height < 2) return iA;
+
+            const int32_t iB = A.child1, iC = A.child2;
+            Node& B = m_Nodes[iB];
+            Node& C = m_Nodes[iC];
+            const int32_t difference = C.height - B.height;
+
+            if (difference > 1) { // C up
+                const int32_t iF = C.child1, iG = C.child2;
+                Node& F = m_Nodes[iF];
+                Node& G = m_Nodes[iG];
+
+                C.child1 = iA;
+                C.parent = A.parent;
+                A.parent = iC;
+                replaceChild(C.parent, iA, iC);
+
+                const bool keepF = F.height > G.height;
+                const int32_t iUp = keepF ? iF : iG, iDown = keepF ? iG : iF;
+                Node& down = m_Nodes[iDown];
+                C.child2 = iUp;
+                A.child2 = iDown;
+                down.parent = iA;
+                setUnion(A, B, down);
+                setUnion(C, A, m_Nodes[iUp]);
+                A.height = 1 + std::max(B.height, down.height);
+                C.height = 1 + std::max(A.height, m_Nodes[iUp].height);
+                return iC;
+            }
+
+            if (difference < -1) { // B up
+                const int32_t iD = B.child1, iE = B.child2;
+                Node& D = m_Nodes[iD];
+                Node& E = m_Nodes[iE];
+
+                B.child1 = iA;
+                B.parent = A.parent;
+                A.parent = iB;
+                replaceChild(B.parent, iA, iB);
+
+                const bool keepD = D.height > E.height;
+                const int32_t iUp = keepD ? iD : iE, iDown = keepD ? iE : iD;
+                Node& down = m_Nodes[iDown];
+                B.child2 = iUp;
+                A.child1 = iDown;
+                down.parent = iA;
+                setUnion(A, C, down);
+                setUnion(B, A, m_Nodes[iUp]);
+                A.height = 1 + std::max(C.height, down.height);
+                B.height = 1 + std::max(A.height, m_Nodes[iUp].height);
+                return iB;
+            }
+            return iA;
+        }
+
+        // Rebalance and refit from index to the root
+        void refit(int32_t index) {
+            while (index != NONE) {
+                index = balance(index);
+                Node& node = m_Nodes[index];
+                const Node& child1 = m_Nodes[node.child1];
+                const Node& child2 = m_Nodes[node.child2];
+                node.height = 1 + std::max(child1.height, child2.height);
+                setUnion(node, child1, child2);
+                index = node.parent;
+            }
+        }
+
+        void insertLeaf(int32_t leaf) {
+            if (m_Root == NONE) {
+                m_Root = leaf;
+                m_Nodes[leaf].parent = NONE;
+                return;
+            }
+
+            // Descend to the sibling that adds the least area: stop where pairing with the whole subtree is
+            // cheaper than the lower bound for going into either child
+            const Node leafNode = m_Nodes[leaf];
+            int32_t index = m_Root;
+            while (!m_Nodes[index].isLeaf()) {
+                const Node& node = m_Nodes[index];
+                const float nodeArea = area(node.minBounds, node.maxBounds);
+                const float combinedArea = unionArea(node, leafNode);
+                const float cost = 2.0f * combinedArea;
+                const float inheritance = 2.0f * (combinedArea - nodeArea);
+
+                auto descendCost = [&](int32_t child) {
+                    const Node& c = m_Nodes[child];
+                    const float combined = unionArea(c, leafNode);
+                    return (c.isLeaf() ? combined : combined - area(c.minBounds, c.maxBounds)) + inheritance;
+                };
+                const float cost1 = descendCost(node.child1);
+                const float cost2 = descendCost(node.child2);
+                if (cost < cost1 && cost < cost2) break;
+                index = cost1 < cost2 ? node.child1 : node.child2;
+            }
+
+            const int32_t sibling = index;
+            const int32_t oldParent = m_Nodes[sibling].parent;
+            const int32_t newParent = allocateNode(); // may reallocate m_Nodes
+            Node& parent = m_Nodes[newParent];
+            parent.parent = oldParent;
+            parent.child1 = sibling;
+            parent.child2 = leaf;
+            parent.height = m_Nodes[sibling].height + 1;
+            setUnion(parent, m_Nodes[sibling], m_Nodes[leaf]);
+            replaceChild(oldParent, sibling, newParent);
+            m_Nodes[sibling].parent = newParent;
+            m_Nodes[leaf].parent = newParent;
+
+            refit(oldParent);
+        }
+
+        void removeLeaf(int32_t leaf) {
+            if (leaf == m_Root) {
+                m_Root = NONE;
+                return;
+            }
+            const int32_t parent = m_Nodes[leaf].parent;
+            const int32_t grandParent = m_Nodes[parent].parent;
+            const int32_t sibling = m_Nodes[parent].child1 == leaf ? m_Nodes[parent].child2 : m_Nodes[parent].child1;
+
+            replaceChild(grandParent, parent, sibling);
+            m_Nodes[sibling].parent = grandParent;
+            freeNode(parent);
+            refit(grandParent);
+        }
+
+        // Visit nodes depth first; test(node) returns 0 to skip the subtree, 1 to descend and 2 when the whole
+        // subtree passes. visit(proxy) returns false to stop.
+        template <typename Test, typename Visit>
+        void traverse(Test&& test, Visit&& visit) const {
+            if (m_Root == NONE) return;
+            thread_local std::vector<std::pair<int32_t, bool>> stack; // (node, already known to pass)
+            const size_t base = stack.size(); // queries may nest from inside visit
+            stack.push_back({ m_Root, false });
+            while (stack.size() > base) {
+                const auto [index, passed] = stack.back();
+                stack.pop_back();
+                const Node& node = m_Nodes[index];
+
+                int result = 2;
+                if (!passed && (result = test(node)) == 0) continue;
+                if (node.isLeaf()) {
+                    if (!visit(index)) {
+                        stack.resize(base);
+                        return;
+                    }
+                    continue;
+                }
+                stack.push_back({ node.child2, result == 2 });
+                stack.push_back({ node.child1, result == 2 });
+            }
+        }
+
+    public:
+        float margin = 0.1f; // fat box growth on every side, world units
+
+        // Add a box; returns the proxy id
+        int32_t createProxy(const glm::vec3& minBounds, const glm::vec3& maxBounds, void* userData) {
+            const int32_t proxy = allocateNode();
+            Node& node = m_Nodes[proxy];
+            node.minBounds = minBounds - margin;
+            node.maxBounds = maxBounds + margin;
+            node.height = 0;
+            node.userData = userData;
+            insertLeaf(proxy);
+            m_ProxyCount++;
+            return proxy;
+        }
+
+        void destroyProxy(int32_t proxy) {
+            removeLeaf(proxy);
+            freeNode(proxy);
+            m_ProxyCount--;
+        }
+
+        // New real bounds of a proxy; reinserts it only when they leave its fat box. Returns whether it did.
+        bool moveProxy(int32_t proxy, const glm::vec3& minBounds, const glm::vec3& maxBounds) {
+            const Node& node = m_Nodes[proxy];
+            if (glm::all(glm::greaterThanEqual(minBounds, node.minBounds)) && glm::all(glm::lessThanEqual(maxBounds, node.maxBounds)))
+                return false;
+
+            removeLeaf(proxy);
+            m_Nodes[proxy].minBounds = minBounds - margin;
+            m_Nodes[proxy].maxBounds = maxBounds + margin;
+            insertLeaf(proxy);
+            m_Reinserts++;
+            return true;
+        }
+
+        void* getUserData(int32_t proxy) const { return m_Nodes[proxy].userData; }
+        const Node& getNode(int32_t proxy) const { return m_Nodes[proxy]; }
+
+        // Proxies whose fat box overlaps [minBounds, maxBounds]
+        template <typename Visit>
+        void queryAabb(const glm::vec3& minBounds, const glm::vec3& maxBounds, Visit&& visit) const {
+            traverse([&](const Node& node) {
+                return glm::all(glm::lessThanEqual(node.minBounds, maxBounds)) && glm::all(glm::greaterThanEqual(node.maxBounds, minBounds)) ? 1 : 0;
+            }, visit);
+        }
+
+        template <typename Visit>
+        void querySphere(const glm::vec3& center, float radius, Visit&& visit) const {
+            traverse([&](const Node& node) {
+                const glm::vec3 closest = glm::clamp(center, node.minBounds, node.maxBounds);
+                const glm::vec3 d = closest - center;
+                return glm::dot(d, d) <= radius * radius ? 1 : 0;
+            }, visit);
+        }
+
+        // Subtrees entirely inside the frustum are reported without further plane tests
+        template <typename Visit>
+        void queryFrustum(const Frustum& frustum, Visit&& visit) const {
+            traverse([&](const Node& node) {
+                int result = 2;
+                for (const glm::vec4& plane : frustum.planes) {
+                    const glm::vec3 n(plane);
+                    const glm::vec3 far = glm::mix(node.minBounds, node.maxBounds, glm::vec3(glm::greaterThanEqual(n, glm::vec3(0.0f))));
+                    const glm::vec3 near = node.minBounds + node.maxBounds - far;
+                    if (glm::dot(n, far) + plane.w < 0.0f) return 0;
+                    if (glm::dot(n, near) + plane.w < 0.0f) result = 1;
+                }
+                return result;
+            }, visit);
+        }
+
+        // Proxies whose fat box the ray origin + t * direction, t in [0, maxDistance], passes through, in no
+        // particular order. visit(proxy) returns the t to clip the ray to, e.g. of a hit found on that proxy,
+        // or maxDistance or more to go on unclipped; 0 stops.
+        template <typename Visit>
+        void raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, Visit&& visit) const {
+            const glm::vec3 inverse = 1.0f / direction;
+            traverse([&](const Node& node) {
+                float enter;
+                return rayAabb(origin, inverse, node.minBounds, node.maxBounds, maxDistance, enter) ? 1 : 0;
+            }, [&](int32_t proxy) {
+                maxDistance = std::min(maxDistance, visit(proxy));
+                return maxDistance > 0.0f;
+            });
+        }
+
+        size_t proxyCount() const { return m_ProxyCount; }
+        int32_t height() const { return m_Root == NONE ? 0 : m_Nodes[m_Root].height; }
+        size_t reinserts() const { return m_Reinserts; } // by moveProxy, since construction
+
+        // Sum of internal node areas over the root's: the SAH quality of the tree, lower is better
+        float areaRatio() const {
+            if (m_Root == NONE) return 0.0f;
+            const float rootArea = area(m_Nodes[m_Root].minBounds, m_Nodes[m_Root].maxBounds);
+            float total = 0.0f;
+            for (const Node& node : m_Nodes) {
+                if (node.height > 0) total += area(node.minBounds, node.maxBounds);
+            }
+            return rootArea > 0.0f ? total / rootArea : 0.0f;
+        }
+    };
+
+} // namespace gl
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <glm.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 0 forces the scalar loop of cullAabbs
+#ifndef GL_CULL_SIMD
+#define GL_CULL_SIMD 1
+#endif
+
+#if GL_CULL_SIMD && (defined(_M_X64) || defined(__x86_64__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+#define GL_CULL_SSE 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define GL_CULL_AVX 1
+#define GL_CULL_AVX_TARGET
+#elif defined(__GNUC__)
+#define GL_CULL_AVX 1
+#define GL_CULL_AVX_TARGET __attribute__((target("avx")))
+#endif
+#endif
+
+namespace gl {
+
+    // ============ FRUSTUM ============
+    // Six inward-facing planes (xyz = normal, w = distance) extracted from a view-projection matrix
+    // (Gribb & Hartmann). Works with infinite projections: the far plane then degenerates and never culls.
+    struct Frustum {
+        glm::vec4 planes[6];
+
+        static Frustum fromMatrix(const glm::mat4& viewProjection) {
+            const glm::mat4 m = glm::transpose(viewProjection);
+
+            Frustum f;
+            f.planes[0] = m[3] + m[0]; // left
+            f.planes[1] = m[3] - m[0]; // right
+            f.planes[2] = m[3] + m[1]; // bottom
+            f.planes[3] = m[3] - m[1]; // top
+            f.planes[4] = m[3] + m[2]; // near
+            f.planes[5] = m[3] - m[2]; // far
+
+            for (auto& plane : f.planes) {
+                float length = glm::length(glm::vec3(plane));
+                if (length > 0.0f) plane /= length;
+            }
+            return f;
+        }
+
+        bool intersectsSphere(const glm::vec3& center, float radius) const {
+            for (const auto& plane : planes) {
+                if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) return false;
+            }
+            return true;
+        }
+
+        bool intersectsAabb(const glm::vec3& minBounds, const glm::vec3& maxBounds) const {
+            for (const auto& plane : planes) {
+                // Corner furthest along the plane normal
+                glm::vec3 p(
+                    plane.x >= 0.0f ? maxBounds.x : minBounds.x,
+                    plane.y >= 0.0f ? maxBounds.y : minBounds.y,
+                    plane.z >= 0.0f ? maxBounds.z : minBounds.z);
+                if (glm::dot(glm::vec3(plane), p) + plane.w < 0.0f) return false;
+            }
+            return true;
+        }
+    };
+
+    // World-space box enclosing the local box [minBounds, maxBounds] under an affine transform (Arvo)
+    inline void transformAabb(const glm::mat4& m, const glm::vec3& minBounds, const glm::vec3& maxBounds,
+        glm::vec3& outMin, glm::vec3& outMax)
+    {
+        const glm::vec3 center = glm::vec3(m * glm::vec4((minBounds + maxBounds) * 0.5f, 1.0f));
+        const glm::vec3 extent = (maxBounds - minBounds) * 0.5f;
+        glm::vec3 radius(0.0f);
+        for (int column = 0; column < 3; column++) radius += glm::abs(glm::vec3(m[column])) * extent[column];
+        outMin = center - radius;
+        outMax = center + radius;
+    }
+
+    // ============ SOA BOUNDS ============
+    // World-space boxes as six float arrays, so cullAabbs tests 4 (SSE) or 8 (AVX) boxes per instruction.
+    // Capacity is kept a multiple of 8: the last SIMD group may read past size() without leaving the arrays.
+    class AabbSoA {
+    private:
+        size_t m_Count = 0;
+
+    public:
+        std::vector<float> minX, minY, minZ, maxX, maxY, maxZ;
+
+        size_t size() const { return m_Count; }
+        bool empty() const { return m_Count == 0; }
+
+        // Storage is kept
+        void clear() { m_Count = 0; }
+
+        void push_back(const glm::vec3& minBounds, const glm::vec3& maxBounds) {
+            if (m_Count == minX.size()) {
+                const size_t capacity = std::max<size_t>(64, minX.size() * 2);
+                for (auto* array : { &minX, &minY, &minZ, &maxX, &maxY, &maxZ }) array->resize(capacity, 0.0f);
+            }
+            minX[m_Count] = minBounds.x;
+            minY[m_Count] = minBounds.y;
+            minZ[m_Count] = minBounds.z;
+            maxX[m_Count] = maxBounds.x;
+            maxY[m_Count] = maxBounds.y;
+            maxZ[m_Count] = maxBounds.z;
+            m_Count++;
+        }
+
+        glm::vec3 getMin(size_t i) const { return { minX[i], minY[i], minZ[i] }; }
+        glm::vec3 getMax(size_t i) const { return { maxX[i], maxY[i], maxZ[i] }; }
+    };
+
+    struct FrustumCullStats {
+        size_t tested = 0;
+        size_t culled = 0;
+    };
+
+    enum class CullPath { Scalar, SSE, AVX };
+
+    namespace detail {
+        // A plane with, per axis, the array holding the box corner furthest along its normal
+        struct CullPlane {
+            float nx, ny, nz, w;
+            const float* x;
+            const float* y;
+            const float* z;
+        };
+
+        inline void cullPlanes(const Frustum& frustum, const AabbSoA& boxes, CullPlane out[6]) {
+            for (int p = 0; p < 6; p++) {
+                const glm::vec4& plane = frustum.planes[p];
+                out[p] = { plane.x, plane.y, plane.z, plane.w,
+                    plane.x >= 0.0f ? boxes.maxX.data() : boxes.minX.data(),
+                    plane.y >= 0.0f ? boxes.maxY.data() : boxes.minY.data(),
+                    plane.z >= 0.0f ? boxes.maxZ.data() : boxes.minZ.data() };
+            }
+        }
+
+        // Push the indices of the set bits of mask, lanes from first
+        inline void appendLanes(std::vector<uint32_t>& visible, size_t first, unsigned mask) {
+            while (mask) {
+                visible.push_back(static_cast<uint32_t>(first + std::countr_zero(mask)));
+                mask &= mask - 1;
+            }
+        }
+
+        inline void cullAabbsScalar(const CullPlane planes[6], size_t count, std::vector<uint32_t>& visible) {
+            for (size_t i = 0; i < count; i++) {
+                bool inside = true;
+                for (int p = 0; p < 6 && inside; p++) {
+                    const CullPlane& plane = planes[p];
+                    inside = plane.nx * plane.x[i] + plane.ny * plane.y[i] + plane.nz * plane.z[i] + plane.w >= 0.0f;
+                }
+                if (inside) visible.push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+#if GL_CULL_SSE
+        inline void cullAabbsSse(const CullPlane planes[6], size_t count, std::vector<uint32_t>& visible) {
+            const __m128 zero = _mm_setzero_ps();
+            for (size_t i = 0; i < count; i += 4) {
+                __m128 outside = zero;
+                for (int p = 0; p < 6; p++) {
+                    const CullPlane& plane = planes[p];
+                    __m128 d = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.nx), _mm_loadu_ps(plane.x + i)), _mm_set1_ps(plane.w));
+                    d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.ny), _mm_loadu_ps(plane.y + i)));
+                    d = _mm_add_ps(d, _mm_mul_ps(_mm_set1_ps(plane.nz), _mm_loadu_ps(plane.z + i)));
+                    outside = _mm_or_ps(outside, _mm_cmplt_ps(d, zero));
+                }
+                unsigned mask = ~unsigned(_mm_movemask_ps(outside)) & 0xFu;
+                if (count - i < 4) mask &= (1u << (count - i)) - 1u;
+                appendLanes(visible, i, mask);
+            }
+        }
+#endif
+
+#if GL_CULL_AVX
+        GL_CULL_AVX_TARGET inline void cullAabbsAvx(const CullPlane planes[6], size_t count, std::vector<uint32_t>& visible) {
+            const __m256 zero = _mm256_setzero_ps();
+            for (size_t i = 0; i < count; i += 8) {
+                __m256 outside = zero;
+                for (int p = 0; p < 6; p++) {
+                    const CullPlane& plane = planes[p];
+                    __m256 d = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.nx), _mm256_loadu_ps(plane.x + i)), _mm256_set1_ps(plane.w));
+                    d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(plane.ny), _mm256_loadu_ps(plane.y + i)));
+                    d = _mm256_add_ps(d, _mm256_mul_ps(_mm256_set1_ps(plane.nz), _mm256_loadu_ps(plane.z + i)));
+                    outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, zero, _CMP_LT_OQ));
+                }
+                unsigned mask = ~unsigned(_mm256_movemask_ps(outside)) & 0xFFu;
+                if (count - i < 8) mask &= (1u << (count - i)) - 1u;
+                appendLanes(visible, i, mask);
+            }
+        }
+
+        // CPU and OS both support AVX (the OS saves the YMM registers)
+        inline bool avxSupported() {
+            static const bool supported = []() {
+#if defined(_MSC_VER)
+                int info[4];
+                __cpuid(info, 1);
+                const bool osxsave = (info[2] & (1 << 27)) != 0;
+                const bool avx = (info[2] & (1 << 28)) != 0;
+                return osxsave && avx && (_xgetbv(0) & 6) == 6;
+#else
+                return __builtin_cpu_supports("avx") != 0;
+#endif
+            }();
+            return supported;
+        }
+#endif
+    } // namespace detail
+
+    // Widest path cullAabbs takes on this CPU
+    inline CullPath bestCullPath() {
+#if GL_CULL_AVX
+        if (detail::avxSupported()) return CullPath::AVX;
+#endif
+#if GL_CULL_SSE
+        return CullPath::SSE;
+#else
+        return CullPath::Scalar;
+#endif
+    }
+
+    // Append the indices of the boxes intersecting frustum to visible, in ascending order. Same test as
+    // Frustum::intersectsAabb; path defaults to the widest available (an unavailable one falls back to scalar).
+    inline void cullAabbs(const Frustum& frustum, const AabbSoA& boxes, std::vector<uint32_t>& visible, CullPath path = bestCullPath()) {
+        detail::CullPlane planes[6];
+        detail::cullPlanes(frustum, boxes, planes);
+        switch (path) {
+#if GL_CULL_AVX
+        case CullPath::AVX:
+            if (detail::avxSupported()) {
+                detail::cullAabbsAvx(planes, boxes.size(), visible);
+                return;
+            }
+            break;
+#endif
+#if GL_CULL_SSE
+        case CullPath::SSE:
+            detail::cullAabbsSse(planes, boxes.size(), visible);
+            return;
+#endif
+        default:
+            break;
+        }
+        detail::cullAabbsScalar(planes, boxes.size(), visible);
+    }
+
+} // namespace gl
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <vector>
+
+// Frames a SampleCounter's queries get before their results are read; fewer may stall on the GPU
+#define GL_SAMPLE_COUNTER_LATENCY 3
+
+namespace gl {
+
+    // ============ SAMPLE COUNTER ============
+    // Counts the samples that pass the depth test between begin() and end(), with GL_SAMPLES_PASSED queries.
+    // A frame may hold several begin()/end() ranges; they are summed. Results are read
+    // GL_SAMPLE_COUNTER_LATENCY frames later and only once available, so samples() lags behind and never stalls.
+    class SampleCounter {
+    private:
+        struct Frame {
+            std::vector<GLuint> queries;
+            size_t used = 0;
+        };
+
+        Frame m_Frames[GL_SAMPLE_COUNTER_LATENCY];
+        size_t m_Current = 0;
+        uint64_t m_Samples = 0;
+
+        // False if the GPU has not finished the frame yet
+        bool resolve(Frame& frame) {
+            if (!frame.used) return true;
+            GLuint available = GL_FALSE;
+            glGetQueryObjectuiv(frame.queries[frame.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) return false;
+
+            uint64_t samples = 0;
+            for (size_t i = 0; i < frame.used; i++) {
+                GLuint64 result = 0;
+                glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &result);
+                samples += result;
+            }
+            m_Samples = samples;
+            return true;
+        }
+
+    public:
+        SampleCounter() = default;
+        SampleCounter(const SampleCounter&) = delete;
+        SampleCounter& operator=(const SampleCounter&) = delete;
+
+        ~SampleCounter() {
+            for (Frame& frame : m_Frames) {
+                if (!frame.queries.empty()) glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+            }
+        }
+
+        // Move to the next frame's queries, picking up the oldest frame's result if it is ready.
+        // A frame still in flight is dropped rather than waited on; samples() keeps the previous value.
+        void beginFrame() {
+            m_Current = (m_Current + 1) % GL_SAMPLE_COUNTER_LATENCY;
+            resolve(m_Frames[m_Current]);
+            m_Frames[m_Current].used = 0;
+        }
+
+        void begin() {
+            Frame& frame = m_Frames[m_Current];
+            if (frame.used == frame.queries.size()) {
+                GLuint query = 0;
+                glGenQueries(1, &query);
+                frame.queries.push_back(query);
+            }
+            glBeginQuery(GL_SAMPLES_PASSED, frame.queries[frame.used]);
+        }
+
+        void end() {
+            glEndQuery(GL_SAMPLES_PASSED);
+            m_Frames[m_Current].used++;
+        }
+
+        // Samples of the most recent frame whose result has come back
+        uint64_t samples() const { return m_Samples; }
+    };
+
+    struct OverdrawStats {
+        uint64_t depthSamples = 0;  // written by the depth pre-pass
+        uint64_t shadedSamples = 0; // that passed the depth test in the colour passes
+        uint64_t pixels = 0;        // viewport area
+
+        // Shaded samples per pixel: 1 means every covered pixel was shaded once
+        double overdraw() const { return pixels ? double(shadedSamples) / double(pixels) : 0.0; }
+    };
+
+} // namespace gl
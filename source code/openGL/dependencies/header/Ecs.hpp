@@ -0,0 +1,207 @@
+#pragma once
+
+#include <SlotMap.hpp>
+#include <ThreadPool.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Entities per task in Registry::parallelEach
+#ifndef GL_ECS_CHUNK
+#define GL_ECS_CHUNK 4096
+#endif
+
+namespace gl {
+
+    // Index plus generation, like SlotMap handles; a destroyed entity's handle goes stale
+    using Entity = SlotHandle;
+
+    namespace detail {
+        inline size_t nextComponentId() {
+            static std::atomic<size_t> next{ 0 };
+            return next++;
+        }
+
+        template <typename T>
+        size_t componentId() {
+            static const size_t id = nextComponentId();
+            return id;
+        }
+    }
+
+    class ComponentPoolBase {
+    public:
+        virtual ~ComponentPoolBase() = default;
+        virtual void remove(uint32_t entity) = 0;
+    };
+
+    // ============ COMPONENT POOL ============
+    // Sparse set of one component type: components packed contiguously in m_Components, with the owning
+    // entity index alongside and a sparse entity -> position array for O(1) lookup. Removal moves the last
+    // component into the gap.
+    template <typename T>
+    class ComponentPool : public ComponentPoolBase {
+    private:
+        static constexpr uint32_t ABSENT = UINT32_MAX;
+
+        std::vector<uint32_t> m_Sparse;   // entity index -> position, or ABSENT
+        std::vector<uint32_t> m_Entities; // position -> entity index
+        std::vector<T> m_Components;
+
+    public:
+        bool has(uint32_t entity) const { return entity < m_Sparse.size() && m_Sparse[entity] != ABSENT; }
+
+        // Replaces the component if the entity already has one
+        template <typename... Args>
+        T& emplace(uint32_t entity, Args&&... args) {
+            if (has(entity)) return m_Components[m_Sparse[entity]] = T{ std::forward<Args>(args)... };
+            if (entity >= m_Sparse.size()) m_Sparse.resize(size_t(entity) + 1, ABSENT);
+            m_Sparse[entity] = static_cast<uint32_t>(m_Components.size());
+            m_Entities.push_back(entity);
+            m_Components.push_back(T{ std::forward<Args>(args)... });
+            return m_Components.back();
+        }
+
+        void remove(uint32_t entity) override {
+            if (!has(entity)) return;
+            const uint32_t position = m_Sparse[entity];
+            const uint32_t last = static_cast<uint32_t>(m_Components.size() - 1);
+            if (position != last) {
+                m_Components[position] = std::move(m_Components[last]);
+                m_Entities[position] = m_Entities[last];
+                m_Sparse[m_Entities[position]] = position;
+            }
+            m_Components.pop_back();
+            m_Entities.pop_back();
+            m_Sparse[entity] = ABSENT;
+        }
+
+        T& get(uint32_t entity) { return m_Components[m_Sparse[entity]]; }
+        const T& get(uint32_t entity) const { return m_Components[m_Sparse[entity]]; }
+        T* find(uint32_t entity) { return has(entity) ? &m_Components[m_Sparse[entity]] : nullptr; }
+
+        size_t size() const { return m_Components.size(); }
+        T* data() { return m_Components.data(); }
+        const uint32_t* entities() const { return m_Entities.data(); }
+    };
+
+    // ============ REGISTRY ============
+    // Entities and their components, one ComponentPool per component type. Components are plain structs
+    // added per entity; systems are functions that run each()/parallelEach() over the entities holding a
+    // set of components. Adding or removing components or entities invalidates references to components.
+    class Registry {
+    private:
+        std::vector<uint32_t> m_Generations; // per entity index
+        std::vector<uint32_t> m_Free;
+        std::vector<std::unique_ptr<ComponentPoolBase>> m_Pools; // by detail::componentId
+        size_t m_Alive = 0;
+
+        template <typename First, typename... Others, typename F>
+        void eachRange(size_t begin, size_t end, F& fn) {
+            ComponentPool<First>& first = pool<First>();
+            std::apply([&](ComponentPool<Others>&... others) {
+                for (size_t i = begin; i < end; i++) {
+                    const uint32_t entity = first.entities()[i];
+                    if (!(others.has(entity) && ...)) continue;
+                    fn(entityAt(entity), first.data()[i], others.get(entity)...);
+                }
+            }, std::tuple<ComponentPool<Others>&...>(pool<Others>()...));
+        }
+
+    public:
+        Registry() = default;
+        Registry(const Registry&) = delete;
+        Registry& operator=(const Registry&) = delete;
+
+        Entity create() {
+            m_Alive++;
+            if (!m_Free.empty()) {
+                const uint32_t index = m_Free.back();
+                m_Free.pop_back();
+                return { index, m_Generations[index] };
+            }
+            m_Generations.push_back(1);
+            return { static_cast<uint32_t>(m_Generations.size() - 1), 1 };
+        }
+
+        // Removes every component; false if entity is stale
+        bool destroy(Entity entity) {
+            if (!valid(entity)) return false;
+            for (auto& pool : m_Pools) {
+                if (pool) pool->remove(entity.index);
+            }
+            if (++m_Generations[entity.index] == 0) m_Generations[entity.index] = 1;
+            m_Free.push_back(entity.index);
+            m_Alive--;
+            return true;
+        }
+
+        bool valid(Entity entity) const {
+            return entity.generation != 0 && entity.index < m_Generations.size() && m_Generations[entity.index] == entity.generation;
+        }
+
+        // Current handle of a live entity index
+        Entity entityAt(uint32_t index) const { return { index, m_Generations[index] }; }
+
+        template <typename T>
+        ComponentPool<T>& pool() {
+            const size_t id = detail::componentId<T>();
+            if (id >= m_Pools.size()) m_Pools.resize(id + 1);
+            if (!m_Pools[id]) m_Pools[id] = std::make_unique<ComponentPool<T>>();
+            return static_cast<ComponentPool<T>&>(*m_Pools[id]);
+        }
+
+        // nullptr if entity is stale, rather than handing the component to whoever reuses its index
+        template <typename T, typename... Args>
+        T* add(Entity entity, Args&&... args) {
+            return valid(entity) ? &pool<T>().emplace(entity.index, std::forward<Args>(args)...) : nullptr;
+        }
+
+        template <typename T>
+        void remove(Entity entity) {
+            if (valid(entity)) pool<T>().remove(entity.index);
+        }
+
+        template <typename T>
+        bool has(Entity entity) { return valid(entity) && pool<T>().has(entity.index); }
+
+        // nullptr if entity is stale or lacks T
+        template <typename T>
+        T* find(Entity entity) { return valid(entity) ? pool<T>().find(entity.index) : nullptr; }
+
+        // entity must be live and have T
+        template <typename T>
+        T& get(Entity entity) { return pool<T>().get(entity.index); }
+
+        size_t size() const { return m_Alive; }
+
+        // fn(Entity, First&, Others&...) for every entity with all the components, walking First's array in
+        // order; the others are looked up through their sparse arrays, so list the rarest component first.
+        template <typename First, typename... Others, typename F>
+        void each(F&& fn) {
+            eachRange<First, Others...>(0, pool<First>().size(), fn);
+        }
+
+        // each() in chunks of `chunk` entities on the thread pool, the calling thread included. fn may
+        // only touch the components it is given; no entities or components are added or removed meanwhile.
+        template <typename First, typename... Others, typename F>
+        void parallelEach(F&& fn, size_t chunk = GL_ECS_CHUNK) {
+            const size_t count = pool<First>().size();
+            (pool<Others>(), ...); // created here, so workers never grow m_Pools
+            const size_t chunks = (count + chunk - 1) / chunk;
+            if (chunks <= 1) {
+                eachRange<First, Others...>(0, count, fn);
+                return;
+            }
+            getThreadPool().parallelFor(chunks, [&](size_t c) {
+                eachRange<First, Others...>(c * chunk, std::min(count, (c + 1) * chunk), fn);
+            });
+        }
+    };
+
+} // namespace gl
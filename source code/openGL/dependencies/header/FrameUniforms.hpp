@@ -0,0 +1,73 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm.hpp>
+
+#include <Utils.hpp>
+#include <StreamBuffer.hpp>
+
+#include <algorithm>
+
+namespace gl {
+
+    // ============ FRAME UNIFORMS ============
+    // std140 mirror of the Frame block declared by the shaders in resource/shader; keep the two in sync.
+    // Every gl::shader binds the block to GL_FRAME_UNIFORM_BINDING, so one upload per frame serves all programs.
+    struct FrameUniforms {
+        glm::mat4 view = glm::mat4(1.0f);
+        glm::mat4 projection = glm::mat4(1.0f);
+        glm::mat4 viewProjection = glm::mat4(1.0f);
+        glm::vec4 cameraPos = glm::vec4(0.0f); // xyz, w unused
+        glm::vec4 viewport = glm::vec4(0.0f);  // width, height, 1 / width, 1 / height
+        float time = 0.0f;                     // seconds since start
+        float deltaTime = 0.0f;
+        float padding[2] = {};
+
+        static FrameUniforms fromCamera(const camera& cam, const glm::mat4& projection, float width, float height,
+            float time = 0.0f, float deltaTime = 0.0f)
+        {
+            FrameUniforms frame;
+            frame.view = cam.getViewMatrix();
+            frame.projection = projection;
+            frame.viewProjection = projection * frame.view;
+            frame.cameraPos = glm::vec4(cam.getPos(), 1.0f);
+            frame.viewport = glm::vec4(width, height, width > 0.0f ? 1.0f / width : 0.0f, height > 0.0f ? 1.0f / height : 0.0f);
+            frame.time = time;
+            frame.deltaTime = deltaTime;
+            return frame;
+        }
+    };
+
+    static_assert(sizeof(FrameUniforms) == 3 * 64 + 2 * 16 + 16, "FrameUniforms must match the std140 Frame block");
+
+    // Writes each frame's block into its own slice of a StreamBuffer and binds that slice to
+    // GL_FRAME_UNIFORM_BINDING, so the GPU can still be reading earlier frames' blocks.
+    class FrameUniformBuffer {
+    private:
+        StreamBuffer m_Stream{ GL_UNIFORM_BUFFER, 16u << 10 };
+        GLint m_Alignment = 0;
+        FrameUniforms m_Current;
+        size_t m_Uploads = 0;
+
+    public:
+        void upload(const FrameUniforms& frame) {
+            if (!m_Alignment) glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &m_Alignment);
+
+            StreamBuffer::Allocation block = m_Stream.write(&frame, sizeof(FrameUniforms), size_t(std::max(m_Alignment, 16)));
+            getGLState().bindBufferRange(GL_UNIFORM_BUFFER, GL_FRAME_UNIFORM_BINDING, m_Stream.buffer(), block.offset, sizeof(FrameUniforms));
+            m_Current = frame;
+            m_Uploads++;
+        }
+
+        // Last uploaded values, e.g. for CPU-side culling
+        const FrameUniforms& current() const { return m_Current; }
+
+        size_t uploads() const { return m_Uploads; }
+    };
+
+    FrameUniformBuffer& getFrameUniforms() {
+        static FrameUniformBuffer buffer;
+        return buffer;
+    }
+
+} // namespace gl
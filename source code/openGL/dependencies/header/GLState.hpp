@@ -0,0 +1,290 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+// Texture units whose bindings are shadowed; binds to higher units always reach GL
+#ifndef GL_STATE_TEXTURE_UNITS
+#define GL_STATE_TEXTURE_UNITS 32
+#endif
+
+namespace gl {
+
+    // Issued and skipped calls of one kind of state
+    struct StateCounter {
+        size_t issued = 0;
+        size_t skipped = 0;
+    };
+
+    struct StateStats {
+        StateCounter program;
+        StateCounter vertexArray;
+        StateCounter buffer;
+        StateCounter texture;       // glActiveTexture + glBindTexture
+        StateCounter uniform;       // glUniform1i (samplers)
+        StateCounter fixedFunction; // enable/disable, blend, depth, colour mask, cull
+
+        size_t issued() const {
+            return program.issued + vertexArray.issued + buffer.issued + texture.issued + uniform.issued + fixedFunction.issued;
+        }
+
+        size_t skipped() const {
+            return program.skipped + vertexArray.skipped + buffer.skipped + texture.skipped + uniform.skipped + fixedFunction.skipped;
+        }
+    };
+
+    // ============ STATE CACHE ============
+    // Shadow copy of the GL state the engine changes. Each setter compares with the shadow and only calls GL
+    // when the value differs, counting both outcomes. Engine code binds and deletes through it so the shadow
+    // stays exact; anything else that touches GL (ImGui, user code) must be followed by invalidate(), which
+    // Scene::render does at the start of every frame. Element array bindings are VAO state and are not shadowed.
+    class StateCache {
+    private:
+        static constexpr GLuint UNKNOWN = ~0u;
+        static constexpr int TEXTURE_TARGETS = 4;
+
+        GLuint m_Program = UNKNOWN;
+        GLuint m_VertexArray = UNKNOWN;
+        GLenum m_ActiveUnit = UNKNOWN; // index, not GL_TEXTURE0 + index
+        std::array<std::array<GLuint, TEXTURE_TARGETS>, GL_STATE_TEXTURE_UNITS> m_Textures;
+        std::unordered_map<GLenum, GLuint> m_Buffers; // target -> buffer
+        std::unordered_map<uint64_t, GLint> m_Uniforms; // (program, location) -> value, survives invalidate()
+        std::unordered_map<GLenum, int> m_Capabilities; // cap -> 0 / 1, missing = unknown
+        GLenum m_BlendSrc = UNKNOWN, m_BlendDst = UNKNOWN;
+        GLenum m_DepthFunc = UNKNOWN;
+        GLenum m_CullFace = UNKNOWN;
+        int m_DepthMask = -1;
+        int m_ColorMask = -1;
+        StateStats m_Stats;
+
+        static int textureTarget(GLenum target) {
+            switch (target) {
+            case GL_TEXTURE_2D: return 0;
+            case GL_TEXTURE_2D_ARRAY: return 1;
+            case GL_TEXTURE_3D: return 2;
+            case GL_TEXTURE_CUBE_MAP: return 3;
+            default: return -1;
+            }
+        }
+
+        static uint64_t uniformKey(GLuint program, GLint location) {
+            return (uint64_t(program) << 32) | uint32_t(location);
+        }
+
+        static bool count(StateCounter& counter, bool changed) {
+            if (changed) counter.issued++;
+            else counter.skipped++;
+            return changed;
+        }
+
+    public:
+        StateCache() { invalidate(); }
+
+        // Forget all bindings and fixed-function state, e.g. after code that calls GL directly.
+        // Uniform values belong to programs and are kept.
+        void invalidate() {
+            m_Program = UNKNOWN;
+            m_VertexArray = UNKNOWN;
+            m_ActiveUnit = UNKNOWN;
+            for (auto& unit : m_Textures) unit.fill(UNKNOWN);
+            m_Buffers.clear();
+            m_Capabilities.clear();
+            m_BlendSrc = m_BlendDst = UNKNOWN;
+            m_DepthFunc = UNKNOWN;
+            m_CullFace = UNKNOWN;
+            m_DepthMask = -1;
+            m_ColorMask = -1;
+        }
+
+        // ---- Bindings; each returns whether GL was called ----
+
+        bool useProgram(GLuint program) {
+            if (!count(m_Stats.program, program != m_Program)) return false;
+            glUseProgram(program);
+            m_Program = program;
+            return true;
+        }
+
+        bool bindVertexArray(GLuint vao) {
+            if (!count(m_Stats.vertexArray, vao != m_VertexArray)) return false;
+            glBindVertexArray(vao);
+            m_VertexArray = vao;
+            return true;
+        }
+
+        bool bindBuffer(GLenum target, GLuint buffer) {
+            if (target == GL_ELEMENT_ARRAY_BUFFER) {
+                glBindBuffer(target, buffer);
+                return true;
+            }
+            auto [it, inserted] = m_Buffers.emplace(target, UNKNOWN);
+            if (!count(m_Stats.buffer, it->second != buffer)) return false;
+            glBindBuffer(target, buffer);
+            it->second = buffer;
+            return true;
+        }
+
+        // Indexed bind; also sets the generic binding of target, as GL does
+        void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+            glBindBufferRange(target, index, buffer, offset, size);
+            m_Buffers[target] = buffer;
+            m_Stats.buffer.issued++;
+        }
+
+        bool activeTexture(GLuint unit) {
+            if (!count(m_Stats.texture, unit != m_ActiveUnit)) return false;
+            glActiveTexture(GL_TEXTURE0 + unit);
+            m_ActiveUnit = unit;
+            return true;
+        }
+
+        // Bind to the active unit, as glBindTexture does
+        bool bindTexture(GLenum target, GLuint texture) {
+            const int t = textureTarget(target);
+            if (t < 0 || m_ActiveUnit >= GL_STATE_TEXTURE_UNITS) {
+                glBindTexture(target, texture);
+                m_Stats.texture.issued++;
+                if (t >= 0 && m_ActiveUnit == UNKNOWN) {
+                    for (auto& unit : m_Textures) unit[t] = UNKNOWN; // landed on some unit
+                }
+                return true;
+            }
+            GLuint& bound = m_Textures[m_ActiveUnit][t];
+            if (!count(m_Stats.texture, bound != texture)) return false;
+            glBindTexture(target, texture);
+            bound = texture;
+            return true;
+        }
+
+        // Bind to a unit; only switches the active unit when the binding actually changes
+        bool bindTexture(GLuint unit, GLenum target, GLuint texture) {
+            const int t = textureTarget(target);
+            if (t >= 0 && unit < GL_STATE_TEXTURE_UNITS && m_Textures[unit][t] == texture) {
+                m_Stats.texture.skipped++;
+                return false;
+            }
+            activeTexture(unit);
+            return bindTexture(target, texture);
+        }
+
+        // glUniform1i on the current program. Values are cached per program, so sampler units set
+        // once stay set across frames.
+        bool uniform1i(GLint location, GLint value) {
+            if (location < 0) return false;
+            if (m_Program == UNKNOWN) {
+                // Some program's value changes, but which one is unknown
+                glUniform1i(location, value);
+                m_Uniforms.clear();
+                m_Stats.uniform.issued++;
+                return true;
+            }
+            auto [it, inserted] = m_Uniforms.emplace(uniformKey(m_Program, location), value);
+            if (!count(m_Stats.uniform, inserted || it->second != value)) return false;
+            glUniform1i(location, value);
+            it->second = value;
+            return true;
+        }
+
+        // ---- Fixed-function state ----
+
+        bool setEnabled(GLenum capability, bool enabled) {
+            auto [it, inserted] = m_Capabilities.emplace(capability, -1);
+            if (!count(m_Stats.fixedFunction, it->second != int(enabled))) return false;
+            if (enabled) glEnable(capability);
+            else glDisable(capability);
+            it->second = enabled;
+            return true;
+        }
+
+        bool blendFunc(GLenum src, GLenum dst) {
+            if (!count(m_Stats.fixedFunction, src != m_BlendSrc || dst != m_BlendDst)) return false;
+            glBlendFunc(src, dst);
+            m_BlendSrc = src;
+            m_BlendDst = dst;
+            return true;
+        }
+
+        bool depthFunc(GLenum func) {
+            if (!count(m_Stats.fixedFunction, func != m_DepthFunc)) return false;
+            glDepthFunc(func);
+            m_DepthFunc = func;
+            return true;
+        }
+
+        bool depthMask(bool write) {
+            if (!count(m_Stats.fixedFunction, int(write) != m_DepthMask)) return false;
+            glDepthMask(write ? GL_TRUE : GL_FALSE);
+            m_DepthMask = write;
+            return true;
+        }
+
+        // All four channels on or off
+        bool colorMask(bool write) {
+            if (!count(m_Stats.fixedFunction, int(write) != m_ColorMask)) return false;
+            const GLboolean value = write ? GL_TRUE : GL_FALSE;
+            glColorMask(value, value, value, value);
+            m_ColorMask = write;
+            return true;
+        }
+
+        bool cullFace(GLenum face) {
+            if (!count(m_Stats.fixedFunction, face != m_CullFace)) return false;
+            glCullFace(face);
+            m_CullFace = face;
+            return true;
+        }
+
+        // ---- Deletion: GL unbinds deleted objects, so the shadow must too ----
+
+        void deleteBuffers(GLsizei n, const GLuint* buffers) {
+            for (GLsizei i = 0; i < n; i++) {
+                for (auto& [target, bound] : m_Buffers) {
+                    if (bound == buffers[i]) bound = 0;
+                }
+            }
+            glDeleteBuffers(n, buffers);
+        }
+
+        void deleteVertexArrays(GLsizei n, const GLuint* arrays) {
+            for (GLsizei i = 0; i < n; i++) {
+                if (arrays[i] == m_VertexArray) m_VertexArray = 0;
+            }
+            glDeleteVertexArrays(n, arrays);
+        }
+
+        void deleteTextures(GLsizei n, const GLuint* textures) {
+            for (GLsizei i = 0; i < n; i++) {
+                for (auto& unit : m_Textures) {
+                    for (auto& bound : unit) {
+                        if (bound == textures[i]) bound = 0;
+                    }
+                }
+            }
+            glDeleteTextures(n, textures);
+        }
+
+        void deleteProgram(GLuint program) {
+            if (program == m_Program) m_Program = UNKNOWN; // stays in use until the next glUseProgram
+            std::erase_if(m_Uniforms, [program](const auto& entry) { return (entry.first >> 32) == program; });
+            glDeleteProgram(program);
+        }
+
+        GLuint program() const { return m_Program; }
+
+        GLuint vertexArray() const { return m_VertexArray; }
+
+        const StateStats& stats() const { return m_Stats; }
+
+        void resetStats() { m_Stats = StateStats(); }
+    };
+
+    StateCache& getGLState() {
+        static StateCache state;
+        return state;
+    }
+
+} // namespace gl
@@ -13,6 +13,8 @@
 
 #include <Window.hpp>
 #include <Utils.hpp>
+#include <FrameUniforms.hpp>
+#include <RenderThread.hpp>
 
 namespace gl {
 
@@ -124,18 +126,34 @@ namespace gl {
 		{
 		}
 
-		void update() {
-			m_Shader->useProgram();
-
+		// Input and camera only, no GL: returns this frame's Frame block
+		FrameUniforms simulate() {
 			// --- MOUSE LOOK ---
 			processInput();
 
 			m_Proj = glm::infinitePerspective(glm::radians(m_Camera.getFov()), (float)m_Window->getWidth() / (float)m_Window->getHeight(), 0.1f);
 
+			return FrameUniforms::fromCamera(m_Camera, m_Proj, (float)m_Window->getWidth(), (float)m_Window->getHeight(),
+				(float)glfwGetTime(), (float)m_Window->getDeltaTime());
+		}
+
+		void update() {
+			const FrameUniforms frame = simulate();
+
+			m_Shader->useProgram();
 			m_Shader->setUniformMat4fv("model", m_Model);
-			m_Shader->setUniformMat4fv("view", m_Camera.getViewMatrix());
-			m_Shader->setUniformMat4fv("projection", m_Proj);
-			m_Shader->setUniform3fv("camPos", getPos());
+
+			// Camera data goes to the shared Frame block, read by every program
+			getFrameUniforms().upload(frame);
+		}
+
+		// update() for a RenderThread: simulate here, leave the GL calls to the list
+		void record(CommandList& list) {
+			list.frame(simulate());
+			list.run([shader = m_Shader, model = m_Model]() {
+				shader->useProgram();
+				shader->setUniformMat4fv("model", model);
+			});
 		}
 
 		void setFov(const float& fov, const float& aspect) { m_Camera.setFov(fov); }
@@ -159,19 +177,19 @@ namespace gl {
 		glm::vec3 getDirRadians() const { return m_Camera.getFront(); }
 	};
 
-	glm::mat4 getItemModel(const camera& cam, const glm::vec3& offset, const glm::vec3& scale) {
-		return glm::scale(
-			glm::translate(
-				glm::translate(glm::mat4(1.0f), cam.getPos()) *
-				glm::inverse(glm::lookAt(glm::vec3(0.0f), -cam.getFront(), cam.getUpVector())),
-				offset
-			),
-			scale
-		);
+	// Camera to world: at the eye, facing along the front vector. A TransformHierarchy node with this as
+	// its local matrix (setLocalMatrix) can parent held items, so they follow the camera without getItemModel.
+	glm::mat4 getCameraModel(const camera& cam) {
+		return glm::translate(glm::mat4(1.0f), cam.getPos()) *
+			glm::inverse(glm::lookAt(glm::vec3(0.0f), -cam.getFront(), cam.getUpVector()));
 	}
 
-	glm::mat4 getItemModel(
-		const gl::camera& cam,
+	// Item placement relative to the camera, i.e. the local transform of an item node under a camera node
+	glm::mat4 getItemLocal(const glm::vec3& offset, const glm::vec3& scale) {
+		return glm::scale(glm::translate(glm::mat4(1.0f), offset), scale);
+	}
+
+	glm::mat4 getItemLocal(
 		const glm::vec3& offset,
 		const float& scale,
 		const glm::quat& additionalRotation = glm::identity<glm::quat>(),
@@ -179,9 +197,7 @@ namespace gl {
 	) {
 
 		return glm::scale(
-			glm::translate(glm::mat4(1), cam.getPos()) *
 			glm::toMat4(
-				glm::quat_cast(glm::mat3(glm::inverse(glm::lookAt(glm::vec3(0), -cam.getFront(), cam.getUpVector())))) *
 				glm::angleAxis(glm::radians(rot.x), glm::vec3(0, 1, 0)) *
 				glm::angleAxis(glm::radians(rot.y), glm::vec3(1, 0, 0)) *
 				additionalRotation
@@ -191,4 +207,19 @@ namespace gl {
 		);
 	}
 
+	glm::mat4 getItemModel(const camera& cam, const glm::vec3& offset, const glm::vec3& scale) {
+		return getCameraModel(cam) * getItemLocal(offset, scale);
+	}
+
+	glm::mat4 getItemModel(
+		const gl::camera& cam,
+		const glm::vec3& offset,
+		const float& scale,
+		const glm::quat& additionalRotation = glm::identity<glm::quat>(),
+		const glm::vec2& rot = glm::vec2(0.0f)
+	) {
+
+		return getCameraModel(cam) * getItemLocal(offset, scale, additionalRotation, rot);
+	}
+
 }
\ No newline at end of file
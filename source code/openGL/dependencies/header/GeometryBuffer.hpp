@@ -0,0 +1,370 @@
+#pragma once
+
+#include <Utils.hpp>
+#include <PackedVertex.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+// Initial sizes of a geometry pool; pools grow by doubling
+#ifndef GL_GEOMETRY_POOL_MIN_VERTICES
+#define GL_GEOMETRY_POOL_MIN_VERTICES (64 * 1024)
+#endif
+
+#ifndef GL_GEOMETRY_POOL_MIN_INDEX_BYTES
+#define GL_GEOMETRY_POOL_MIN_INDEX_BYTES (1024 * 1024)
+#endif
+
+// Keep a position-only copy of Standard vertices (12 more bytes per vertex) for depth-only passes
+#ifndef GL_DEPTH_POSITION_STREAM
+#define GL_DEPTH_POSITION_STREAM 1
+#endif
+
+namespace gl {
+
+    // ============ RANGE ALLOCATOR ============
+    // First-fit sub-allocator over [0, capacity). Free ranges are kept sorted and coalesced on release,
+    // so holes merge back together; what remains fragmented is closed by GeometryPool::compact().
+    class RangeAllocator {
+    private:
+        struct Range {
+            size_t offset;
+            size_t size;
+        };
+
+        std::vector<Range> m_Free; // sorted by offset, never adjacent
+        size_t m_Capacity = 0;
+        size_t m_Used = 0;
+
+    public:
+        explicit RangeAllocator(size_t capacity = 0) { reset(capacity, 0); }
+
+        // Everything below used is allocated, everything above free
+        void reset(size_t capacity, size_t used) {
+            m_Capacity = capacity;
+            m_Used = used;
+            m_Free.clear();
+            if (used < capacity) m_Free.push_back({ used, capacity - used });
+        }
+
+        bool allocate(size_t size, size_t& offset) {
+            if (size == 0) size = 1;
+            for (size_t i = 0; i < m_Free.size(); i++) {
+                Range& range = m_Free[i];
+                if (range.size < size) continue;
+
+                offset = range.offset;
+                range.offset += size;
+                range.size -= size;
+                if (range.size == 0) m_Free.erase(m_Free.begin() + i);
+                m_Used += size;
+                return true;
+            }
+            return false;
+        }
+
+        void release(size_t offset, size_t size) {
+            if (size == 0) size = 1;
+            m_Used -= size;
+
+            auto next = std::lower_bound(m_Free.begin(), m_Free.end(), offset,
+                [](const Range& r, size_t o) { return r.offset < o; });
+
+            const bool joinPrev = next != m_Free.begin() && std::prev(next)->offset + std::prev(next)->size == offset;
+            const bool joinNext = next != m_Free.end() && offset + size == next->offset;
+
+            if (joinPrev && joinNext) {
+                std::prev(next)->size += size + next->size;
+                m_Free.erase(next);
+            }
+            else if (joinPrev) std::prev(next)->size += size;
+            else if (joinNext) {
+                next->offset = offset;
+                next->size += size;
+            }
+            else m_Free.insert(next, { offset, size });
+        }
+
+        size_t capacity() const { return m_Capacity; }
+
+        size_t used() const { return m_Used; }
+
+        size_t freeRanges() const { return m_Free.size(); }
+
+        size_t largestFree() const {
+            size_t largest = 0;
+            for (const auto& range : m_Free) largest = std::max(largest, range.size);
+            return largest;
+        }
+    };
+
+    // ============ BIND STATS ============
+    // VAO binds issued by Mesh::draw vs. draws made. With pooled meshes consecutive draws of one
+    // vertex format reuse the bound VAO, and draws - vaoBinds is what the per-mesh VAOs would have cost.
+    struct BindStats {
+        size_t draws = 0;
+        size_t vaoBinds = 0;
+
+        size_t saved() const { return draws - vaoBinds; }
+    };
+
+    inline BindStats bindStats;
+
+    // Bind vao for a draw through the state cache, which skips the call if it is already bound
+    inline void useVertexArray(GLuint vao) {
+        bindStats.draws++;
+        if (getGLState().bindVertexArray(vao)) bindStats.vaoBinds++;
+    }
+
+    // ============ GEOMETRY POOL ============
+    // One vertex buffer, one index buffer and one VAO shared by every mesh of a vertex format.
+    // Pools given a position offset also keep the positions alone in a parallel buffer, with a second VAO
+    // (depthVao) reading it at location 0 over the same index buffer: a block draws the same from either.
+    // Meshes own a block (a vertex range drawn with a base vertex and an index byte range) addressed
+    // by handle, so blocks can move when the pool grows or is compacted without touching the meshes.
+    class GeometryPool {
+    public:
+        using Handle = uint32_t;
+        static constexpr Handle INVALID = UINT32_MAX; // allocate() could not fit the block
+
+        struct Block {
+            size_t firstVertex = 0; // base vertex
+            size_t vertexCount = 0;
+            size_t indexOffset = 0; // bytes into the index buffer
+            size_t indexBytes = 0;
+            bool live = false;
+        };
+
+        struct Stats {
+            size_t blocks = 0;
+            size_t vertexBytes = 0;    // in use
+            size_t indexBytes = 0;     // in use
+            size_t positionBytes = 0;  // in use by the position stream
+            size_t capacityBytes = 0;  // all buffers
+            size_t freeRanges = 0;     // holes + the tail; 2 or more means fragmented
+            size_t relocations = 0;    // grows + compactions so far
+        };
+
+    private:
+        GLuint m_VAO = 0;
+        GLuint m_VBO = 0;
+        GLuint m_IBO = 0;
+        size_t m_Stride;
+        std::function<void()> m_Attributes; // glVertexAttribPointer calls for m_Stride-sized vertices
+        size_t m_PositionOffset;            // of a float vec3 in each vertex; SIZE_MAX = no position stream
+        GLuint m_PositionVBO = 0;
+        GLuint m_DepthVAO = 0;
+
+        RangeAllocator m_Vertices; // in vertices
+        RangeAllocator m_Indices;  // in bytes, 4-byte granular so 16- and 32-bit ranges can share the buffer
+        std::vector<Block> m_Blocks;
+        std::vector<Handle> m_FreeHandles;
+        size_t m_Relocations = 0;
+
+        static constexpr size_t POSITION_SIZE = 3 * sizeof(float);
+
+        static size_t indexUnits(size_t bytes) { return (bytes + 3) & ~size_t(3); }
+
+        bool hasPositions() const { return m_PositionOffset != SIZE_MAX; }
+
+        // Copy every live block, packed in offset order, into new buffers of the given capacities
+        void relocate(size_t vertexCapacity, size_t indexCapacity) {
+            GLuint vbo = 0, ibo = 0;
+            glGenBuffers(1, &vbo);
+            getGLState().bindBuffer(GL_COPY_WRITE_BUFFER, vbo);
+            glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * m_Stride, nullptr, GL_STATIC_DRAW);
+            glGenBuffers(1, &ibo);
+            getGLState().bindBuffer(GL_COPY_WRITE_BUFFER, ibo);
+            glBufferData(GL_COPY_WRITE_BUFFER, indexCapacity, nullptr, GL_STATIC_DRAW);
+
+            std::vector<Handle> order;
+            for (Handle h = 0; h < m_Blocks.size(); h++) {
+                if (m_Blocks[h].live) order.push_back(h);
+            }
+
+            GLuint positions = 0;
+            if (hasPositions()) {
+                glGenBuffers(1, &positions);
+                getGLState().bindBuffer(GL_COPY_WRITE_BUFFER, positions);
+                glBufferData(GL_COPY_WRITE_BUFFER, vertexCapacity * POSITION_SIZE, nullptr, GL_STATIC_DRAW);
+            }
+
+            size_t vertexEnd = 0, indexEnd = 0;
+            if (m_VBO) {
+                std::sort(order.begin(), order.end(), [&](Handle a, Handle b) { return m_Blocks[a].firstVertex < m_Blocks[b].firstVertex; });
+                auto copyVertices = [&](GLuint from, GLuint to, size_t size) {
+                    getGLState().bindBuffer(GL_COPY_READ_BUFFER, from);
+                    getGLState().bindBuffer(GL_COPY_WRITE_BUFFER, to);
+                    size_t end = 0;
+                    for (Handle h : order) {
+                        const Block& block = m_Blocks[h];
+                        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, block.firstVertex * size, end * size, block.vertexCount * size);
+                        end += std::max<size_t>(block.vertexCount, 1);
+                    }
+                };
+                copyVertices(m_VBO, vbo, m_Stride);
+                if (hasPositions()) copyVertices(m_PositionVBO, positions, POSITION_SIZE);
+                for (Handle h : order) {
+                    Block& block = m_Blocks[h];
+                    block.firstVertex = vertexEnd;
+                    vertexEnd += std::max<size_t>(block.vertexCount, 1);
+                }
+
+                std::sort(order.begin(), order.end(), [&](Handle a, Handle b) { return m_Blocks[a].indexOffset < m_Blocks[b].indexOffset; });
+                getGLState().bindBuffer(GL_COPY_READ_BUFFER, m_IBO);
+                getGLState().bindBuffer(GL_COPY_WRITE_BUFFER, ibo);
+                for (Handle h : order) {
+                    Block& block = m_Blocks[h];
+                    if (block.indexBytes) {
+                        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, block.indexOffset, indexEnd, block.indexBytes);
+                    }
+                    block.indexOffset = indexEnd;
+                    indexEnd += std::max<size_t>(indexUnits(block.indexBytes), 4);
+                }
+
+                getGLState().deleteBuffers(1, &m_VBO);
+                getGLState().deleteBuffers(1, &m_IBO);
+                if (m_PositionVBO) getGLState().deleteBuffers(1, &m_PositionVBO);
+                m_Relocations++;
+            }
+
+            m_VBO = vbo;
+            m_IBO = ibo;
+            m_PositionVBO = positions;
+            m_Vertices.reset(vertexCapacity, vertexEnd);
+            m_Indices.reset(indexCapacity, indexEnd);
+
+            // Re-point the shared VAO; attribute pointers latch the buffer bound to GL_ARRAY_BUFFER
+            if (!m_VAO) glGenVertexArrays(1, &m_VAO);
+            getGLState().bindVertexArray(m_VAO);
+            getGLState().bindBuffer(GL_ARRAY_BUFFER, m_VBO);
+            m_Attributes();
+            getGLState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IBO);
+
+            if (hasPositions()) {
+                if (!m_DepthVAO) glGenVertexArrays(1, &m_DepthVAO);
+                getGLState().bindVertexArray(m_DepthVAO);
+                getGLState().bindBuffer(GL_ARRAY_BUFFER, m_PositionVBO);
+                positionAttribute(0, 3, static_cast<GLsizei>(POSITION_SIZE), nullptr);
+                getGLState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IBO);
+            }
+            getGLState().bindVertexArray(0);
+        }
+
+        // Free space suffices: compact in place. Otherwise grow, which compacts as well.
+        void makeRoom(size_t vertexCount, size_t indexBytes) {
+            auto capacityFor = [](size_t capacity, size_t used, size_t needed, size_t minimum) {
+                if (used + needed <= capacity - capacity / 4) return capacity;
+                return std::max({ capacity * 2, used + needed, minimum });
+            };
+            relocate(capacityFor(m_Vertices.capacity(), m_Vertices.used(), vertexCount, GL_GEOMETRY_POOL_MIN_VERTICES),
+                capacityFor(m_Indices.capacity(), m_Indices.used(), indexBytes, GL_GEOMETRY_POOL_MIN_INDEX_BYTES));
+        }
+
+    public:
+        GeometryPool(size_t stride, std::function<void()> attributes, size_t positionOffset = SIZE_MAX)
+            : m_Stride(stride), m_Attributes(std::move(attributes)), m_PositionOffset(positionOffset)
+        {
+        }
+
+        GeometryPool(const GeometryPool&) = delete;
+        GeometryPool& operator=(const GeometryPool&) = delete;
+
+        ~GeometryPool() {
+            if (m_IBO) getGLState().deleteBuffers(1, &m_IBO);
+            if (m_VBO) getGLState().deleteBuffers(1, &m_VBO);
+            if (m_VAO) getGLState().deleteVertexArrays(1, &m_VAO);
+            if (m_PositionVBO) getGLState().deleteBuffers(1, &m_PositionVBO);
+            if (m_DepthVAO) getGLState().deleteVertexArrays(1, &m_DepthVAO);
+        }
+
+        // Copy vertexCount vertices of the pool's stride and indexBytes of indices into a new block.
+        // INVALID if it still does not fit after growing, with nothing written.
+        Handle allocate(const void* vertices, size_t vertexCount, const void* indices, size_t indexBytes) {
+            if (!m_VAO) relocate(GL_GEOMETRY_POOL_MIN_VERTICES, GL_GEOMETRY_POOL_MIN_INDEX_BYTES);
+
+            Block block;
+            const size_t vertexSize = std::max<size_t>(vertexCount, 1);
+            const size_t indexSize = std::max<size_t>(indexUnits(indexBytes), 4);
+            auto reserve = [&]() {
+                if (!m_Vertices.allocate(vertexSize, block.firstVertex)) return false;
+                if (m_Indices.allocate(indexSize, block.indexOffset)) return true;
+                m_Vertices.release(block.firstVertex, vertexSize);
+                return false;
+            };
+            if (!reserve()) {
+                makeRoom(vertexSize, indexSize);
+                if (!reserve()) return INVALID;
+            }
+            block.vertexCount = vertexCount;
+            block.indexBytes = indexBytes;
+            block.live = true;
+
+            getGLState().bindBuffer(GL_COPY_WRITE_BUFFER, m_VBO);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, block.firstVertex * m_Stride, vertexCount * m_Stride, vertices);
+            getGLState().bindBuffer(GL_COPY_WRITE_BUFFER, m_IBO);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, block.indexOffset, indexBytes, indices);
+
+            if (hasPositions()) {
+                thread_local std::vector<float> positions;
+                positions.resize(vertexCount * 3);
+                const unsigned char* vertex = static_cast<const unsigned char*>(vertices) + m_PositionOffset;
+                for (size_t i = 0; i < vertexCount; i++, vertex += m_Stride) std::memcpy(&positions[i * 3], vertex, POSITION_SIZE);
+                getGLState().bindBuffer(GL_COPY_WRITE_BUFFER, m_PositionVBO);
+                glBufferSubData(GL_COPY_WRITE_BUFFER, block.firstVertex * POSITION_SIZE, vertexCount * POSITION_SIZE, positions.data());
+            }
+
+            Handle handle;
+            if (!m_FreeHandles.empty()) {
+                handle = m_FreeHandles.back();
+                m_FreeHandles.pop_back();
+                m_Blocks[handle] = block;
+            }
+            else {
+                handle = static_cast<Handle>(m_Blocks.size());
+                m_Blocks.push_back(block);
+            }
+            return handle;
+        }
+
+        void release(Handle handle) {
+            if (handle >= m_Blocks.size() || !m_Blocks[handle].live) return;
+            Block& block = m_Blocks[handle];
+            m_Vertices.release(block.firstVertex, std::max<size_t>(block.vertexCount, 1));
+            m_Indices.release(block.indexOffset, std::max<size_t>(indexUnits(block.indexBytes), 4));
+            block.live = false;
+            m_FreeHandles.push_back(handle);
+        }
+
+        // Close every hole left by released blocks (one GPU copy per block)
+        void compact() {
+            if (m_VAO && (m_Vertices.freeRanges() > 1 || m_Indices.freeRanges() > 1))
+                relocate(m_Vertices.capacity(), m_Indices.capacity());
+        }
+
+        const Block& block(Handle handle) const { return m_Blocks[handle]; }
+
+        GLuint vao() const { return m_VAO; }
+
+        // VAO with only the position stream at location 0, or 0 if this pool keeps none
+        GLuint depthVao() const { return m_DepthVAO; }
+
+        Stats stats() const {
+            Stats s;
+            s.blocks = m_Blocks.size() - m_FreeHandles.size();
+            s.vertexBytes = m_Vertices.used() * m_Stride;
+            s.indexBytes = m_Indices.used();
+            s.positionBytes = hasPositions() ? m_Vertices.used() * POSITION_SIZE : 0;
+            s.capacityBytes = m_Vertices.capacity() * (m_Stride + (hasPositions() ? POSITION_SIZE : 0)) + m_Indices.capacity();
+            s.freeRanges = m_Vertices.freeRanges() + m_Indices.freeRanges();
+            s.relocations = m_Relocations;
+            return s;
+        }
+    };
+
+} // namespace gl
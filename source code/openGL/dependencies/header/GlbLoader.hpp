@@ -0,0 +1,614 @@
+#pragma once
+
+#include <glm.hpp>
+
+#include <MeshCache.hpp>
+#include <ImageDecoder.hpp>
+
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Native reader for binary glTF 2.0 (.glb). The file is memory-mapped and accessors are exposed as
+// views into the BIN chunk, so GPU-ready streams can be uploaded without an intermediate copy.
+namespace gl {
+
+    // ============ JSON ============
+    // Just enough JSON for glTF: a DOM of values, objects keep their member order
+    namespace json {
+
+        class Value {
+        public:
+            enum class Type { Null, Bool, Number, String, Array, Object };
+
+            Type type = Type::Null;
+            bool boolean = false;
+            double number = 0.0;
+            std::string string;
+            std::vector<Value> items;
+            std::vector<std::pair<std::string, Value>> members;
+
+            // Missing keys and out-of-range indices yield a null value
+            const Value& operator[](const char* key) const {
+                for (const auto& [name, value] : members) {
+                    if (name == key) return value;
+                }
+                return null();
+            }
+
+            const Value& operator[](size_t index) const {
+                return index < items.size() ? items[index] : null();
+            }
+
+            const Value& operator[](int index) const {
+                return index >= 0 ? (*this)[size_t(index)] : null();
+            }
+
+            size_t size() const { return type == Type::Array ? items.size() : members.size(); }
+
+            bool isNull() const { return type == Type::Null; }
+
+            double asNumber(double fallback = 0.0) const { return type == Type::Number ? number : fallback; }
+
+            int asInt(int fallback = -1) const { return type == Type::Number ? static_cast<int>(number) : fallback; }
+
+            bool asBool(bool fallback = false) const { return type == Type::Bool ? boolean : fallback; }
+
+            const std::string& asString() const { return string; }
+
+        private:
+            static const Value& null() {
+                static const Value value;
+                return value;
+            }
+        };
+
+        class Parser {
+        private:
+            const char* m_Cursor;
+            const char* m_End;
+            int m_Depth = 0;
+
+            void skipWhitespace() {
+                while (m_Cursor < m_End && (*m_Cursor == ' ' || *m_Cursor == '\t' || *m_Cursor == '\n' || *m_Cursor == '\r')) m_Cursor++;
+            }
+
+            bool consume(char c) {
+                skipWhitespace();
+                if (m_Cursor < m_End && *m_Cursor == c) {
+                    m_Cursor++;
+                    return true;
+                }
+                return false;
+            }
+
+            bool literal(const char* word) {
+                size_t length = std::strlen(word);
+                if (size_t(m_End - m_Cursor) < length || std::memcmp(m_Cursor, word, length) != 0) return false;
+                m_Cursor += length;
+                return true;
+            }
+
+            static void appendUtf8(std::string& out, uint32_t cp) {
+                if (cp < 0x80) out += static_cast<char>(cp);
+                else if (cp < 0x800) {
+                    out += static_cast<char>(0xC0 | (cp >> 6));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                }
+                else if (cp < 0x10000) {
+                    out += static_cast<char>(0xE0 | (cp >> 12));
+                    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                }
+                else {
+                    out += static_cast<char>(0xF0 | (cp >> 18));
+                    out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (cp & 0x3F));
+                }
+            }
+
+            bool parseHex4(uint32_t& out) {
+                if (m_End - m_Cursor < 4) return false;
+                out = 0;
+                for (int i = 0; i < 4; i++) {
+                    char c = *m_Cursor++;
+                    out <<= 4;
+                    if (c >= '0' && c <= '9') out |= uint32_t(c - '0');
+                    else if (c >= 'a' && c <= 'f') out |= uint32_t(c - 'a' + 10);
+                    else if (c >= 'A' && c <= 'F') out |= uint32_t(c - 'A' + 10);
+                    else return false;
+                }
+                return true;
+            }
+
+            bool parseString(std::string& out) {
+                if (!consume('"')) return false;
+                out.clear();
+                while (m_Cursor < m_End) {
+                    char c = *m_Cursor++;
+                    if (c == '"') return true;
+                    if (c != '\\') {
+                        out += c;
+                        continue;
+                    }
+                    if (m_Cursor >= m_End) return false;
+                    switch (*m_Cursor++) {
+                    case '"': out += '"'; break;
+                    case '\\': out += '\\'; break;
+                    case '/': out += '/'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'u': {
+                        uint32_t cp;
+                        if (!parseHex4(cp)) return false;
+                        // Surrogate pair
+                        if (cp >= 0xD800 && cp < 0xDC00 && m_End - m_Cursor >= 6 && m_Cursor[0] == '\\' && m_Cursor[1] == 'u') {
+                            m_Cursor += 2;
+                            uint32_t low;
+                            if (!parseHex4(low)) return false;
+                            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                        appendUtf8(out, cp);
+                        break;
+                    }
+                    default: return false;
+                    }
+                }
+                return false;
+            }
+
+            bool parseValue(Value& out) {
+                if (++m_Depth > 256) return false;
+                skipWhitespace();
+                if (m_Cursor >= m_End) return false;
+
+                bool ok = false;
+                switch (*m_Cursor) {
+                case '{': {
+                    m_Cursor++;
+                    out.type = Value::Type::Object;
+                    if (consume('}')) {
+                        ok = true;
+                        break;
+                    }
+                    bool member = true;
+                    do {
+                        out.members.emplace_back();
+                        member = parseString(out.members.back().first) && consume(':') && parseValue(out.members.back().second);
+                    } while (member && consume(','));
+                    ok = member && consume('}');
+                    break;
+                }
+                case '[': {
+                    m_Cursor++;
+                    out.type = Value::Type::Array;
+                    if (consume(']')) {
+                        ok = true;
+                        break;
+                    }
+                    bool item = true;
+                    do {
+                        out.items.emplace_back();
+                        item = parseValue(out.items.back());
+                    } while (item && consume(','));
+                    ok = item && consume(']');
+                    break;
+                }
+                case '"':
+                    out.type = Value::Type::String;
+                    ok = parseString(out.string);
+                    break;
+                case 't':
+                    out.type = Value::Type::Bool;
+                    out.boolean = true;
+                    ok = literal("true");
+                    break;
+                case 'f':
+                    out.type = Value::Type::Bool;
+                    ok = literal("false");
+                    break;
+                case 'n':
+                    ok = literal("null");
+                    break;
+                default: {
+                    out.type = Value::Type::Number;
+                    const char* start = m_Cursor;
+                    if (*start == '+') start++; // from_chars rejects a leading '+'
+                    auto result = std::from_chars(start, m_End, out.number);
+                    ok = result.ec == std::errc();
+                    m_Cursor = result.ptr;
+                    break;
+                }
+                }
+
+                m_Depth--;
+                return ok;
+            }
+
+        public:
+            Parser(const char* text, size_t length) : m_Cursor(text), m_End(text + length) {}
+
+            bool parse(Value& out) {
+                if (!parseValue(out)) return false;
+                skipWhitespace();
+                // The GLB JSON chunk may be padded with spaces or NULs
+                while (m_Cursor < m_End && *m_Cursor == '\0') m_Cursor++;
+                return m_Cursor == m_End;
+            }
+        };
+
+        inline bool parse(const char* text, size_t length, Value& out) {
+            out = Value();
+            return Parser(text, length).parse(out);
+        }
+
+    }
+
+    namespace glb {
+
+        // Component types; glTF uses the GL enum values
+        constexpr unsigned int BYTE = 5120;
+        constexpr unsigned int UNSIGNED_BYTE = 5121;
+        constexpr unsigned int SHORT = 5122;
+        constexpr unsigned int UNSIGNED_SHORT = 5123;
+        constexpr unsigned int UNSIGNED_INT = 5125;
+        constexpr unsigned int FLOAT = 5126;
+
+        constexpr uint32_t MAGIC = 0x46546C67;      // "glTF"
+        constexpr uint32_t CHUNK_JSON = 0x4E4F534A; // "JSON"
+        constexpr uint32_t CHUNK_BIN = 0x004E4942;  // "BIN\0"
+
+        inline size_t componentSize(unsigned int componentType) {
+            switch (componentType) {
+            case BYTE: case UNSIGNED_BYTE: return 1;
+            case SHORT: case UNSIGNED_SHORT: return 2;
+            case UNSIGNED_INT: case FLOAT: return 4;
+            default: return 0;
+            }
+        }
+
+        inline int componentCount(const std::string& type) {
+            if (type == "SCALAR") return 1;
+            if (type == "VEC2") return 2;
+            if (type == "VEC3") return 3;
+            if (type == "VEC4") return 4;
+            return 0;
+        }
+
+    }
+
+    // ============ GLB ACCESSOR ============
+    // A typed, strided view into the mapped BIN chunk
+    struct GlbAccessor {
+        const unsigned char* data = nullptr; // first element
+        size_t count = 0;
+        size_t stride = 0;      // bytes between elements
+        size_t elementSize = 0; // bytes per element
+        unsigned int componentType = 0;
+        int components = 0;
+        bool normalized = false;
+        bool hasBounds = false;
+        glm::vec3 minBounds = glm::vec3(0.0f);
+        glm::vec3 maxBounds = glm::vec3(0.0f);
+
+        bool valid() const { return data != nullptr; }
+
+        bool tight() const { return stride == elementSize; }
+
+        bool is(unsigned int type, int comps) const { return valid() && componentType == type && components == comps; }
+
+        // Bytes from the first to the end of the last element, i.e. what a GL buffer needs
+        size_t byteLength() const { return count ? (count - 1) * stride + elementSize : 0; }
+
+        // Element i as floats, applying normalisation
+        glm::vec4 read(size_t i) const {
+            glm::vec4 out(0.0f, 0.0f, 0.0f, 1.0f);
+            const unsigned char* p = data + i * stride;
+            if (componentType == glb::FLOAT) {
+                std::memcpy(&out[0], p, sizeof(float) * size_t(components < 4 ? components : 4));
+                return out;
+            }
+            for (int c = 0; c < components && c < 4; c++) {
+                switch (componentType) {
+                case glb::FLOAT: { float v; std::memcpy(&v, p + c * 4, 4); out[c] = v; break; }
+                case glb::UNSIGNED_BYTE: { float v = p[c]; out[c] = normalized ? v / 255.0f : v; break; }
+                case glb::BYTE: { float v = static_cast<int8_t>(p[c]); out[c] = normalized ? glm::max(v / 127.0f, -1.0f) : v; break; }
+                case glb::UNSIGNED_SHORT: { uint16_t v; std::memcpy(&v, p + c * 2, 2); out[c] = normalized ? v / 65535.0f : float(v); break; }
+                case glb::SHORT: { int16_t v; std::memcpy(&v, p + c * 2, 2); out[c] = normalized ? glm::max(v / 32767.0f, -1.0f) : float(v); break; }
+                case glb::UNSIGNED_INT: { uint32_t v; std::memcpy(&v, p + c * 4, 4); out[c] = float(v); break; }
+                }
+            }
+            return out;
+        }
+
+        unsigned int readIndex(size_t i) const {
+            const unsigned char* p = data + i * stride;
+            switch (componentType) {
+            case glb::UNSIGNED_BYTE: return p[0];
+            case glb::UNSIGNED_SHORT: { uint16_t v; std::memcpy(&v, p, 2); return v; }
+            case glb::UNSIGNED_INT: { uint32_t v; std::memcpy(&v, p, 4); return v; }
+            default: return 0;
+            }
+        }
+    };
+
+    // One triangle-list primitive; attributes that are absent have !valid()
+    struct GlbPrimitive {
+        GlbAccessor position;
+        GlbAccessor normal;
+        GlbAccessor texCoord;
+        GlbAccessor tangent; // xyz + handedness in w
+        GlbAccessor indices;
+        int material = -1;
+
+        size_t vertexCount() const { return position.count; }
+
+        size_t indexCount() const { return indices.valid() ? indices.count : position.count; }
+
+        unsigned int index(size_t i) const { return indices.valid() ? indices.readIndex(i) : static_cast<unsigned int>(i); }
+    };
+
+    // ============ GLB FILE ============
+    class GlbFile {
+    private:
+        MappedFile m_File;
+        json::Value m_Json;
+        const unsigned char* m_Bin = nullptr;
+        size_t m_BinSize = 0;
+
+        static void collectNode(const json::Value& nodes, int index, std::vector<int>& meshes, int depth) {
+            const json::Value& node = nodes[index];
+            if (node.isNull() || depth > 64) return;
+
+            int mesh = node["mesh"].asInt();
+            if (mesh >= 0) meshes.push_back(mesh);
+
+            const json::Value& children = node["children"];
+            for (size_t i = 0; i < children.size(); i++) collectNode(nodes, children[i].asInt(), meshes, depth + 1);
+        }
+
+    public:
+        static bool isGlb(const std::string& path) {
+            if (path.size() < 4) return false;
+            std::string ext = path.substr(path.size() - 4);
+            for (auto& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            return ext == ".glb";
+        }
+
+        bool open(const std::string& path) {
+            m_Bin = nullptr;
+            m_BinSize = 0;
+            if (!m_File.open(path) || m_File.size() < 20) return false;
+
+            const unsigned char* base = m_File.data();
+            uint32_t header[3];
+            std::memcpy(header, base, sizeof(header));
+            if (header[0] != glb::MAGIC || header[1] != 2 || header[2] > m_File.size()) return false;
+
+            bool hasJson = false;
+            size_t offset = 12;
+            while (offset + 8 <= header[2]) {
+                uint32_t chunk[2];
+                std::memcpy(chunk, base + offset, sizeof(chunk));
+                offset += 8;
+                if (offset + chunk[0] > header[2]) return false;
+
+                if (chunk[1] == glb::CHUNK_JSON && !hasJson) {
+                    if (!json::parse(reinterpret_cast<const char*>(base + offset), chunk[0], m_Json)) return false;
+                    hasJson = true;
+                }
+                else if (chunk[1] == glb::CHUNK_BIN && !m_Bin) {
+                    m_Bin = base + offset;
+                    m_BinSize = chunk[0];
+                }
+                offset += (chunk[0] + 3) & ~size_t(3);
+            }
+            return hasJson;
+        }
+
+        const json::Value& json() const { return m_Json; }
+
+        // Bytes of a bufferView inside the BIN chunk, or nullptr for external/data-URI buffers
+        const unsigned char* bufferView(int index, size_t& size, size_t* stride = nullptr) const {
+            const json::Value& view = m_Json["bufferViews"][index];
+            if (view.isNull() || !m_Bin || view["buffer"].asInt(0) != 0) return nullptr;
+
+            const size_t offset = static_cast<size_t>(view["byteOffset"].asNumber(0.0));
+            size = static_cast<size_t>(view["byteLength"].asNumber(0.0));
+            if (stride) *stride = static_cast<size_t>(view["byteStride"].asNumber(0.0));
+            if (offset + size > m_BinSize) return nullptr;
+            return m_Bin + offset;
+        }
+
+        // False for anything we do not read natively (sparse accessors, external buffers, bad ranges)
+        bool accessor(int index, GlbAccessor& out) const {
+            out = GlbAccessor();
+            const json::Value& acc = m_Json["accessors"][index];
+            if (acc.isNull() || !acc["sparse"].isNull()) return false;
+
+            out.componentType = static_cast<unsigned int>(acc["componentType"].asInt(0));
+            out.components = glb::componentCount(acc["type"].asString());
+            out.count = static_cast<size_t>(acc["count"].asNumber(0.0));
+            out.normalized = acc["normalized"].asBool();
+            out.elementSize = glb::componentSize(out.componentType) * size_t(out.components);
+            if (!out.elementSize || !out.count) return false;
+
+            size_t viewSize = 0, viewStride = 0;
+            const unsigned char* view = bufferView(acc["bufferView"].asInt(), viewSize, &viewStride);
+            if (!view) return false;
+
+            const size_t offset = static_cast<size_t>(acc["byteOffset"].asNumber(0.0));
+            out.stride = viewStride ? viewStride : out.elementSize;
+            if (offset + out.byteLength() > viewSize) return false;
+            out.data = view + offset;
+
+            const json::Value& lo = acc["min"];
+            const json::Value& hi = acc["max"];
+            if (out.components == 3 && lo.size() == 3 && hi.size() == 3) {
+                out.hasBounds = true;
+                out.minBounds = glm::vec3(lo[0].asNumber(), lo[1].asNumber(), lo[2].asNumber());
+                out.maxBounds = glm::vec3(hi[0].asNumber(), hi[1].asNumber(), hi[2].asNumber());
+            }
+            return true;
+        }
+
+        // Triangle primitives of every mesh referenced by the default scene, in node order
+        // (the same order Assimp hands them to Object::collectMeshes). Node transforms are ignored, as there.
+        // Returns false if anything needs Assimp instead (non-triangle modes, sparse or external data).
+        bool collectPrimitives(std::vector<GlbPrimitive>& out) const {
+            out.clear();
+            const json::Value& meshes = m_Json["meshes"];
+            const json::Value& nodes = m_Json["nodes"];
+            const json::Value& scenes = m_Json["scenes"];
+
+            std::vector<int> meshOrder;
+            const json::Value& scene = scenes[m_Json["scene"].asInt(0)];
+            if (!scene.isNull()) {
+                const json::Value& roots = scene["nodes"];
+                for (size_t i = 0; i < roots.size(); i++) collectNode(nodes, roots[i].asInt(), meshOrder, 0);
+            }
+            else {
+                for (size_t i = 0; i < meshes.size(); i++) meshOrder.push_back(static_cast<int>(i));
+            }
+
+            for (int m : meshOrder) {
+                const json::Value& primitives = meshes[m]["primitives"];
+                for (size_t p = 0; p < primitives.size(); p++) {
+                    const json::Value& prim = primitives[p];
+                    if (prim["mode"].asInt(4) != 4) return false;
+
+                    GlbPrimitive result;
+                    const json::Value& attributes = prim["attributes"];
+                    if (!accessor(attributes["POSITION"].asInt(), result.position) || !result.position.is(glb::FLOAT, 3)) return false;
+
+                    // Readers index optional attributes by vertex and assume these layouts, so anything else
+                    // (wrong type, too few elements) goes to Assimp rather than past the end of the BIN chunk
+                    auto optional = [&](const char* name, GlbAccessor& target, int components, bool normalizedOk) {
+                        const json::Value& index = attributes[name];
+                        if (index.isNull()) return true;
+                        if (!accessor(index.asInt(), target) || target.components != components || target.count != result.position.count) return false;
+                        if (target.componentType == glb::FLOAT) return !target.normalized;
+                        return normalizedOk && target.normalized &&
+                            (target.componentType == glb::UNSIGNED_BYTE || target.componentType == glb::UNSIGNED_SHORT);
+                    };
+                    if (!optional("NORMAL", result.normal, 3, false) || !optional("TEXCOORD_0", result.texCoord, 2, true) ||
+                        !optional("TANGENT", result.tangent, 4, false)) return false;
+
+                    if (!prim["indices"].isNull()) {
+                        if (!accessor(prim["indices"].asInt(), result.indices) || result.indices.components != 1) return false;
+                        for (size_t i = 0; i < result.indices.count; i++) {
+                            if (result.indices.readIndex(i) >= result.position.count) return false;
+                        }
+                    }
+
+                    result.material = prim["material"].asInt();
+                    out.push_back(result);
+                }
+            }
+            return true;
+        }
+
+        // Embedded images used by the materials, each with the sampler slots it feeds. The first material
+        // to use a slot wins, as textures are bound per Object. Images given by URI are skipped.
+        void collectImages(std::vector<EmbeddedImage>& out) const {
+            out.clear();
+            const json::Value& materials = m_Json["materials"];
+            const json::Value& textures = m_Json["textures"];
+            const json::Value& images = m_Json["images"];
+            std::vector<int> imageSlot(images.size(), -1);
+
+            auto add = [&](const json::Value& textureInfo, const char* slotName) {
+                int image = textures[textureInfo["index"].asInt()]["source"].asInt();
+                if (image < 0 || size_t(image) >= images.size()) return;
+
+                if (imageSlot[image] < 0) {
+                    EmbeddedImage embedded;
+                    embedded.data = bufferView(images[image]["bufferView"].asInt(), embedded.size);
+                    if (!embedded.data) return;
+                    imageSlot[image] = static_cast<int>(out.size());
+                    out.push_back(embedded);
+                }
+                EmbeddedImage::assign(out, size_t(imageSlot[image]), slotName);
+            };
+
+            for (size_t m = 0; m < materials.size(); m++) {
+                const json::Value& material = materials[m];
+                const json::Value& pbr = material["pbrMetallicRoughness"];
+                add(pbr["baseColorTexture"], slot::BASE_COLOR);
+                add(pbr["metallicRoughnessTexture"], slot::METALLIC_ROUGHNESS);
+                add(material["normalTexture"], slot::NORMAL);
+                add(material["occlusionTexture"], slot::OCCLUSION);
+                add(material["emissiveTexture"], slot::EMISSIVE);
+            }
+
+            // Images whose slots were all taken by earlier materials are never bound
+            std::erase_if(out, [](const EmbeddedImage& image) { return image.slots.empty(); });
+        }
+    };
+
+    namespace glb {
+
+        // Area-weighted smooth normals for primitives without NORMAL
+        inline void generateNormals(const GlbPrimitive& prim, std::vector<glm::vec3>& normals) {
+            normals.assign(prim.vertexCount(), glm::vec3(0.0f));
+            for (size_t i = 0; i + 2 < prim.indexCount(); i += 3) {
+                unsigned int a = prim.index(i), b = prim.index(i + 1), c = prim.index(i + 2);
+                glm::vec3 pa = prim.position.read(a), pb = prim.position.read(b), pc = prim.position.read(c);
+                glm::vec3 n = glm::cross(pb - pa, pc - pa);
+                normals[a] += n;
+                normals[b] += n;
+                normals[c] += n;
+            }
+            for (auto& n : normals) {
+                float length = glm::length(n);
+                n = length > 0.0f ? n / length : glm::vec3(0.0f, 1.0f, 0.0f);
+            }
+        }
+
+        // Per-vertex tangents with handedness (Lengyel) for primitives without TANGENT; needs texCoords
+        inline void generateTangents(const GlbPrimitive& prim, const std::vector<glm::vec3>* generatedNormals, std::vector<glm::vec4>& tangents) {
+            const size_t vertexCount = prim.vertexCount();
+            std::vector<glm::vec3> tan(vertexCount, glm::vec3(0.0f)), bitan(vertexCount, glm::vec3(0.0f));
+
+            for (size_t i = 0; i + 2 < prim.indexCount(); i += 3) {
+                unsigned int v[3] = { prim.index(i), prim.index(i + 1), prim.index(i + 2) };
+                glm::vec3 p0 = prim.position.read(v[0]), p1 = prim.position.read(v[1]), p2 = prim.position.read(v[2]);
+                glm::vec2 t0 = prim.texCoord.read(v[0]), t1 = prim.texCoord.read(v[1]), t2 = prim.texCoord.read(v[2]);
+
+                glm::vec3 e1 = p1 - p0, e2 = p2 - p0;
+                glm::vec2 d1 = t1 - t0, d2 = t2 - t0;
+                float det = d1.x * d2.y - d2.x * d1.y;
+                if (std::fabs(det) < 1e-12f) continue;
+                float r = 1.0f / det;
+
+                glm::vec3 t = (e1 * d2.y - e2 * d1.y) * r;
+                glm::vec3 b = (e2 * d1.x - e1 * d2.x) * r;
+                for (unsigned int k : v) {
+                    tan[k] += t;
+                    bitan[k] += b;
+                }
+            }
+
+            tangents.resize(vertexCount);
+            for (size_t i = 0; i < vertexCount; i++) {
+                glm::vec3 n = generatedNormals ? (*generatedNormals)[i] : glm::vec3(prim.normal.read(i));
+                glm::vec3 t = tan[i] - n * glm::dot(n, tan[i]);
+                float length = glm::length(t);
+                t = length > 0.0f ? t / length : glm::vec3(1.0f, 0.0f, 0.0f);
+                float w = glm::dot(glm::cross(n, t), bitan[i]) < 0.0f ? -1.0f : 1.0f;
+                tangents[i] = glm::vec4(t, w);
+            }
+        }
+
+    }
+
+} // namespace gl
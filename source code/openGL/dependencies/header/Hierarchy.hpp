@@ -0,0 +1,341 @@
+#pragma once
+
+#include <glm.hpp>
+#include <gtc/quaternion.hpp>
+
+#include <SlotMap.hpp>
+#include <ThreadPool.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Nodes at one depth before TransformHierarchy::update splits that depth over the thread pool
+#ifndef GL_HIERARCHY_PARALLEL_MIN
+#define GL_HIERARCHY_PARALLEL_MIN 4096
+#endif
+
+namespace gl {
+
+    // Split an affine matrix into translation, rotation and scale. Shear (non-uniform scale under a rotated
+    // child) has no TRS form and is dropped; a mirroring matrix gets a negative x scale.
+    inline void decomposeTrs(const glm::mat4& m, glm::vec3& position, glm::quat& rotation, glm::vec3& scale) {
+        position = glm::vec3(m[3]);
+        glm::mat3 r(m);
+        scale = glm::vec3(glm::length(r[0]), glm::length(r[1]), glm::length(r[2]));
+        if (glm::determinant(r) < 0.0f) scale.x = -scale.x;
+        for (int i = 0; i < 3; i++) {
+            if (scale[i] != 0.0f) r[i] /= scale[i];
+        }
+        rotation = glm::normalize(glm::quat_cast(r));
+    }
+
+    struct HierarchyStats {
+        size_t nodes = 0;       // live
+        size_t dirty = 0;       // nodes changed since the previous update
+        size_t recomputed = 0;  // world matrices computed by the last update: the dirty nodes and their subtrees
+        size_t levels = 0;      // depths the last update touched
+        size_t parallelLevels = 0;
+    };
+
+    // ============ TRANSFORM HIERARCHY ============
+    // Parent-linked nodes with a local transform (position, rotation, scale, or an explicit matrix) and a cached
+    // world matrix = parent world * local. Setters only mark the node dirty; update() recomputes the dirty
+    // nodes and everything below them, one depth at a time so each node's parent is already done. The nodes
+    // of a depth are independent, so large depths run in parallel chunks on the thread pool.
+    class TransformHierarchy {
+    private:
+        static constexpr uint32_t NONE = UINT32_MAX;
+
+        // Links and flags, kept apart from the transforms so walking the tree stays in cache
+        struct Node {
+            uint32_t parent = NONE;
+            uint32_t firstChild = NONE;
+            uint32_t nextSibling = NONE; // next free node while on the free list
+            uint32_t prevSibling = NONE;
+            uint32_t depth = 0;
+            uint32_t generation = 1;
+            uint32_t queued = 0;         // update() that last scheduled this node
+            bool alive = false;
+            bool dirty = false;          // local changed since the last update
+            bool explicitLocal = false;  // local set by setLocalMatrix, not from position/rotation/scale
+        };
+
+        struct Trs {
+            glm::vec3 position = glm::vec3(0.0f);
+            glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+            glm::vec3 scale = glm::vec3(1.0f);
+        };
+
+        std::vector<Node> m_Nodes;
+        std::vector<Trs> m_Trs;
+        std::vector<glm::mat4> m_Local;
+        std::vector<glm::mat4> m_World;
+        std::vector<void*> m_Users; // setUser
+        uint32_t m_FreeList = NONE;
+        std::vector<uint32_t> m_Dirty;
+        std::vector<std::vector<uint32_t>> m_Levels; // update() scratch, nodes per depth
+        uint32_t m_Update = 0;
+        HierarchyStats m_Stats;
+
+        void markDirty(uint32_t index) {
+            if (m_Nodes[index].dirty) return;
+            m_Nodes[index].dirty = true;
+            m_Dirty.push_back(index);
+        }
+
+        void unlink(uint32_t index) {
+            Node& n = m_Nodes[index];
+            if (n.prevSibling != NONE) m_Nodes[n.prevSibling].nextSibling = n.nextSibling;
+            else if (n.parent != NONE) m_Nodes[n.parent].firstChild = n.nextSibling;
+            if (n.nextSibling != NONE) m_Nodes[n.nextSibling].prevSibling = n.prevSibling;
+            n.parent = n.nextSibling = n.prevSibling = NONE;
+        }
+
+        void link(uint32_t index, uint32_t parent) {
+            Node& n = m_Nodes[index];
+            n.parent = parent;
+            if (parent == NONE) return;
+            n.nextSibling = m_Nodes[parent].firstChild;
+            if (n.nextSibling != NONE) m_Nodes[n.nextSibling].prevSibling = index;
+            m_Nodes[parent].firstChild = index;
+        }
+
+        // New depths below index after it moved; the world matrices follow from marking index dirty
+        void setDepths(uint32_t index, uint32_t depth) {
+            thread_local std::vector<std::pair<uint32_t, uint32_t>> stack;
+            stack.clear();
+            stack.push_back({ index, depth });
+            while (!stack.empty()) {
+                const auto [i, d] = stack.back();
+                stack.pop_back();
+                m_Nodes[i].depth = d;
+                for (uint32_t c = m_Nodes[i].firstChild; c != NONE; c = m_Nodes[c].nextSibling) stack.push_back({ c, d + 1 });
+            }
+        }
+
+        static glm::mat4 compose(const Trs& t) {
+            const glm::mat3 r = glm::mat3_cast(t.rotation);
+            return glm::mat4(glm::vec4(r[0] * t.scale.x, 0.0f), glm::vec4(r[1] * t.scale.y, 0.0f),
+                glm::vec4(r[2] * t.scale.z, 0.0f), glm::vec4(t.position, 1.0f));
+        }
+
+        // Local matrix as last set, whether or not update() has run since
+        glm::mat4 currentLocal(uint32_t index) const {
+            return m_Nodes[index].explicitLocal ? m_Local[index] : compose(m_Trs[index]);
+        }
+
+        void recompute(uint32_t index) {
+            Node& n = m_Nodes[index];
+            if (n.dirty) {
+                if (!n.explicitLocal) m_Local[index] = compose(m_Trs[index]);
+                n.dirty = false;
+            }
+            m_World[index] = n.parent == NONE ? m_Local[index] : m_World[n.parent] * m_Local[index];
+        }
+
+    public:
+        bool valid(SlotHandle handle) const {
+            return handle.generation != 0 && handle.index < m_Nodes.size() && m_Nodes[handle.index].alive
+                && m_Nodes[handle.index].generation == handle.generation;
+        }
+
+        // Identity node under parent (a root if parent is invalid)
+        SlotHandle create(SlotHandle parent = SlotHandle()) {
+            uint32_t index;
+            if (m_FreeList != NONE) {
+                index = m_FreeList;
+                m_FreeList = m_Nodes[index].nextSibling;
+                const uint32_t generation = m_Nodes[index].generation;
+                m_Nodes[index] = Node();
+                m_Nodes[index].generation = generation;
+                m_Trs[index] = Trs();
+                m_Local[index] = glm::mat4(1.0f);
+                m_Users[index] = nullptr;
+            }
+            else {
+                index = static_cast<uint32_t>(m_Nodes.size());
+                m_Nodes.emplace_back();
+                m_Trs.emplace_back();
+                m_Local.emplace_back(1.0f);
+                m_World.emplace_back(1.0f);
+                m_Users.push_back(nullptr);
+            }
+            m_Nodes[index].alive = true;
+            const uint32_t parentIndex = valid(parent) ? parent.index : NONE;
+            link(index, parentIndex);
+            m_Nodes[index].depth = parentIndex == NONE ? 0 : m_Nodes[parentIndex].depth + 1;
+            markDirty(index);
+            m_Stats.nodes++;
+            return { index, m_Nodes[index].generation };
+        }
+
+        // Children move up to the node's parent and keep their world transforms: each local becomes the node's
+        // local times its own, kept as position/rotation/scale (see decomposeTrs) unless either was a matrix
+        bool destroy(SlotHandle handle) {
+            if (!valid(handle)) return false;
+            const uint32_t index = handle.index;
+            const uint32_t parent = m_Nodes[index].parent;
+            const glm::mat4 local = currentLocal(index);
+            while (m_Nodes[index].firstChild != NONE) {
+                const uint32_t child = m_Nodes[index].firstChild;
+                const glm::mat4 rebased = local * currentLocal(child);
+                if (m_Nodes[index].explicitLocal || m_Nodes[child].explicitLocal) m_Local[child] = rebased;
+                else decomposeTrs(rebased, m_Trs[child].position, m_Trs[child].rotation, m_Trs[child].scale);
+                m_Nodes[child].explicitLocal = m_Nodes[index].explicitLocal || m_Nodes[child].explicitLocal;
+
+                unlink(child);
+                link(child, parent);
+                setDepths(child, parent == NONE ? 0 : m_Nodes[parent].depth + 1);
+                markDirty(child);
+            }
+            unlink(index);
+
+            m_Users[index] = nullptr;
+            Node& n = m_Nodes[index];
+            n.alive = false;
+            n.dirty = false; // a stale m_Dirty entry is skipped
+            if (++n.generation == 0) n.generation = 1;
+            n.nextSibling = m_FreeList;
+            m_FreeList = index;
+            m_Stats.nodes--;
+            return true;
+        }
+
+        // Reparent, keeping the local transform; an invalid parent makes handle a root. False if handle is
+        // stale or parent is handle itself or below it.
+        bool setParent(SlotHandle handle, SlotHandle parent) {
+            if (!valid(handle)) return false;
+            const uint32_t parentIndex = valid(parent) ? parent.index : NONE;
+            for (uint32_t p = parentIndex; p != NONE; p = m_Nodes[p].parent) {
+                if (p == handle.index) return false;
+            }
+            if (m_Nodes[handle.index].parent == parentIndex) return true;
+            unlink(handle.index);
+            link(handle.index, parentIndex);
+            setDepths(handle.index, parentIndex == NONE ? 0 : m_Nodes[parentIndex].depth + 1);
+            markDirty(handle.index);
+            return true;
+        }
+
+        SlotHandle getParent(SlotHandle handle) const {
+            if (!valid(handle) || m_Nodes[handle.index].parent == NONE) return SlotHandle();
+            const uint32_t parent = m_Nodes[handle.index].parent;
+            return { parent, m_Nodes[parent].generation };
+        }
+
+        void getChildren(SlotHandle handle, std::vector<SlotHandle>& out) const {
+            out.clear();
+            if (!valid(handle)) return;
+            for (uint32_t c = m_Nodes[handle.index].firstChild; c != NONE; c = m_Nodes[c].nextSibling)
+                out.push_back({ c, m_Nodes[c].generation });
+        }
+
+        // Anything the owner wants to find from a node, e.g. the object it positions; nullptr by default
+        void setUser(SlotHandle handle, void* user) {
+            if (valid(handle)) m_Users[handle.index] = user;
+        }
+
+        void* getUser(SlotHandle handle) const { return valid(handle) ? m_Users[handle.index] : nullptr; }
+
+        // Marks the node dirty only if something changed
+        void setLocal(SlotHandle handle, const glm::vec3& position, const glm::quat& rotation, const glm::vec3& scale) {
+            if (!valid(handle)) return;
+            Trs& t = m_Trs[handle.index];
+            const bool wasExplicit = m_Nodes[handle.index].explicitLocal;
+            if (!wasExplicit && t.position == position && t.rotation == rotation && t.scale == scale) return;
+            t = { position, rotation, scale };
+            m_Nodes[handle.index].explicitLocal = false;
+            markDirty(handle.index);
+        }
+
+        void setPosition(SlotHandle handle, const glm::vec3& position) {
+            if (valid(handle)) setLocal(handle, position, m_Trs[handle.index].rotation, m_Trs[handle.index].scale);
+        }
+
+        void setRotation(SlotHandle handle, const glm::quat& rotation) {
+            if (valid(handle)) setLocal(handle, m_Trs[handle.index].position, rotation, m_Trs[handle.index].scale);
+        }
+
+        void setScale(SlotHandle handle, const glm::vec3& scale) {
+            if (valid(handle)) setLocal(handle, m_Trs[handle.index].position, m_Trs[handle.index].rotation, scale);
+        }
+
+        // Any affine local transform, e.g. a camera's inverse view; used until the next setLocal
+        void setLocalMatrix(SlotHandle handle, const glm::mat4& local) {
+            if (!valid(handle)) return;
+            if (m_Nodes[handle.index].explicitLocal && m_Local[handle.index] == local) return;
+            m_Local[handle.index] = local;
+            m_Nodes[handle.index].explicitLocal = true;
+            markDirty(handle.index);
+        }
+
+        // As of the last update(); handle must be valid
+        const glm::mat4& getLocalMatrix(SlotHandle handle) const { return m_Local[handle.index]; }
+        const glm::mat4& getWorld(SlotHandle handle) const { return m_World[handle.index]; }
+
+        // From the transforms as last set, without waiting for update(); walks up to the root
+        glm::mat4 computeLocal(SlotHandle handle) const { return valid(handle) ? currentLocal(handle.index) : glm::mat4(1.0f); }
+
+        glm::mat4 computeWorld(SlotHandle handle) const {
+            if (!valid(handle)) return glm::mat4(1.0f);
+            glm::mat4 world = currentLocal(handle.index);
+            for (uint32_t p = m_Nodes[handle.index].parent; p != NONE; p = m_Nodes[p].parent) world = currentLocal(p) * world;
+            return world;
+        }
+
+        // Recompute the world matrices of dirty nodes and their subtrees, shallowest depth first
+        void update() {
+            if (++m_Update == 0) { // queued stamps wrapped: clear them
+                for (Node& n : m_Nodes) n.queued = 0;
+                m_Update = 1;
+            }
+            m_Stats.dirty = m_Dirty.size();
+            m_Stats.recomputed = m_Stats.levels = m_Stats.parallelLevels = 0;
+            for (auto& level : m_Levels) level.clear();
+
+            for (uint32_t index : m_Dirty) {
+                Node& n = m_Nodes[index];
+                if (!n.alive || !n.dirty || n.queued == m_Update) continue;
+                n.queued = m_Update;
+                if (m_Levels.size() <= n.depth) m_Levels.resize(size_t(n.depth) + 1);
+                m_Levels[n.depth].push_back(index);
+            }
+            m_Dirty.clear();
+
+            for (size_t d = 0; d < m_Levels.size(); d++) {
+                if (m_Levels[d].empty()) continue;
+                if (m_Levels.size() <= d + 1) m_Levels.resize(d + 2);
+                std::vector<uint32_t>& level = m_Levels[d];
+                std::vector<uint32_t>& next = m_Levels[d + 1];
+
+                // Index order keeps the matrix arrays streaming rather than jumping around
+                if (!std::is_sorted(level.begin(), level.end())) std::sort(level.begin(), level.end());
+                if (level.size() >= GL_HIERARCHY_PARALLEL_MIN) {
+                    const size_t chunk = GL_HIERARCHY_PARALLEL_MIN / 2;
+                    getThreadPool().parallelFor((level.size() + chunk - 1) / chunk, [&](size_t c) {
+                        const size_t end = std::min(level.size(), (c + 1) * chunk);
+                        for (size_t k = c * chunk; k < end; k++) recompute(level[k]);
+                    });
+                    m_Stats.parallelLevels++;
+                }
+                else {
+                    for (uint32_t index : level) recompute(index);
+                }
+                m_Stats.recomputed += level.size();
+                m_Stats.levels++;
+
+                for (uint32_t index : level) {
+                    for (uint32_t c = m_Nodes[index].firstChild; c != NONE; c = m_Nodes[c].nextSibling) {
+                        if (m_Nodes[c].queued == m_Update) continue;
+                        m_Nodes[c].queued = m_Update;
+                        next.push_back(c);
+                    }
+                }
+            }
+        }
+
+        const HierarchyStats& stats() const { return m_Stats; }
+    };
+
+} // namespace gl
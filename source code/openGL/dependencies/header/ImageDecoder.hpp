@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stb_image.h>
+
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace gl {
+
+    // Material slots, named after the sampler uniforms in frag.glsl
+    namespace slot {
+        inline constexpr const char* BASE_COLOR = "baseColor";
+        inline constexpr const char* NORMAL = "normal";
+        inline constexpr const char* METALLIC_ROUGHNESS = "metallicRoughness";
+        inline constexpr const char* OCCLUSION = "occlusion";
+        inline constexpr const char* EMISSIVE = "emissive";
+    }
+
+    // ============ EMBEDDED IMAGE ============
+    // Compressed image (PNG, JPEG, ...) stored inside a model file, and the material slots that sample it.
+    // The bytes are borrowed from the parser, so decode before it goes away.
+    struct EmbeddedImage {
+        const unsigned char* data = nullptr;
+        size_t size = 0;
+        std::vector<std::string> slots;
+
+        // Add slot unless another image already feeds it
+        static void assign(std::vector<EmbeddedImage>& images, size_t image, const char* slotName) {
+            for (const auto& other : images) {
+                for (const auto& s : other.slots) {
+                    if (s == slotName) return;
+                }
+            }
+            images[image].slots.push_back(slotName);
+        }
+    };
+
+    // ============ DECODED IMAGE ============
+    // 8-bit pixels straight from stb_image, waiting for the GL thread to upload them
+    struct DecodedImage {
+        struct PixelDeleter {
+            void operator()(unsigned char* pixels) const { stbi_image_free(pixels); }
+        };
+
+        std::unique_ptr<unsigned char, PixelDeleter> pixels;
+        int width = 0, height = 0, channels = 0;
+        std::vector<std::string> slots;
+
+        // Safe on pool workers: stb's flip flag is set per thread. Not meant for the GL thread, whose
+        // texture loaders rely on the global flag that a thread-local setting would override for good.
+        bool decode(const EmbeddedImage& image, bool flipY) {
+            slots = image.slots;
+            pixels.reset();
+            if (!image.data || image.size == 0 || image.size > size_t(INT_MAX)) return false;
+
+            stbi_set_flip_vertically_on_load_thread(flipY ? 1 : 0);
+            pixels.reset(stbi_load_from_memory(image.data, static_cast<int>(image.size), &width, &height, &channels, 0));
+            return pixels != nullptr;
+        }
+
+        size_t byteSize() const { return pixels ? size_t(width) * height * channels : 0; }
+    };
+
+    // ============ IMPORT TIMINGS ============
+    // Per-stage wall times of one model import, in milliseconds. Mesh conversion and texture decode share
+    // one parallel stage: convertMs and decodeMs are summed over all threads, parallelMs is the stage's
+    // wall time, so their ratio shows how much the two overlapped.
+    struct ImportTimings {
+        using clock = std::chrono::steady_clock;
+
+        double parseMs = 0.0;    // file read + parse (or cache map)
+        double convertMs = 0.0;  // mesh conversion + prepare, summed
+        double decodeMs = 0.0;   // texture decode, summed
+        double parallelMs = 0.0; // the shared stage
+        double totalMs = 0.0;
+        double uploadMs = 0.0;   // texture uploads on the GL thread
+        size_t images = 0;
+        size_t imageBytes = 0;   // decoded
+
+        static double since(clock::time_point start) {
+            return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        }
+    };
+
+} // namespace gl
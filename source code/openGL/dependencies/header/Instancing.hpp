@@ -0,0 +1,122 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm.hpp>
+
+#include <StreamBuffer.hpp>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// First of the four attribute locations of the per-instance model matrix (see vert_instanced.glsl)
+#ifndef GL_INSTANCE_MODEL_LOCATION
+#define GL_INSTANCE_MODEL_LOCATION 5
+#endif
+
+// Bytes of instance matrices per frame before the stream grows (64 bytes each)
+#ifndef GL_INSTANCE_STREAM_BYTES
+#define GL_INSTANCE_STREAM_BYTES (4u << 20)
+#endif
+
+// Objects that must share mesh and material before Scene draws them as instances
+#ifndef GL_INSTANCE_MIN_BATCH
+#define GL_INSTANCE_MIN_BATCH 2
+#endif
+
+namespace gl {
+
+    struct InstanceStats {
+        size_t batches = 0;   // drawn instanced
+        size_t instances = 0; // objects in them that passed the frustum test
+        size_t drawCalls = 0; // one per mesh and LOD in use
+    };
+
+    // ============ INSTANCE STREAM ============
+    // Per-instance model matrices behind attribute locations GL_INSTANCE_MODEL_LOCATION..+3. Shared by every
+    // instanced path (Scene's instance batches, MultiDrawQueue), so a VAO's instance arrays only ever point
+    // into this one buffer. The matrices are written into a StreamBuffer, so a frame's upload is a copy
+    // into mapped memory where GL_ARB_buffer_storage is available.
+    class InstanceStream {
+    private:
+        // Instance array state recorded per VAO
+        struct Attachment {
+            size_t offset = SIZE_MAX; // byte offset the arrays point at; SIZE_MAX = unknown
+            bool enabled = false;
+        };
+
+        StreamBuffer m_Stream{ GL_ARRAY_BUFFER, GL_INSTANCE_STREAM_BYTES };
+        size_t m_Base = 0; // byte offset of the last upload
+        uint64_t m_Generation = 0;
+        std::unordered_map<GLuint, Attachment> m_Attached;
+        std::unordered_map<GLuint, bool> m_Programs; // program -> reads instanceModel
+
+    public:
+        InstanceStream() = default;
+        InstanceStream(const InstanceStream&) = delete;
+        InstanceStream& operator=(const InstanceStream&) = delete;
+
+        // Write this draw's matrices; attach() then points into them until the next upload
+        void upload(const std::vector<glm::mat4>& matrices) {
+            m_Base = m_Stream.write(matrices.data(), matrices.size() * sizeof(glm::mat4), sizeof(glm::mat4)).offset;
+
+            // A recreated buffer leaves every VAO pointing at the old one
+            if (m_Stream.generation() != m_Generation) {
+                m_Generation = m_Stream.generation();
+                for (auto& [vao, attachment] : m_Attached) attachment.offset = SIZE_MAX;
+            }
+        }
+
+        // Point the bound VAO's instance arrays at matrix firstInstance of the last upload, advancing once
+        // per instance. GL 3.3 has no baseInstance, so instanced draws of different groups re-attach at their offset.
+        void attach(GLuint vao, size_t firstInstance = 0) {
+            const size_t offset = m_Base + firstInstance * sizeof(glm::mat4);
+            Attachment& attachment = m_Attached[vao];
+            if (attachment.enabled && attachment.offset == offset) return;
+
+            getGLState().bindBuffer(GL_ARRAY_BUFFER, m_Stream.buffer());
+            for (GLuint c = 0; c < 4; c++) {
+                const GLuint location = GL_INSTANCE_MODEL_LOCATION + c;
+                glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                    reinterpret_cast<void*>(offset + sizeof(glm::vec4) * c));
+                glVertexAttribDivisor(location, 1);
+                if (!attachment.enabled) glEnableVertexAttribArray(location);
+            }
+            attachment = { offset, true };
+        }
+
+        // Turn the bound VAO's instance arrays off, so constants from glVertexAttrib4fv apply instead
+        void detach(GLuint vao) {
+            auto it = m_Attached.find(vao);
+            if (it == m_Attached.end() || !it->second.enabled) return;
+            for (GLuint c = 0; c < 4; c++) glDisableVertexAttribArray(GL_INSTANCE_MODEL_LOCATION + c);
+            it->second.enabled = false;
+        }
+
+        // Drop a deleted VAO, whose name GL may hand out again
+        void forget(GLuint vao) { m_Attached.erase(vao); }
+
+        // Matrix as a constant attribute, for non-instanced draws with an instanced program
+        static void setConstant(const glm::mat4& model) {
+            for (GLuint c = 0; c < 4; c++) glVertexAttrib4fv(GL_INSTANCE_MODEL_LOCATION + c, &model[c][0]);
+        }
+
+        // Frame boundary for the underlying stream (Scene::render calls this)
+        void beginFrame() { m_Stream.beginFrame(); }
+
+        const StreamBuffer& stream() const { return m_Stream; }
+
+        // Whether program declares instanceModel at GL_INSTANCE_MODEL_LOCATION (vert_instanced.glsl)
+        bool readsInstanceModel(GLuint program) {
+            auto [it, inserted] = m_Programs.emplace(program, false);
+            if (inserted) it->second = glGetAttribLocation(program, "instanceModel") == GL_INSTANCE_MODEL_LOCATION;
+            return it->second;
+        }
+    };
+
+    InstanceStream& getInstanceStream() {
+        static InstanceStream stream;
+        return stream;
+    }
+
+} // namespace gl
@@ -24,14 +24,62 @@
 #include <Window.hpp>
 #include <Utils.hpp>
 #include <Texture.hpp>
+#include <MeshCache.hpp>
+#include <GlbLoader.hpp>
+#include <ImageDecoder.hpp>
+#include <MeshOptimizer.hpp>
+#include <Simplify.hpp>
+#include <Meshlet.hpp>
+#include <Culling.hpp>
+#include <PackedVertex.hpp>
+#include <GeometryBuffer.hpp>
+#include <MultiDraw.hpp>
+#include <RenderQueue.hpp>
+#include <RenderThread.hpp>
+#include <DepthPrepass.hpp>
+#include <Occlusion.hpp>
+#include <Bvh.hpp>
+#include <SlotMap.hpp>
+#include <Ecs.hpp>
+#include <Hierarchy.hpp>
+#include <ThreadPool.hpp>
+#include <AssetRegistry.hpp>
 
 // Standard headers
 #include <vector>
 #include <memory>
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <iostream>
 
+#ifndef GL_MODEL_IMPORT_FLAGS
+#define GL_MODEL_IMPORT_FLAGS (aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace | aiProcess_FlipUVs)
+#endif
+
+// Assimp's glTF importer flips V once and aiProcess_FlipUVs flips it back, so the native .glb path
+// only flips when the import flags leave FlipUVs out
+#define GL_GLB_FLIP_V ((GL_MODEL_IMPORT_FLAGS & aiProcess_FlipUVs) == 0)
+
+// LOD chain built at import: up to GL_MESH_LOD_LEVELS levels, each aiming for GL_MESH_LOD_REDUCTION of the
+// previous level's triangles, never deviating more than GL_MESH_LOD_MAX_ERROR of the mesh radius
+#ifndef GL_MESH_LOD_LEVELS
+#define GL_MESH_LOD_LEVELS 5
+#endif
+
+#ifndef GL_MESH_LOD_REDUCTION
+#define GL_MESH_LOD_REDUCTION 0.5f
+#endif
+
+#ifndef GL_MESH_LOD_MAX_ERROR
+#define GL_MESH_LOD_MAX_ERROR 0.05f
+#endif
+
+// Meshes with at least this many triangles get meshlets for per-cluster culling of LOD 0
+#ifndef GL_MESHLET_MIN_TRIANGLES
+#define GL_MESHLET_MIN_TRIANGLES 1024
+#endif
+
 namespace gl {
 
     // Simple physics initialization
@@ -48,6 +96,8 @@ namespace gl {
         return true;
     }
 
+    GeometryPool& getGeometryPool(VertexFormat format);
+
     // ============ MESH STRUCT ============
     struct Mesh {
         struct Vertex {
@@ -58,16 +108,442 @@ namespace gl {
             glm::vec3 bitangent;
         };
 
+        // One level of detail: a range of the index buffer, indices first, then lodIndices
+        struct Lod {
+            unsigned int firstIndex;
+            unsigned int indexCount;
+            float error; // object-space distance the simplified surface may deviate by
+        };
+
         std::vector<Vertex> vertices;
-        std::vector<unsigned int> indices;
+        std::vector<unsigned int> indices;     // LOD 0
+        std::vector<unsigned int> lodIndices;  // LOD 1..n, sharing the vertices above
+
+        // Mapped cache entry the geometry is read from instead of the vectors above, until materialize().
+        // Use vertexData()/vertexCount()/indexData()/indexCount() to read either.
+        std::shared_ptr<const CookedModel> cookedModel;
+        CookedSubmesh cooked;
+        std::vector<Lod> lods;                 // empty until generateLods(); LOD 0 is always the full mesh
+        std::vector<Meshlet> meshlets;         // clusters of LOD 0, empty until buildMeshlets()
         glm::vec3 minBounds = glm::vec3(FLT_MAX);
         glm::vec3 maxBounds = glm::vec3(-FLT_MAX);
 
+        // GPU handles, valid after upload()/uploadPacked()/uploadStreams(). Standard and Packed meshes live
+        // in their format's GeometryPool and VAO is the pool's; Split meshes own VAO, IBO and streamBuffers.
+        GLuint VAO = 0;
+        GLuint depthVAO = 0; // positions only at location 0, same index ranges; 0 if the format has none
+        GLuint IBO = 0;
+        GLenum indexType = GL_UNSIGNED_INT;
+        VertexFormat format = VertexFormat::Standard;
+        GeometryPool* pool = nullptr;
+        GeometryPool::Handle poolBlock = 0;
+        std::vector<GLuint> streamBuffers; // per-attribute buffers of a Split upload
+        size_t uploadedBytes = 0;
+
+        // Empty mesh, e.g. for uploadStreams() which keeps no CPU copy
+        Mesh() = default;
+
         Mesh(const std::vector<Vertex>& verts, const std::vector<unsigned int>& inds)
             : vertices(verts), indices(inds) {
             calculateBounds();
         }
 
+        // Take ownership of already-built streams, no copies
+        Mesh(std::vector<Vertex>&& verts, std::vector<unsigned int>&& inds)
+            : vertices(std::move(verts)), indices(std::move(inds)) {
+            calculateBounds();
+        }
+
+        // View of a submesh of a mapped cache entry, kept alive by model; bounds and LODs come precomputed
+        // and the geometry is uploaded straight from the mapping, without CPU copies
+        Mesh(const CookedSubmesh& submesh, std::shared_ptr<const CookedModel> model)
+            : cookedModel(std::move(model)), cooked(submesh), minBounds(submesh.minBounds), maxBounds(submesh.maxBounds) {
+            if (cooked.lodCount > 1) {
+                lods.reserve(cooked.lodCount);
+                for (uint32_t i = 0; i < cooked.lodCount; i++)
+                    lods.push_back({ cooked.lods[i].firstIndex, cooked.lods[i].indexCount, cooked.lods[i].error });
+            }
+        }
+
+        Mesh(const Mesh&) = delete;
+        Mesh& operator=(const Mesh&) = delete;
+
+        ~Mesh() {
+            releaseGpu();
+        }
+
+        // Attribute layout of Vertex, for the bound VAO and GL_ARRAY_BUFFER
+        static void vertexAttributes() {
+            positionAttribute(0, 3, sizeof(Vertex), (void*)offsetof(Vertex, position));
+            positionAttribute(1, 3, sizeof(Vertex), (void*)offsetof(Vertex, normal));
+            positionAttribute(2, 2, sizeof(Vertex), (void*)offsetof(Vertex, texCoords));
+            positionAttribute(3, 3, sizeof(Vertex), (void*)offsetof(Vertex, tangent));
+            positionAttribute(4, 3, sizeof(Vertex), (void*)offsetof(Vertex, bitangent));
+        }
+
+        // Upload from the CPU copy, or straight from the mapped cache entry
+        void upload() {
+            if (cookedModel) {
+                upload(cooked.vertices, cooked.indices);
+                return;
+            }
+            if (lodIndices.empty()) {
+                upload(vertices.data(), indices.data());
+                return;
+            }
+
+            std::vector<unsigned int> all;
+            all.reserve(totalIndexCount());
+            all.insert(all.end(), indices.begin(), indices.end());
+            all.insert(all.end(), lodIndices.begin(), lodIndices.end());
+            upload(vertices.data(), all.data());
+        }
+
+        // Upload from any memory holding vertexCount() Vertex and totalIndexCount() indices
+        void upload(const void* vertexSource, const void* indexSource) {
+            releaseGpu();
+            pool = &getGeometryPool(VertexFormat::Standard);
+            poolBlock = pool->allocate(vertexSource, vertexCount(), indexSource, totalIndexCount() * sizeof(unsigned int));
+            if (!allocated()) return;
+            VAO = pool->vao();
+            depthVAO = pool->depthVao();
+
+            indexType = GL_UNSIGNED_INT;
+            format = VertexFormat::Standard;
+            uploadedBytes = vertexCount() * sizeof(Vertex) + totalIndexCount() * sizeof(unsigned int);
+        }
+
+        // Upload as PackedVertex (20 instead of 56 bytes) with 16-bit indices when they fit.
+        // Draw with vert_packed.glsl; posOffset/posScale must be set to minBounds/getSize().
+        void uploadPacked() {
+            const glm::vec3 extent = getSize();
+            const Vertex* source = vertexData();
+
+            std::vector<PackedVertex> packed;
+            packed.reserve(vertexCount());
+            for (size_t i = 0; i < vertexCount(); i++) {
+                const Vertex& v = source[i];
+                packed.push_back(packVertex(v.position, v.normal, v.texCoords, v.tangent, v.bitangent, minBounds, extent));
+            }
+
+            releaseGpu();
+            pool = &getGeometryPool(VertexFormat::Packed);
+
+            // Indices are relative to the block's base vertex, so 16 bits hold for any pool size
+            if (vertexCount() <= 0xFFFF) {
+                std::vector<uint16_t> narrow;
+                appendIndices(narrow);
+                poolBlock = pool->allocate(packed.data(), packed.size(), narrow.data(), narrow.size() * sizeof(uint16_t));
+                indexType = GL_UNSIGNED_SHORT;
+            }
+            else {
+                std::vector<unsigned int> all;
+                appendIndices(all);
+                poolBlock = pool->allocate(packed.data(), packed.size(), all.data(), all.size() * sizeof(unsigned int));
+                indexType = GL_UNSIGNED_INT;
+            }
+            if (!allocated()) return;
+            VAO = pool->vao();
+
+            format = VertexFormat::Packed;
+            uploadedBytes = vertexCount() * sizeof(PackedVertex) +
+                totalIndexCount() * (indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int));
+        }
+
+        // Upload a .glb primitive as one buffer per attribute, straight from the mapped file wherever the
+        // accessor is already GPU-ready (GL reads strided and normalised data itself). Only missing normals
+        // or tangents, flipped UVs and 8-bit indices are converted. Keeps no CPU copy, so no optimisation,
+        // LODs or meshlets; bounds come from the POSITION accessor. Draw with vert.glsl.
+        void uploadStreams(const GlbPrimitive& prim, bool flipV) {
+            releaseGpu();
+            bindVertexArray(VAO);
+
+            const size_t vertexCount = prim.vertexCount();
+            uploadedBytes = 0;
+
+            auto stream = [&](GLuint location, const void* data, size_t bytes, GLint size, GLenum type, GLboolean normalized, size_t stride) {
+                GLuint buffer = 0;
+                bindVertexBuffer(buffer, static_cast<const GLfloat*>(data), bytes);
+                glVertexAttribPointer(location, size, type, normalized, static_cast<GLsizei>(stride), nullptr);
+                glEnableVertexAttribArray(location);
+                streamBuffers.push_back(buffer);
+                uploadedBytes += bytes;
+            };
+            auto direct = [&](GLuint location, const GlbAccessor& a, GLint size) {
+                stream(location, a.data, a.byteLength(), size, a.componentType, a.normalized ? GL_TRUE : GL_FALSE, a.stride);
+            };
+
+            direct(0, prim.position, 3);
+
+            std::vector<glm::vec3> normals;
+            if (prim.normal.valid()) direct(1, prim.normal, 3);
+            else {
+                glb::generateNormals(prim, normals);
+                stream(1, normals.data(), normals.size() * sizeof(glm::vec3), 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3));
+            }
+
+            if (prim.texCoord.valid() && !flipV) direct(2, prim.texCoord, 2);
+            else if (prim.texCoord.valid()) {
+                std::vector<glm::vec2> texCoords(vertexCount);
+                for (size_t i = 0; i < vertexCount; i++) {
+                    glm::vec4 t = prim.texCoord.read(i);
+                    texCoords[i] = glm::vec2(t.x, 1.0f - t.y);
+                }
+                stream(2, texCoords.data(), texCoords.size() * sizeof(glm::vec2), 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2));
+            }
+            else {
+                glDisableVertexAttribArray(2);
+                glVertexAttrib2f(2, 0.0f, 0.0f);
+            }
+
+            // vec4 tangents; the shader reads xyz and rebuilds the bitangent
+            if (prim.tangent.valid()) direct(3, prim.tangent, 3);
+            else if (prim.texCoord.valid()) {
+                std::vector<glm::vec4> tangents;
+                glb::generateTangents(prim, normals.empty() ? nullptr : &normals, tangents);
+                stream(3, tangents.data(), tangents.size() * sizeof(glm::vec4), 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec4));
+            }
+            else {
+                glDisableVertexAttribArray(3);
+                glVertexAttrib3f(3, 1.0f, 0.0f, 0.0f);
+            }
+
+            const size_t indexCount = prim.indexCount();
+            if (prim.indices.valid() && prim.indices.componentType != glb::UNSIGNED_BYTE) {
+                bindIndexBuffer(IBO, prim.indices.data, prim.indices.byteLength());
+                indexType = prim.indices.componentType;
+                uploadedBytes += prim.indices.byteLength();
+            }
+            else {
+                // GL_UNSIGNED_BYTE indices are legal but slow on most drivers; non-indexed primitives get a sequence
+                std::vector<uint16_t> narrow;
+                std::vector<unsigned int> wide;
+                if (vertexCount <= 0x10000) {
+                    narrow.resize(indexCount);
+                    for (size_t i = 0; i < indexCount; i++) narrow[i] = static_cast<uint16_t>(prim.index(i));
+                    bindIndexBuffer(IBO, narrow.data(), narrow.size() * sizeof(uint16_t));
+                    indexType = GL_UNSIGNED_SHORT;
+                    uploadedBytes += narrow.size() * sizeof(uint16_t);
+                }
+                else {
+                    wide.resize(indexCount);
+                    for (size_t i = 0; i < indexCount; i++) wide[i] = prim.index(i);
+                    bindIndexBuffer(IBO, wide.data(), wide.size() * sizeof(unsigned int));
+                    indexType = GL_UNSIGNED_INT;
+                    uploadedBytes += wide.size() * sizeof(unsigned int);
+                }
+            }
+
+            // The position stream alone over the same indices, for depth-only passes
+            glGenVertexArrays(1, &depthVAO);
+            getGLState().bindVertexArray(depthVAO);
+            getGLState().bindBuffer(GL_ARRAY_BUFFER, streamBuffers.front());
+            glVertexAttribPointer(0, 3, prim.position.componentType, prim.position.normalized ? GL_TRUE : GL_FALSE,
+                static_cast<GLsizei>(prim.position.stride), nullptr);
+            glEnableVertexAttribArray(0);
+            getGLState().bindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+            getGLState().bindVertexArray(0);
+
+            if (prim.position.hasBounds) {
+                minBounds = prim.position.minBounds;
+                maxBounds = prim.position.maxBounds;
+            }
+            else {
+                for (size_t i = 0; i < vertexCount; i++) {
+                    minBounds = glm::min(minBounds, glm::vec3(prim.position.read(i)));
+                    maxBounds = glm::max(maxBounds, glm::vec3(prim.position.read(i)));
+                }
+            }
+
+            vertices.clear();
+            indices.clear();
+            lodIndices.clear();
+            releaseView();
+            meshlets.clear();
+            lods = { { 0, static_cast<unsigned int>(indexCount), 0.0f } };
+            format = VertexFormat::Split;
+        }
+
+        // Bytes resident on the GPU for the current upload
+        size_t gpuBytes() const {
+            return uploadedBytes;
+        }
+
+        // Geometry from whichever holds it: the mapped cache entry or the CPU vectors. indexData() is
+        // LOD 0, indexCount() indices long.
+        const Vertex* vertexData() const { return cookedModel ? static_cast<const Vertex*>(cooked.vertices) : vertices.data(); }
+        size_t vertexCount() const { return cookedModel ? cooked.vertexCount : vertices.size(); }
+        const unsigned int* indexData() const { return cookedModel ? cooked.indices : indices.data(); }
+        size_t indexCount() const { return cookedModel ? (lods.empty() ? cooked.indexCount : lods[0].indexCount) : indices.size(); }
+        size_t totalIndexCount() const { return cookedModel ? cooked.indexCount : indices.size() + lodIndices.size(); }
+
+        // Copy a mapped cache entry's geometry into the CPU vectors and drop the mapping, for code that edits them
+        void materialize() {
+            if (!cookedModel) return;
+            const Vertex* verts = static_cast<const Vertex*>(cooked.vertices);
+            const size_t baseCount = indexCount();
+            vertices.assign(verts, verts + cooked.vertexCount);
+            indices.assign(cooked.indices, cooked.indices + baseCount);
+            lodIndices.assign(cooked.indices + baseCount, cooked.indices + cooked.indexCount);
+            releaseView();
+        }
+
+        bool isUploaded() const { return VAO != 0; }
+
+        // Import-time optimisation results, see optimize()
+        struct OptimizeStats {
+            size_t verticesBefore = 0;
+            size_t verticesAfter = 0;
+            meshopt::CacheStats before;
+            meshopt::CacheStats after;
+        };
+
+        OptimizeStats optimizeStats;
+
+        // Weld identical vertices, reorder triangles for the post-transform cache (Tipsify) and
+        // then for overdraw, and finally reorder vertices for fetch locality. CPU only, call before upload().
+        void optimize(unsigned int cacheSize = 16) {
+            materialize();
+            if (indices.empty() || indices.size() % 3 != 0) return;
+
+            optimizeStats.verticesBefore = vertices.size();
+            optimizeStats.before = meshopt::analyzeVertexCache(indices.data(), indices.size(), vertices.size(), cacheSize);
+
+            std::vector<unsigned int> remap;
+            size_t unique = meshopt::generateWeldRemap(remap, vertices.data(), vertices.size(), sizeof(Vertex));
+            std::vector<Vertex> welded(unique);
+            meshopt::remapVertexBuffer(welded.data(), vertices.data(), vertices.size(), sizeof(Vertex), remap.data());
+            meshopt::remapIndexBuffer(indices.data(), indices.size(), remap.data());
+
+            std::vector<unsigned int> clusters;
+            std::vector<unsigned int> reordered(indices.size());
+            meshopt::optimizeVertexCache(reordered.data(), indices.data(), indices.size(), welded.size(), cacheSize, &clusters);
+            meshopt::optimizeOverdraw(indices.data(), reordered.data(), reordered.size(),
+                &welded[0].position.x, sizeof(Vertex), clusters);
+
+            size_t used = meshopt::generateFetchRemap(remap, indices.data(), indices.size(), welded.size());
+            vertices.resize(used);
+            meshopt::remapVertexBufferSparse(vertices.data(), welded.data(), welded.size(), sizeof(Vertex), remap.data());
+            meshopt::remapIndexBuffer(indices.data(), indices.size(), remap.data());
+
+            optimizeStats.verticesAfter = vertices.size();
+            optimizeStats.after = meshopt::analyzeVertexCache(indices.data(), indices.size(), vertices.size(), cacheSize);
+        }
+
+        // Build the LOD chain with quadric-error simplification. Each level simplifies the previous one
+        // and is reordered for the vertex cache; the chain stops early once a level no longer shrinks.
+        // maxError is relative to the bounding radius. CPU only, call after optimize() and before upload().
+        void generateLods(unsigned int levels = GL_MESH_LOD_LEVELS, float reduction = GL_MESH_LOD_REDUCTION,
+            float maxError = GL_MESH_LOD_MAX_ERROR, unsigned int cacheSize = 16)
+        {
+            materialize();
+            lods.clear();
+            lodIndices.clear();
+            if (levels < 2 || indices.empty() || indices.size() % 3 != 0) return;
+
+            lods.push_back({ 0, static_cast<unsigned int>(indices.size()), 0.0f });
+
+            const float errorLimit = maxError * glm::length(getExtents());
+            std::vector<unsigned int> source = indices;
+            std::vector<unsigned int> simplified(indices.size());
+            std::vector<unsigned int> reordered;
+
+            for (unsigned int level = 1; level < levels; level++) {
+                size_t target = size_t(double(source.size()) * reduction) / 3 * 3;
+                if (target < 3) break;
+
+                float error = 0.0f;
+                size_t count = meshopt::simplify(simplified.data(), source.data(), source.size(),
+                    &vertices[0].position.x, sizeof(Vertex), vertices.size(), target, errorLimit, &error);
+
+                // Not worth a level if it saves less than 10%
+                if (count == 0 || count * 10 > source.size() * 9) break;
+
+                reordered.resize(count);
+                meshopt::optimizeVertexCache(reordered.data(), simplified.data(), count, vertices.size(), cacheSize);
+
+                // Errors of successive simplifications add up at worst
+                lods.push_back({ static_cast<unsigned int>(totalIndexCount()), static_cast<unsigned int>(count), lods.back().error + error });
+                lodIndices.insert(lodIndices.end(), reordered.begin(), reordered.end());
+                source.assign(reordered.begin(), reordered.end());
+            }
+
+            if (lods.size() == 1) lods.clear();
+        }
+
+        // Split LOD 0 into meshlets for per-cluster frustum and back-face cone culling.
+        // Keeps the triangle order, so it can run before or after upload(), and reads a mapped cache entry in place.
+        void buildMeshlets(size_t maxVertices = GL_MESHLET_MAX_VERTICES, size_t maxTriangles = GL_MESHLET_MAX_TRIANGLES) {
+            if (indexCount() == 0 || vertexCount() == 0) {
+                meshlets.clear();
+                return;
+            }
+            meshopt::buildMeshlets(meshlets, indexData(), indexCount(),
+                &vertexData()[0].position.x, sizeof(Vertex), vertexCount(), maxVertices, maxTriangles);
+        }
+
+        // Import-time CPU work shared by every import path: optimise, build LODs, and meshlets for large meshes
+        void prepare() {
+            optimize();
+            generateLods();
+            if (indices.size() / 3 >= GL_MESHLET_MIN_TRIANGLES) buildMeshlets();
+        }
+
+        size_t lodCount() const { return lods.empty() ? 1 : lods.size(); }
+
+        Lod getLod(size_t lod) const {
+            if (lods.empty()) return { 0, static_cast<unsigned int>(indexCount()), 0.0f };
+            return lods[std::min(lod, lods.size() - 1)];
+        }
+
+        // Coarsest LOD whose error stays below the pixel threshold folded into lodScale
+        // (see Scene::render). distance is from the eye to the mesh bounds; scale lodScale
+        // by the object's scale when distance is in world units.
+        size_t selectLod(float distance, float lodScale) const {
+            for (size_t i = lods.size(); i > 1; i--) {
+                if (lods[i - 1].error * lodScale <= distance) return i - 1;
+            }
+            return 0;
+        }
+
+        // Where this mesh's data starts in the bound buffers; zero for Split meshes
+        GLint baseVertex() const { return pool ? static_cast<GLint>(pool->block(poolBlock).firstVertex) : 0; }
+
+        size_t indexByteOffset() const { return pool ? pool->block(poolBlock).indexOffset : 0; }
+
+        void draw(size_t lod = 0) const {
+            if (!VAO) return;
+            const Lod range = getLod(lod);
+            const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+
+            useVertexArray(VAO);
+            glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(range.indexCount), indexType,
+                reinterpret_cast<void*>(indexByteOffset() + size_t(range.firstIndex) * indexSize), baseVertex());
+        }
+
+        // Draw visible index ranges (from meshopt::cullMeshlets) with a single glMultiDrawElements
+        void draw(const std::vector<MeshletRange>& ranges) const {
+            if (!VAO || ranges.empty()) return;
+            const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+
+            const size_t base = indexByteOffset();
+
+            thread_local std::vector<GLsizei> counts;
+            thread_local std::vector<void*> offsets; // GLEW declares the BaseVertex entry points without const
+            thread_local std::vector<GLint> baseVertices;
+            counts.clear();
+            offsets.clear();
+            for (const auto& range : ranges) {
+                counts.push_back(static_cast<GLsizei>(range.indexCount));
+                offsets.push_back(reinterpret_cast<void*>(base + size_t(range.firstIndex) * indexSize));
+            }
+            baseVertices.assign(ranges.size(), baseVertex());
+
+            useVertexArray(VAO);
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), indexType, offsets.data(),
+                static_cast<GLsizei>(ranges.size()), baseVertices.data());
+        }
+
         glm::vec3 getCenter() const {
             return (minBounds + maxBounds) * 0.5f;
         }
@@ -76,17 +552,73 @@ namespace gl {
             return (maxBounds - minBounds) * 0.5f;
         }
 
+        glm::vec3 getSize() const {
+            return maxBounds - minBounds;
+        }
+
         // Get vertices for physics shape (scaled)
         std::vector<glm::vec3> getPhysicsVertices(const glm::vec3& scale = glm::vec3(1.0f)) const {
             std::vector<glm::vec3> result;
-            result.reserve(vertices.size());
-            for (const auto& v : vertices) {
-                result.push_back(v.position * scale);
-            }
+            getPhysicsVertices(result, scale);
             return result;
         }
 
+        // Same, into a caller-owned buffer that keeps its capacity between calls
+        void getPhysicsVertices(std::vector<glm::vec3>& out, const glm::vec3& scale = glm::vec3(1.0f)) const {
+            const Vertex* source = vertexData();
+            out.resize(vertexCount());
+            for (size_t i = 0; i < out.size(); i++) {
+                out[i] = source[i].position * scale;
+            }
+        }
+
     private:
+        // All LODs' indices, in buffer order, converted to T
+        template <typename T>
+        void appendIndices(std::vector<T>& out) const {
+            out.reserve(out.size() + totalIndexCount());
+            if (cookedModel) {
+                out.insert(out.end(), cooked.indices, cooked.indices + cooked.indexCount);
+                return;
+            }
+            out.insert(out.end(), indices.begin(), indices.end());
+            out.insert(out.end(), lodIndices.begin(), lodIndices.end());
+        }
+
+        // False, leaving the mesh not uploaded, if the pool could not fit the last allocate()
+        bool allocated() {
+            if (poolBlock != GeometryPool::INVALID) return true;
+            std::cerr << "Geometry pool allocation failed: " << vertexCount() << " vertices" << std::endl;
+            pool = nullptr;
+            poolBlock = 0;
+            uploadedBytes = 0;
+            return false;
+        }
+
+        void releaseView() {
+            cookedModel.reset();
+            cooked = CookedSubmesh();
+        }
+
+        void releaseGpu() {
+            if (pool) pool->release(poolBlock);
+            else {
+                if (!streamBuffers.empty()) getGLState().deleteBuffers(static_cast<GLsizei>(streamBuffers.size()), streamBuffers.data());
+                if (IBO) getGLState().deleteBuffers(1, &IBO);
+                if (VAO) {
+                    getGLState().deleteVertexArrays(1, &VAO);
+                    getInstanceStream().forget(VAO);
+                }
+                if (depthVAO) getGLState().deleteVertexArrays(1, &depthVAO);
+            }
+            pool = nullptr;
+            poolBlock = 0;
+            streamBuffers.clear();
+            IBO = 0;
+            VAO = 0;
+            depthVAO = 0;
+        }
+
         void calculateBounds() {
             for (const auto& v : vertices) {
                 minBounds = glm::min(minBounds, v.position);
@@ -95,12 +627,54 @@ namespace gl {
         }
     };
 
+    // ============ GEOMETRY POOLS ============
+    // One per pooled vertex format; Split meshes keep their own buffers
+    GeometryPool& getGeometryPool(VertexFormat format) {
+        static GeometryPool standard(sizeof(Mesh::Vertex), Mesh::vertexAttributes,
+            GL_DEPTH_POSITION_STREAM ? offsetof(Mesh::Vertex, position) : SIZE_MAX);
+        static GeometryPool packed(sizeof(PackedVertex), packedVertexAttributes);
+        return format == VertexFormat::Packed ? packed : standard;
+    }
+
+    // ============ IMPORTED MODEL ============
+    // CPU-side result of importing a model file: built on any thread, uploaded on the GL thread
+    struct ImportedModel {
+        std::string path;
+        std::vector<std::shared_ptr<Mesh>> meshes;
+        std::vector<DecodedImage> images;    // embedded textures, decoded on pool workers
+        std::vector<std::shared_ptr<EmbeddedTexture>> textures; // uploaded images, same order
+        ImportTimings timings;
+
+        // Upload one decoded image and free its pixels. GL thread only; split out so loaders can
+        // spread texture uploads over frames.
+        void uploadImage(size_t i) {
+            if (textures.size() < images.size()) textures.resize(images.size());
+            if (textures[i] || !images[i].pixels) return;
+
+            auto start = ImportTimings::clock::now();
+            textures[i] = std::make_shared<EmbeddedTexture>(images[i]);
+            images[i].pixels.reset();
+            timings.uploadMs += ImportTimings::since(start);
+        }
+    };
+
     // ============ OBJECT STRUCT ============
     struct Object {
         // Rendering
         std::vector<std::shared_ptr<Mesh>> meshes;
+        std::vector<std::shared_ptr<MeshAsset>> assets; // keeps shared meshes registered while in use
         std::shared_ptr<shader> shader;
         std::unordered_map<std::string, GLuint> textures;
+        VertexFormat vertexFormat = VertexFormat::Standard; // Packed needs vert_packed.glsl
+        bool streamGlb = false; // load .glb through Mesh::uploadStreams: fastest, but no optimisation, LODs or meshlets
+        ImportTimings importTimings; // of the last model imported into this object
+        uint64_t instancedFrame = 0; // Scene frame that last drew this object as an instance
+        uint64_t culledFrame = 0;    // Scene frame whose frustum or occlusion test hid this object
+        RenderLayer layer = RenderLayer::Opaque; // submission order under Scene::setSorted
+        int32_t bvhProxy = DynamicBvh::NONE;     // leaf in the owning Scene's spatial index
+        SlotHandle handle;                       // in the owning Scene's objects; invalid while not in one
+        const TransformHierarchy* hierarchy = nullptr; // set by Scene::attachObject
+        SlotHandle transformNode;                      // in hierarchy
 
         // Transform
         glm::vec3 position = glm::vec3(0.0f);
@@ -120,20 +694,193 @@ namespace gl {
 
         Object(const std::string& objName) : name(objName) {}
 
-        // Load model from file
-        bool loadModel(const std::string& path) {
+        // Import a model file without touching GL, so it can run on a worker thread.
+        // A cooked cache entry keyed by (file contents, import flags) skips parsing entirely; a miss parses
+        // .glb natively (Assimp for anything else or anything the GLB reader rejects), converts and
+        // optimises the meshes in parallel and writes the entry for next time.
+        // Embedded textures are decoded on pool workers alongside the meshes and left in out.images for upload;
+        // the cache holds geometry only, so on a hit they are still read from the file (.glb only).
+        static bool importModel(const std::string& path, ImportedModel& out, bool useCache = true) {
+            const auto start = ImportTimings::clock::now();
+            out.path = path;
+            uint64_t key = useCache ? cacheKey(path) : 0;
+
+            if (key) {
+                auto cooked = std::make_shared<CookedModel>();
+                if (getMeshCache().load(key, sizeof(Mesh::Vertex), *cooked)) {
+                    // The meshes view the mapping and keep it alive; nothing is copied until upload
+                    out.meshes.reserve(cooked->submeshes.size());
+                    for (const auto& submesh : cooked->submeshes) {
+                        out.meshes.push_back(std::make_shared<Mesh>(submesh, cooked));
+                    }
+
+                    GlbFile file;
+                    std::vector<EmbeddedImage> images;
+                    if (GlbFile::isGlb(path) && file.open(path)) file.collectImages(images);
+                    out.timings.parseMs = ImportTimings::since(start);
+
+                    buildParallel(out, images, [&](size_t i) {
+                        if (out.meshes[i]->indexCount() / 3 >= GL_MESHLET_MIN_TRIANGLES) out.meshes[i]->buildMeshlets();
+                    });
+                    out.timings.totalMs = ImportTimings::since(start);
+                    return true;
+                }
+            }
+
+            bool imported = GlbFile::isGlb(path) && importGlb(path, out);
+            if (!imported && !importAssimp(path, out)) return false;
+
+            if (key) {
+                std::vector<CookedSource> sources;
+                sources.reserve(out.meshes.size());
+                for (const auto& mesh : out.meshes) {
+                    CookedSource src;
+                    src.vertices = mesh->vertices.data();
+                    src.vertexCount = static_cast<uint32_t>(mesh->vertices.size());
+                    src.indices = mesh->indices.data();
+                    src.indexCount = static_cast<uint32_t>(mesh->indices.size());
+                    src.lodIndices = mesh->lodIndices.data();
+                    src.lodIndexCount = static_cast<uint32_t>(mesh->lodIndices.size());
+                    for (const auto& lod : mesh->lods)
+                        src.lods.push_back({ lod.firstIndex, lod.indexCount, lod.error, 0 });
+                    src.minBounds = mesh->minBounds;
+                    src.maxBounds = mesh->maxBounds;
+                    sources.push_back(src);
+                }
+                getMeshCache().store(key, GL_MODEL_IMPORT_FLAGS, sizeof(Mesh::Vertex), sources);
+            }
+            out.timings.totalMs = ImportTimings::since(start);
+            return true;
+        }
+
+        // Parse through Assimp, then convert and optimise every aiMesh in parallel
+        static bool importAssimp(const std::string& path, ImportedModel& out) {
+            const auto start = ImportTimings::clock::now();
             Assimp::Importer importer;
-            const aiScene* scene = importer.ReadFile(path,
-                aiProcess_Triangulate |
-                aiProcess_GenSmoothNormals |
-                aiProcess_FlipUVs);
+            const aiScene* scene = importer.ReadFile(path, GL_MODEL_IMPORT_FLAGS);
 
             if (!scene || !scene->mRootNode) {
                 std::cerr << "Failed to load model: " << path << std::endl;
                 return false;
             }
 
-            processNode(scene->mRootNode, scene);
+            std::vector<aiMesh*> sceneMeshes;
+            collectMeshes(scene->mRootNode, scene, sceneMeshes);
+            std::vector<EmbeddedImage> images;
+            collectImages(scene, images);
+            out.timings.parseMs = ImportTimings::since(start);
+
+            out.meshes.resize(sceneMeshes.size());
+            buildParallel(out, images, [&](size_t i) {
+                out.meshes[i] = convertMesh(sceneMeshes[i]);
+                out.meshes[i]->prepare();
+            });
+            return true;
+        }
+
+        // Same through the native GLB reader, converting straight from the mapped file.
+        // Returns false without touching out if the file needs Assimp.
+        static bool importGlb(const std::string& path, ImportedModel& out) {
+            const auto start = ImportTimings::clock::now();
+            GlbFile file;
+            std::vector<GlbPrimitive> primitives;
+            if (!file.open(path) || !file.collectPrimitives(primitives)) return false;
+
+            std::vector<EmbeddedImage> images;
+            file.collectImages(images);
+            out.timings.parseMs = ImportTimings::since(start);
+
+            out.meshes.resize(primitives.size());
+            buildParallel(out, images, [&](size_t i) {
+                out.meshes[i] = convertPrimitive(primitives[i], GL_GLB_FLIP_V);
+                out.meshes[i]->prepare();
+            });
+            return true;
+        }
+
+        // Upload a .glb as Split meshes straight from the mapping (see Mesh::uploadStreams) and
+        // register it. Must run on the GL context thread. Returns false if the file needs the import path.
+        bool loadGlbStreams(const std::string& path) {
+            GlbFile file;
+            std::vector<GlbPrimitive> primitives;
+            if (!file.open(path) || !file.collectPrimitives(primitives)) return false;
+
+            // Textures decode on the pool while this thread uploads the geometry
+            std::vector<EmbeddedImage> images;
+            file.collectImages(images);
+            ImportedModel model;
+            model.images.resize(images.size());
+            auto decode = getThreadPool().launch(images.size(), [&](size_t i) { model.images[i].decode(images[i], GL_GLB_FLIP_V); });
+
+            std::vector<std::shared_ptr<Mesh>> uploaded;
+            uploaded.reserve(primitives.size());
+            for (const auto& prim : primitives) {
+                auto mesh = std::make_shared<Mesh>();
+                mesh->uploadStreams(prim, GL_GLB_FLIP_V);
+                uploaded.push_back(mesh);
+            }
+
+            decode->wait();
+            for (size_t i = 0; i < model.images.size(); i++) model.uploadImage(i);
+            addAsset(getAssetRegistry().insert(path, VertexFormat::Split, std::move(uploaded), liveTextures(model)));
+            return true;
+        }
+
+        // Cache key for a model file under the current import flags and LOD settings
+        static uint64_t cacheKey(const std::string& path) {
+            const float reduction = GL_MESH_LOD_REDUCTION, maxError = GL_MESH_LOD_MAX_ERROR;
+            uint32_t reductionBits, errorBits;
+            std::memcpy(&reductionBits, &reduction, sizeof(reductionBits));
+            std::memcpy(&errorBits, &maxError, sizeof(errorBits));
+
+            const uint64_t settings = (uint64_t(GL_MESH_LOD_LEVELS) << 48) ^ (uint64_t(reductionBits) << 16) ^ errorBits;
+            return MeshCache::hashSource(path, GL_MODEL_IMPORT_FLAGS, sizeof(Mesh::Vertex), settings);
+        }
+
+        // Upload an imported model, register it in the asset registry and take its meshes.
+        // Must run on the GL context thread.
+        void addModel(ImportedModel& model) {
+            for (size_t i = 0; i < model.meshes.size(); i++) {
+                auto& mesh = model.meshes[i];
+                if (vertexFormat == VertexFormat::Packed) mesh->uploadPacked();
+                else mesh->upload();
+            }
+            for (size_t i = 0; i < model.images.size(); i++) model.uploadImage(i);
+
+            // If the same file finished loading elsewhere first, share that copy and drop ours
+            addAsset(getAssetRegistry().insert(model.path, vertexFormat, std::move(model.meshes), liveTextures(model)));
+            importTimings = model.timings;
+            model.meshes.clear();
+            model.images.clear();
+            model.textures.clear();
+        }
+
+        // Share an already loaded asset. Its embedded textures fill material slots not already set on this object.
+        void addAsset(const std::shared_ptr<MeshAsset>& asset) {
+            meshes.insert(meshes.end(), asset->meshes.begin(), asset->meshes.end());
+            for (const auto& texture : asset->textures) {
+                for (const auto& slotName : texture->slots) textures.emplace(slotName, texture->id);
+            }
+            assets.push_back(asset);
+        }
+
+        // Load model from file (synchronous import + upload). A model that is already resident
+        // in this vertex format is shared through the asset registry; useCache = false forces a fresh import.
+        bool loadModel(const std::string& path, bool useCache = true) {
+            const bool streams = streamGlb && vertexFormat == VertexFormat::Standard && GlbFile::isGlb(path);
+
+            if (useCache) {
+                if (auto asset = getAssetRegistry().find(path, streams ? VertexFormat::Split : vertexFormat)) {
+                    addAsset(asset);
+                    return true;
+                }
+            }
+
+            if (streams && loadGlbStreams(path)) return true;
+
+            ImportedModel model;
+            if (!importModel(path, model, useCache)) return false;
+            addModel(model);
             return true;
         }
 
@@ -185,53 +932,142 @@ namespace gl {
             rotation = glm::quat(rot.GetW(), rot.GetX(), rot.GetY(), rot.GetZ());
         }
 
-        // Get model matrix for rendering
+        // Get model matrix for rendering; in a transform hierarchy, the world matrix it cached at its last update
         glm::mat4 getModelMatrix() const {
+            if (hierarchy) return hierarchy->getWorld(transformNode);
             glm::mat4 mat = glm::translate(glm::mat4(1.0f), position);
             mat *= glm::mat4_cast(rotation);
             mat = glm::scale(mat, scale);
             return mat;
         }
 
-        // Simple render
+        // World-space box around all meshes; false if there are none
+        bool getWorldBounds(glm::vec3& minBounds, glm::vec3& maxBounds) const {
+            glm::vec3 localMin(FLT_MAX), localMax(-FLT_MAX);
+            for (const auto& mesh : meshes) {
+                localMin = glm::min(localMin, mesh->minBounds);
+                localMax = glm::max(localMax, mesh->maxBounds);
+            }
+            if (localMin.x > localMax.x) return false;
+            transformAabb(getModelMatrix(), localMin, localMax, minBounds, maxBounds);
+            return true;
+        }
+
+        // Simple render, always the full-detail LOD
         void render() {
-            if (!visible || !shader || meshes.empty()) return;
+            render(glm::vec3(0.0f), 0.0f);
+        }
 
-            shader->useProgram();
-            shader->setUniformMat4fv("model", getModelMatrix());
+        // Render with per-mesh LOD selection. lodScale = viewport height / (2 tan(fov / 2)) / pixel error;
+        // 0 draws everything at LOD 0 without culling. Otherwise meshes drawn at LOD 0 with meshlets are culled
+        // per cluster against frustum (world space, optional) and by normal cones. Returns the triangles submitted.
+        size_t render(const glm::vec3& eye, float lodScale, const Frustum* frustum = nullptr, MeshletCullStats* cullStats = nullptr) {
+            if (!visible || !shader || meshes.empty()) return 0;
 
-            // Bind textures if any
-            int texUnit = 0;
-            for (auto& [name, texId] : textures) {
-                glActiveTexture(GL_TEXTURE0 + texUnit);
-                glBindTexture(GL_TEXTURE_2D, texId);
-                shader->setUniform1i(name.c_str(), texUnit);
-                texUnit++;
-            }
+            const glm::mat4 model = getModelMatrix();
+            shader->useProgram();
+            shader->setUniformMat4fv("model", model);
+            bindMaterialTextures(*shader, textures);
+
+            // vert_instanced.glsl reads the matrix as an attribute: turn the instance arrays off and pass it as a constant
+            const bool instanced = getInstanceStream().readsInstanceModel(shader->getProgram());
+            if (instanced) InstanceStream::setConstant(model);
+
+            return selectDraws(model, eye, lodScale, frustum, cullStats,
+                [&](const Mesh& mesh, size_t lod, const std::vector<MeshletRange>* visibleRanges) {
+                    if (instanced && mesh.VAO) {
+                        useVertexArray(mesh.VAO);
+                        getInstanceStream().detach(mesh.VAO);
+                    }
+                    if (mesh.format == VertexFormat::Packed) {
+                        shader->setUniform3fv("posOffset", mesh.minBounds);
+                        shader->setUniform3fv("posScale", mesh.getSize());
+                    }
+                    if (visibleRanges) mesh.draw(*visibleRanges);
+                    else mesh.draw(lod);
+                });
+        }
 
-            // For now, just render first mesh
-            // You'd need VAO/VBO setup for actual rendering
+        // Same selection as render(), but queue the draws for Scene's batched submission instead of
+        // issuing them. Packed meshes need per-mesh uniforms and cannot be batched; render those directly.
+        size_t gatherDraws(MultiDrawQueue& queue, const glm::vec3& eye, float lodScale, const Frustum* frustum = nullptr, MeshletCullStats* cullStats = nullptr) {
+            if (!visible || !shader || meshes.empty()) return 0;
+
+            const glm::mat4 model = getModelMatrix();
+            const GLuint instance = queue.addInstance(model);
+            const uint32_t textureSet = getTextureSets().intern(textures);
+
+            return selectDraws(model, eye, lodScale, frustum, cullStats,
+                [&](const Mesh& mesh, size_t lod, const std::vector<MeshletRange>* visibleRanges) {
+                    if (!mesh.VAO) return;
+                    const size_t indexSize = mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+                    const GLuint first = static_cast<GLuint>(mesh.indexByteOffset() / indexSize);
+
+                    auto add = [&](unsigned int firstIndex, unsigned int indexCount) {
+                        queue.add(*shader, textures, textureSet, mesh.VAO, mesh.indexType,
+                            { indexCount, 1, first + firstIndex, mesh.baseVertex(), instance });
+                    };
+                    if (visibleRanges) {
+                        for (const auto& range : *visibleRanges) add(range.firstIndex, range.indexCount);
+                    }
+                    else {
+                        const Mesh::Lod range = mesh.getLod(lod);
+                        add(range.firstIndex, range.indexCount);
+                    }
+                });
         }
 
-    private:
-        void processNode(aiNode* node, const aiScene* scene) {
-            for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-                aiMesh* aiMesh = scene->mMeshes[node->mMeshes[i]];
-                meshes.push_back(convertMesh(aiMesh));
-            }
+        // Same selection as render(), but queue the draws into a sort-key RenderQueue, each keyed by this
+        // object's layer, program, textures and the distance from eye to the mesh's center
+        size_t queueDraws(RenderQueue& queue, const glm::vec3& eye, float lodScale, const Frustum* frustum = nullptr, MeshletCullStats* cullStats = nullptr) {
+            if (!visible || !shader || meshes.empty()) return 0;
+
+            const glm::mat4 model = getModelMatrix();
+            RenderQueue::Draw draw;
+            draw.program = shader.get();
+            draw.textures = &textures;
+            draw.textureSet = getTextureSets().intern(textures);
+            draw.instance = queue.addInstance(model);
+
+            return selectDraws(model, eye, lodScale, frustum, cullStats,
+                [&](const Mesh& mesh, size_t lod, const std::vector<MeshletRange>* visibleRanges) {
+                    if (!mesh.VAO) return;
+                    draw.vao = mesh.VAO;
+                    draw.depthVao = mesh.depthVAO;
+                    draw.indexType = mesh.indexType;
+                    draw.indexOffset = mesh.indexByteOffset();
+                    draw.baseVertex = mesh.baseVertex();
+                    draw.packed = mesh.format == VertexFormat::Packed;
+                    if (draw.packed) {
+                        draw.posOffset = mesh.minBounds;
+                        draw.posScale = mesh.getSize();
+                    }
 
-            for (unsigned int i = 0; i < node->mNumChildren; i++) {
-                processNode(node->mChildren[i], scene);
-            }
+                    const float depth = glm::length(glm::vec3(model * glm::vec4(mesh.getCenter(), 1.0f)) - eye);
+                    if (visibleRanges) {
+                        queue.add(layer, depth, draw, visibleRanges->data(), visibleRanges->size());
+                    }
+                    else {
+                        const Mesh::Lod range = mesh.getLod(lod);
+                        const MeshletRange whole{ range.firstIndex, range.indexCount };
+                        queue.add(layer, depth, draw, &whole, 1);
+                    }
+                });
         }
 
-        std::shared_ptr<Mesh> convertMesh(aiMesh* aiMesh) {
-            std::vector<Mesh::Vertex> vertices;
+        // Convert one Assimp mesh. Both streams are sized up front and moved into the Mesh,
+        // so this costs one allocation per stream plus the shared_ptr block.
+        static std::shared_ptr<Mesh> convertMesh(const aiMesh* aiMesh) {
+            std::vector<Mesh::Vertex> vertices(aiMesh->mNumVertices);
             std::vector<unsigned int> indices;
 
+            const bool hasNormals = aiMesh->HasNormals();
+            const bool hasTexCoords = aiMesh->mTextureCoords[0] != nullptr;
+            const bool hasTangents = aiMesh->HasTangentsAndBitangents();
+
             // Convert vertices
             for (unsigned int i = 0; i < aiMesh->mNumVertices; i++) {
-                Mesh::Vertex vertex;
+                Mesh::Vertex& vertex = vertices[i];
 
                 vertex.position = glm::vec3(
                     aiMesh->mVertices[i].x,
@@ -239,7 +1075,7 @@ namespace gl {
                     aiMesh->mVertices[i].z
                 );
 
-                if (aiMesh->HasNormals()) {
+                if (hasNormals) {
                     vertex.normal = glm::vec3(
                         aiMesh->mNormals[i].x,
                         aiMesh->mNormals[i].y,
@@ -247,37 +1083,360 @@ namespace gl {
                     );
                 }
 
-                if (aiMesh->mTextureCoords[0]) {
+                if (hasTexCoords) {
                     vertex.texCoords = glm::vec2(
                         aiMesh->mTextureCoords[0][i].x,
                         aiMesh->mTextureCoords[0][i].y
                     );
                 }
 
-                vertices.push_back(vertex);
+                if (hasTangents) {
+                    vertex.tangent = glm::vec3(
+                        aiMesh->mTangents[i].x,
+                        aiMesh->mTangents[i].y,
+                        aiMesh->mTangents[i].z
+                    );
+                    vertex.bitangent = glm::vec3(
+                        aiMesh->mBitangents[i].x,
+                        aiMesh->mBitangents[i].y,
+                        aiMesh->mBitangents[i].z
+                    );
+                }
             }
 
             // Convert indices
+            size_t indexCount = 0;
+            for (unsigned int i = 0; i < aiMesh->mNumFaces; i++) {
+                indexCount += aiMesh->mFaces[i].mNumIndices;
+            }
+
+            indices.resize(indexCount);
+            size_t write = 0;
             for (unsigned int i = 0; i < aiMesh->mNumFaces; i++) {
-                aiFace face = aiMesh->mFaces[i];
+                const aiFace& face = aiMesh->mFaces[i];
                 for (unsigned int j = 0; j < face.mNumIndices; j++) {
-                    indices.push_back(face.mIndices[j]);
+                    indices[write++] = face.mIndices[j];
                 }
             }
 
-            return std::make_shared<Mesh>(vertices, indices);
+            return std::make_shared<Mesh>(std::move(vertices), std::move(indices));
         }
+
+        // Convert one .glb primitive into Mesh::Vertex, generating normals and tangents like
+        // aiProcess_GenSmoothNormals / aiProcess_CalcTangentSpace when the file has none
+        static std::shared_ptr<Mesh> convertPrimitive(const GlbPrimitive& prim, bool flipV) {
+            const size_t vertexCount = prim.vertexCount();
+            std::vector<Mesh::Vertex> vertices(vertexCount);
+            std::vector<unsigned int> indices(prim.indexCount());
+
+            std::vector<glm::vec3> normals;
+            std::vector<glm::vec4> tangents;
+            if (!prim.normal.valid()) glb::generateNormals(prim, normals);
+            if (!prim.tangent.valid() && prim.texCoord.valid()) glb::generateTangents(prim, normals.empty() ? nullptr : &normals, tangents);
+
+            for (size_t i = 0; i < vertexCount; i++) {
+                Mesh::Vertex& vertex = vertices[i];
+                vertex.position = glm::vec3(prim.position.read(i));
+                vertex.normal = normals.empty() ? glm::vec3(prim.normal.read(i)) : normals[i];
+
+                if (prim.texCoord.valid()) {
+                    glm::vec4 t = prim.texCoord.read(i);
+                    vertex.texCoords = glm::vec2(t.x, flipV ? 1.0f - t.y : t.y);
+                }
+
+                glm::vec4 tangent = prim.tangent.valid() ? prim.tangent.read(i) : (tangents.empty() ? glm::vec4(0.0f) : tangents[i]);
+                vertex.tangent = glm::vec3(tangent);
+                vertex.bitangent = glm::cross(vertex.normal, vertex.tangent) * (tangent.w < 0.0f ? -1.0f : 1.0f);
+            }
+
+            for (size_t i = 0; i < indices.size(); i++) {
+                indices[i] = prim.index(i);
+            }
+
+            return std::make_shared<Mesh>(std::move(vertices), std::move(indices));
+        }
+
+    private:
+        // Per-mesh LOD selection and meshlet culling shared by render() and gatherDraws().
+        // emit(mesh, lod, visibleRanges) gets the culled meshlet ranges, or nullptr to draw the whole LOD.
+        template <class Emit>
+        size_t selectDraws(const glm::mat4& model, const glm::vec3& eye, float lodScale, const Frustum* frustum,
+            MeshletCullStats* cullStats, Emit&& emit) const
+        {
+            // Object-space error scales with the largest axis of the object
+            const float maxScale = glm::max(glm::abs(scale.x), glm::max(glm::abs(scale.y), glm::abs(scale.z)));
+            const glm::vec3 eyeObjectSpace = glm::vec3(glm::inverse(model) * glm::vec4(eye, 1.0f));
+
+            thread_local std::vector<MeshletRange> ranges;
+            size_t triangles = 0;
+            for (const auto& mesh : meshes) {
+                size_t lod = 0;
+                if (lodScale > 0.0f && mesh->lodCount() > 1) {
+                    glm::vec3 center = glm::vec3(model * glm::vec4(mesh->getCenter(), 1.0f));
+                    float radius = glm::length(mesh->getExtents()) * maxScale;
+                    float distance = glm::max(glm::length(center - eye) - radius, 0.0f);
+                    lod = mesh->selectLod(distance, lodScale * maxScale);
+                }
+
+                if (lodScale > 0.0f && lod == 0 && !mesh->meshlets.empty()) {
+                    ranges.clear();
+                    meshopt::cullMeshlets(ranges, mesh->meshlets.data(), mesh->meshlets.size(), model, frustum, &eyeObjectSpace, cullStats);
+                    emit(*mesh, lod, &ranges);
+                    for (const auto& range : ranges) triangles += range.indexCount / 3;
+                    continue;
+                }
+
+                emit(*mesh, lod, nullptr);
+                triangles += mesh->getLod(lod).indexCount / 3;
+            }
+            return triangles;
+        }
+
+        // Decode images on pool workers while this thread and the pool run meshStep(i) over out.meshes.
+        // Images go first so their long decodes start while the mesh work is still being handed out.
+        template <class MeshStep>
+        static void buildParallel(ImportedModel& out, const std::vector<EmbeddedImage>& images, MeshStep&& meshStep) {
+            const auto start = ImportTimings::clock::now();
+            std::vector<double> decodeMs(images.size()), convertMs(out.meshes.size());
+
+            out.images.resize(images.size());
+            auto decode = getThreadPool().launch(images.size(), [&](size_t i) {
+                const auto begin = ImportTimings::clock::now();
+                if (!out.images[i].decode(images[i], GL_GLB_FLIP_V))
+                    std::cerr << "Failed to decode embedded texture of " << out.path << ": " << stbi_failure_reason() << std::endl;
+                decodeMs[i] = ImportTimings::since(begin);
+            });
+
+            getThreadPool().parallelFor(out.meshes.size(), [&](size_t i) {
+                const auto begin = ImportTimings::clock::now();
+                meshStep(i);
+                convertMs[i] = ImportTimings::since(begin);
+            });
+            decode->wait();
+
+            auto& t = out.timings;
+            t.parallelMs = ImportTimings::since(start);
+            for (double ms : decodeMs) t.decodeMs += ms;
+            for (double ms : convertMs) t.convertMs += ms;
+            std::erase_if(out.images, [](const DecodedImage& image) { return !image.pixels; });
+            t.images = out.images.size();
+            for (const auto& image : out.images) t.imageBytes += image.byteSize();
+        }
+
+        static std::vector<std::shared_ptr<EmbeddedTexture>> liveTextures(const ImportedModel& model) {
+            std::vector<std::shared_ptr<EmbeddedTexture>> live;
+            for (const auto& texture : model.textures) {
+                if (texture) live.push_back(texture);
+            }
+            return live;
+        }
+
+        // Compressed textures embedded in the scene ("*0", "*1", ... paths), by material slot.
+        // Uncompressed embedded texels are rare and skipped.
+        static void collectImages(const aiScene* scene, std::vector<EmbeddedImage>& out) {
+            static const std::pair<aiTextureType, const char*> slots[] = {
+                { aiTextureType_BASE_COLOR, slot::BASE_COLOR },
+                { aiTextureType_DIFFUSE, slot::BASE_COLOR },
+                { aiTextureType_GLTF_METALLIC_ROUGHNESS, slot::METALLIC_ROUGHNESS },
+                { aiTextureType_METALNESS, slot::METALLIC_ROUGHNESS },
+                { aiTextureType_NORMALS, slot::NORMAL },
+                { aiTextureType_AMBIENT_OCCLUSION, slot::OCCLUSION },
+                { aiTextureType_LIGHTMAP, slot::OCCLUSION },
+                { aiTextureType_EMISSIVE, slot::EMISSIVE },
+                { aiTextureType_EMISSION_COLOR, slot::EMISSIVE },
+            };
+
+            out.clear();
+            std::unordered_map<const aiTexture*, size_t> lookup;
+            for (unsigned int m = 0; m < scene->mNumMaterials; m++) {
+                const aiMaterial* material = scene->mMaterials[m];
+                for (const auto& [type, slotName] : slots) {
+                    aiString file;
+                    if (material->GetTexture(type, 0, &file) != AI_SUCCESS) continue;
+
+                    const aiTexture* texture = scene->GetEmbeddedTexture(file.C_Str());
+                    if (!texture || texture->mHeight != 0) continue;
+
+                    auto [it, inserted] = lookup.emplace(texture, out.size());
+                    if (inserted) {
+                        EmbeddedImage image;
+                        image.data = reinterpret_cast<const unsigned char*>(texture->pcData);
+                        image.size = texture->mWidth;
+                        out.push_back(image);
+                    }
+                    EmbeddedImage::assign(out, it->second, slotName);
+                }
+            }
+            std::erase_if(out, [](const EmbeddedImage& image) { return image.slots.empty(); });
+        }
+
+        static void collectMeshes(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& out) {
+            for (unsigned int i = 0; i < node->mNumMeshes; i++) {
+                out.push_back(scene->mMeshes[node->mMeshes[i]]);
+            }
+
+            for (unsigned int i = 0; i < node->mNumChildren; i++) {
+                collectMeshes(node->mChildren[i], scene, out);
+            }
+        }
+    };
+
+    // ============ ENTITY COMPONENTS ============
+    // Scene entities (Ecs.hpp) hold an Object's data as separate components, each in its own contiguous
+    // array, so a system only streams through what it reads. Scene::addEntity fills them from a loaded Object.
+    struct Transform {
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+        glm::vec3 scale = glm::vec3(1.0f);
+    };
+
+    // Written from Transform by updateEntityTransforms
+    struct WorldTransform {
+        glm::mat4 model = glm::mat4(1.0f);
+    };
+
+    // Every mesh of one shared asset; entities with the same asset, shader and textures draw as one instance group
+    struct Renderable {
+        std::shared_ptr<MeshAsset> asset;
+        std::shared_ptr<gl::shader> shader;
+        const std::unordered_map<std::string, GLuint>* textures = nullptr; // interned in TextureSets, so equal sets share it
+        glm::vec3 minBounds = glm::vec3(0.0f); // object space, around all meshes
+        glm::vec3 maxBounds = glm::vec3(0.0f);
+    };
+
+    // Rigid body whose pose drives the entity's Transform (syncEntityPhysics)
+    struct PhysicsLink {
+        JPH::BodyID body;
+        JPH::BodyInterface* bodies = nullptr;
+    };
+
+    struct EntityFlags {
+        static constexpr uint8_t Visible = 1;
+        static constexpr uint8_t Culled = 2; // by the last cullEntities
+        uint8_t bits = Visible;
+    };
+
+    struct EntityStats {
+        size_t entities = 0;  // with a Renderable
+        size_t culled = 0;    // invisible or outside the frustum
+        size_t batches = 0;   // (asset, shader, textures) groups drawn
+        size_t drawCalls = 0;
+    };
+
+    // ============ ENTITY SYSTEMS ============
+    // Transforms of physics-driven entities from their bodies
+    inline void syncEntityPhysics(Registry& registry) {
+        registry.each<PhysicsLink, Transform>([](Entity, const PhysicsLink& link, Transform& transform) {
+            if (!link.bodies) return;
+            const JPH::Vec3 pos = link.bodies->GetPosition(link.body);
+            const JPH::Quat rot = link.bodies->GetRotation(link.body);
+            transform.position = glm::vec3(pos.GetX(), pos.GetY(), pos.GetZ());
+            transform.rotation = glm::quat(rot.GetW(), rot.GetX(), rot.GetY(), rot.GetZ());
+        });
+    }
+
+    // Model matrices, in parallel chunks: the same translate * rotate * scale as Object::getModelMatrix
+    inline void updateEntityTransforms(Registry& registry) {
+        registry.parallelEach<Transform, WorldTransform>([](Entity, const Transform& transform, WorldTransform& world) {
+            const glm::mat3 rotation = glm::mat3_cast(transform.rotation);
+            world.model = glm::mat4(
+                glm::vec4(rotation[0] * transform.scale.x, 0.0f),
+                glm::vec4(rotation[1] * transform.scale.y, 0.0f),
+                glm::vec4(rotation[2] * transform.scale.z, 0.0f),
+                glm::vec4(transform.position, 1.0f));
+        });
+    }
+
+    // Flag renderable entities that are invisible or, given a frustum, whose world bounds lie outside it
+    inline void cullEntities(Registry& registry, const Frustum* frustum) {
+        registry.parallelEach<Renderable, WorldTransform, EntityFlags>(
+            [frustum](Entity, const Renderable& renderable, const WorldTransform& world, EntityFlags& flags) {
+                bool hidden = !(flags.bits & EntityFlags::Visible);
+                if (!hidden && frustum) {
+                    glm::vec3 minBounds, maxBounds;
+                    transformAabb(world.model, renderable.minBounds, renderable.maxBounds, minBounds, maxBounds);
+                    hidden = !frustum->intersectsAabb(minBounds, maxBounds);
+                }
+                flags.bits = hidden ? uint8_t(flags.bits | EntityFlags::Culled) : uint8_t(flags.bits & ~EntityFlags::Culled);
+            });
+    }
+
+    // Objects drawing the same shared asset with the same shader, i.e. candidates for one instanced draw
+    struct InstanceBatch {
+        std::shared_ptr<MeshAsset> asset;
+        std::shared_ptr<gl::shader> shader;
+        std::vector<Object*> objects;
     };
 
     // ============ SCENE CLASS ============
     class Scene {
     private:
         std::string name;
-        std::vector<std::shared_ptr<Object>> objects;
-        std::vector<std::shared_ptr<gl::player>> players;
+        SlotMap<std::shared_ptr<Object>> objects;
+        std::vector<std::shared_ptr<Object>> players;
+        bool nameIndexed = false;
+        std::unordered_multimap<std::string, SlotHandle> nameIndex;
         std::vector<std::shared_ptr<window>> uiWindows;
         JPH::PhysicsSystem* physicsSystem = nullptr;
         JPH::TempAllocatorImpl* tempAllocator;
+        size_t trianglesRendered = 0;
+        MeshletCullStats cullStats;
+        BindStats binds;
+        StateStats state;
+        bool batched = false;
+        MultiDrawQueue drawQueue;
+        bool sorted = false;
+        RenderQueue renderQueue;
+        bool instancing = false;
+        bool depthPrepass = false;
+        std::shared_ptr<gl::shader> depthShader;
+        bool overdrawCounting = false;
+        SampleCounter depthSamples;
+        SampleCounter shadedSamples;
+        bool occlusionCulling = false;
+        HiZCuller occlusion;
+        std::vector<OcclusionBounds> occlusionBounds;
+        std::vector<uint8_t> occlusionVisible;
+        // Hi-Z results for record(), one per CommandList: filled by the tasks that list runs on the render thread,
+        // read when the list is next recorded into (RenderThread::begin has waited for it by then)
+        struct RecordedOcclusion {
+            std::vector<OcclusionBounds> bounds;
+            std::vector<uint8_t> visible;
+            uint64_t key = 0; // of the tested objects, as in cullObjects
+        };
+        std::unordered_map<const CommandList*, RecordedOcclusion> recordedOcclusion;
+        AabbSoA worldBounds;               // of boundsObjects, rebuilt every culled render
+        std::vector<Object*> boundsObjects;
+        std::vector<uint32_t> inFrustum;   // indices into boundsObjects
+        FrustumCullStats frustumStats;
+        DynamicBvh spatialIndex;           // objects and players by world bounds
+        TransformHierarchy transforms;     // of attached objects
+        uint64_t frame = 0;
+        InstanceStats instanceStats;
+        Registry entities;
+        EntityStats entityStats;
+
+        // Visible entities of one (asset, shader, textures), at entityMatrices[first, first + count)
+        struct EntityBatch {
+            const Renderable* renderable;
+            size_t first;
+            size_t count;
+        };
+        std::vector<EntityBatch> entityBatches;
+        std::vector<uint32_t> entityBatchOf; // per Renderable, UINT32_MAX when culled
+        std::vector<glm::mat4> entityMatrices;
+
+        // Instanced draw of one mesh and LOD for instanceMatrices[first, first + count)
+        struct InstancedDraw {
+            size_t batch;
+            const Mesh* mesh;
+            size_t lod;
+            size_t first;
+            size_t count;
+        };
+        std::vector<InstanceBatch> instanceBatches;
+        std::vector<glm::mat4> instanceMatrices;
+        std::vector<InstancedDraw> instancedDraws;
 
     public:
         Scene(const std::string& sceneName = "Scene") 
@@ -291,29 +1450,82 @@ namespace gl {
         }
 
         // Object management
+        // Objects live in a slot map: obj->handle stays valid until the object is removed, and adding,
+        // removing and getObject(handle) are O(1). Removal moves the last object into the gap, so
+        // iteration order is not insertion order.
         std::shared_ptr<Object> addObject(const std::string& name) {
-            auto obj = std::make_shared<Object>(name);
-            objects.push_back(obj);
-            return obj;
+            return addObject(std::make_shared<Object>(name));
         }
 
         std::shared_ptr<Object> addObject(std::shared_ptr<Object> obj) {
-            objects.push_back(obj);
+            obj->handle = objects.insert(obj);
+            if (nameIndexed) nameIndex.emplace(obj->name, obj->handle);
+            indexObject(*obj);
             return obj;
         }
 
+        // False if handle is stale
+        bool removeObject(SlotHandle handle) {
+            std::shared_ptr<Object>* slot = objects.get(handle);
+            if (!slot) return false;
+            Object& obj = **slot;
+            detachObject(obj);
+            spatialIndex.destroyProxy(obj.bvhProxy);
+            obj.bvhProxy = DynamicBvh::NONE;
+            if (nameIndexed) unindexName(obj.name, handle);
+            obj.handle = SlotHandle();
+            objects.erase(handle);
+            return true;
+        }
+
+        // Every object with this name
         void removeObject(const std::string& name) {
-            objects.erase(
-                std::remove_if(objects.begin(), objects.end(),
-                    [&](const auto& obj) { return obj->name == name; }),
-                objects.end()
-            );
+            std::vector<SlotHandle> removed;
+            if (nameIndexed) {
+                auto [first, last] = nameIndex.equal_range(name);
+                for (auto it = first; it != last; ++it) removed.push_back(it->second);
+            }
+            else {
+                for (const auto& obj : objects) {
+                    if (obj->name == name) removed.push_back(obj->handle);
+                }
+            }
+            for (SlotHandle handle : removed) removeObject(handle);
+        }
+
+        // nullptr if handle is stale; no reference counting
+        Object* getObject(SlotHandle handle) const {
+            const std::shared_ptr<Object>* slot = objects.get(handle);
+            return slot ? slot->get() : nullptr;
+        }
+
+        // Hashed name lookup for findObject/findHandle/removeObject(name) instead of a linear scan. Rename
+        // indexed objects through renameObject. With duplicate names, lookups return any one of them.
+        void setNameIndex(bool enabled) {
+            nameIndexed = enabled;
+            nameIndex.clear();
+            if (!enabled) return;
+            nameIndex.reserve(objects.size());
+            for (const auto& obj : objects) nameIndex.emplace(obj->name, obj->handle);
+        }
+        bool isNameIndexed() const { return nameIndexed; }
+
+        bool renameObject(SlotHandle handle, const std::string& newName) {
+            Object* obj = getObject(handle);
+            if (!obj) return false;
+            if (nameIndexed) {
+                unindexName(obj->name, handle);
+                nameIndex.emplace(newName, handle);
+            }
+            obj->name = newName;
+            return true;
         }
 
         // Player management
         std::shared_ptr<Object> addPlayer(const std::string& name) {
             auto player = std::make_shared<Object>(name);
             players.push_back(player);
+            indexObject(*player);
             return player;
         }
 
@@ -343,10 +1555,18 @@ namespace gl {
                     }
                 }
             }
+
+            updateTransforms();
+            updateSpatialIndex();
+
+            syncEntityPhysics(entities);
+            updateEntityTransforms(entities);
         }
 
         // Render everything
         void render() {
+            beginFrame();
+
             // Render objects
             for (auto& obj : objects) {
                 obj->render();
@@ -357,25 +1577,685 @@ namespace gl {
                 player->render();
             }
 
+            // Render entities
+            renderEntities(nullptr);
+
             // Render UI (you'd handle this with ImGui)
             for (auto& uiWindow : uiWindows) {
                 // UI rendering code here
             }
+            binds = bindStats;
+            state = getGLState().stats();
+        }
+
+        // Render with LOD selection: each mesh draws the coarsest LOD whose projected error
+        // stays under pixelError pixels. Uses the camera's current (possibly zoomed) FOV.
+        void render(const camera& cam, float viewportHeight, float pixelError = 1.0f) {
+            renderCulled(cam, nullptr, viewportHeight, pixelError);
+        }
+
+        // As above, and also culls meshlets against the frustum of projection * cam view
+        void render(const camera& cam, const glm::mat4& projection, float viewportHeight, float pixelError = 1.0f) {
+            const Frustum frustum = Frustum::fromMatrix(projection * cam.getViewMatrix());
+            renderCulled(cam, &frustum, viewportHeight, pixelError);
+        }
+
+        // Batched submission for the culled render() overloads: draws are bucketed by shader, textures and
+        // vertex buffers and each bucket goes out as one glMultiDrawElementsIndirect (one draw per command
+        // on GL 3.3). Use vert_instanced.glsl to get the indirect path. Objects in Packed format still render one by one.
+        void setBatched(bool enabled) { batched = enabled; }
+        bool isBatched() const { return batched; }
+        MultiDrawQueue& getDrawQueue() { return drawQueue; }
+
+        // Automatic instancing for the culled render() overloads: objects sharing an asset, shader and textures
+        // (see buildInstanceBatches) are drawn with one glDrawElementsInstancedBaseVertex per mesh and LOD.
+        // Needs vert_instanced.glsl; other objects take the batched or per-object path as usual.
+        void setInstancing(bool enabled) { instancing = enabled; }
+        bool isInstancing() const { return instancing; }
+        const InstanceStats& getInstanceStats() const { return instanceStats; } // of the last render
+
+        // Record the frame into a CommandList instead of drawing it, for a RenderThread: culling, LOD selection
+        // and sort keys are worked out here, the sorted draws are submitted when the list executes. Every
+        // object is recorded through the sort-key queue (no instancing or batching) and retained by the list.
+        // Objects are frustum culled as in render(); with occlusion culling the Hi-Z test and capture run as
+        // tasks in the list, and their results apply the next time the same list is recorded into, so they lag
+        // a frame more than in render().
+        // Loading models or dropping the last reference to an object's meshes touches GL, so while a
+        // RenderThread runs, do those inside list.run() or keep the object retained until then.
+        void record(CommandList& list, const camera& cam, const glm::mat4& projection, float viewportHeight, float pixelError = 1.0f) {
+            const float lodScale = viewportHeight / (2.0f * std::tan(glm::radians(cam.getFov()) * 0.5f)) / pixelError;
+            const glm::vec3 eye = cam.getPos();
+            const Frustum frustum = Frustum::fromMatrix(projection * cam.getViewMatrix());
+
+            frame++;
+            trianglesRendered = 0;
+            cullStats = MeshletCullStats();
+            cullFrustum(&frustum);
+            if (occlusionCulling) recordOcclusion(list);
+
+            RenderQueue& queue = list.scene();
+            queue.sortEnabled = renderQueue.sortEnabled;
+            auto add = [&](const std::shared_ptr<Object>& obj) {
+                if (!obj->visible || !obj->shader || obj->culledFrame == frame) return;
+                list.retain(obj);
+                trianglesRendered += obj->queueDraws(queue, eye, lodScale, &frustum, &cullStats);
+            };
+            for (const auto& obj : objects) add(obj);
+            for (const auto& player : players) add(player);
+
+            if (occlusionCulling) {
+                list.run([this] {
+                    const FrameUniforms& uniforms = getFrameUniforms().current();
+                    occlusion.capture(uniforms.viewProjection, int(uniforms.viewport.x), int(uniforms.viewport.y));
+                });
+            }
+        }
+
+        // Sorted submission for the culled render() overloads: every draw gets a 64-bit key (layer, program,
+        // textures, depth) and the frame's draws go out radix sorted instead of in object order. Applies to
+        // objects the instanced and batched paths leave over; getRenderQueue().stats() has the state changes
+        // the sort saved.
+        void setSorted(bool enabled) { sorted = enabled; }
+        bool isSorted() const { return sorted; }
+        RenderQueue& getRenderQueue() { return renderQueue; }
+
+        // Depth pre-pass for the culled render() overloads: objects the instanced path leaves over go through
+        // the sort-key queue, which first draws their opaque meshes front to back with depthProgram
+        // (vert_depth.glsl, loaded on first use if null) through the position-only vertex stream, then shades
+        // them with GL_LEQUAL against it so each pixel runs the material shader about once. Instanced objects draw first as usual.
+        void setDepthPrepass(bool enabled, std::shared_ptr<gl::shader> depthProgram = nullptr) {
+            depthPrepass = enabled;
+            if (depthProgram) depthShader = std::move(depthProgram);
+            if (enabled && !depthShader)
+                depthShader = std::make_shared<gl::shader>("resource/shader/vert_depth.glsl", "resource/shader/frag_depth.glsl");
+        }
+        bool isDepthPrepass() const { return depthPrepass; }
+
+        // Count samples written by the pre-pass and shaded by the colour passes with occlusion queries.
+        // getOverdrawStats() lags a few frames behind.
+        void setOverdrawCounting(bool enabled) { overdrawCounting = enabled; }
+        OverdrawStats getOverdrawStats() const {
+            const glm::vec4& viewport = getFrameUniforms().current().viewport;
+            return { depthSamples.samples(), shadedSamples.samples(), uint64_t(viewport.x) * uint64_t(viewport.y) };
+        }
+
+        // Hi-Z occlusion culling for the culled render() overloads: each frame's depth buffer is reduced to a
+        // max-depth pyramid after the draws, and the next frame skips objects whose world bounds lie behind it
+        // (Occlusion.hpp: compute shader where GL 4.3 is available, else CPU over a PBO readback). Tests use the
+        // Frame block's view-projection and viewport, so upload it before render(). Results lag a frame or two.
+        void setOcclusionCulling(bool enabled) { occlusionCulling = enabled; }
+        bool isOcclusionCulling() const { return occlusionCulling; }
+        HiZCuller& getOcclusionCuller() { return occlusion; }
+        const OcclusionStats& getOcclusionStats() const { return occlusion.stats(); } // of the last render
+
+        // Objects tested against and culled by the frustum of the last render(cam, projection, ...)
+        const FrustumCullStats& getFrustumStats() const { return frustumStats; }
+
+        // Transform hierarchy (Hierarchy.hpp): an attached object's position, rotation and scale are relative to
+        // its parent node, and getModelMatrix returns the world matrix cached by the last updateTransforms(),
+        // which pushes changed local transforms in and recomputes only the dirty subtrees, one depth at a time.
+        // update() calls it; after moving attached objects elsewhere, call it before rendering. Nodes without an
+        // object (e.g. a camera, via getTransforms().setLocalMatrix(getCameraModel(cam))) can be parents too.
+        // Keep physics-driven objects as roots: bodies report world poses.
+        bool attachObject(Object& obj, SlotHandle parentNode) {
+            if (obj.hierarchy == &transforms) return transforms.setParent(obj.transformNode, parentNode);
+            obj.transformNode = transforms.create(parentNode);
+            obj.hierarchy = &transforms;
+            transforms.setUser(obj.transformNode, &obj);
+            transforms.setLocal(obj.transformNode, obj.position, obj.rotation, obj.scale);
+            return true;
+        }
+
+        // Under parent (attached as a root first if it is not yet), or as a root
+        bool attachObject(Object& obj, Object* parent = nullptr) {
+            if (parent == &obj) return false;
+            if (parent && parent->hierarchy != &transforms) attachObject(*parent);
+            return attachObject(obj, parent ? parent->transformNode : SlotHandle());
+        }
+
+        // obj stays where it is: its transform fields become its world transform. Its children move up to its
+        // parent and stay put as well, their fields re-based onto the new parent (shear is lost, see decomposeTrs).
+        void detachObject(Object& obj) {
+            if (obj.hierarchy != &transforms) return;
+            const SlotHandle node = obj.transformNode;
+
+            // Push field edits updateTransforms() has not seen yet, for obj, its ancestors and its children
+            auto sync = [&](SlotHandle n) {
+                if (auto* o = static_cast<Object*>(transforms.getUser(n))) transforms.setLocal(n, o->position, o->rotation, o->scale);
+            };
+            for (SlotHandle n = node; n; n = transforms.getParent(n)) sync(n);
+            std::vector<SlotHandle> children;
+            transforms.getChildren(node, children);
+            for (SlotHandle child : children) sync(child);
+
+            decomposeTrs(transforms.computeWorld(node), obj.position, obj.rotation, obj.scale);
+            transforms.destroy(node);
+            for (SlotHandle child : children) {
+                if (auto* o = static_cast<Object*>(transforms.getUser(child)))
+                    decomposeTrs(transforms.computeLocal(child), o->position, o->rotation, o->scale);
+            }
+            obj.hierarchy = nullptr;
+            obj.transformNode = SlotHandle();
+        }
+
+        void updateTransforms() {
+            auto sync = [&](Object& obj) {
+                if (obj.hierarchy == &transforms) transforms.setLocal(obj.transformNode, obj.position, obj.rotation, obj.scale);
+            };
+            for (auto& obj : objects) sync(*obj);
+            for (auto& player : players) sync(*player);
+            transforms.update();
+        }
+
+        TransformHierarchy& getTransforms() { return transforms; }
+        const HierarchyStats& getTransformStats() const { return transforms.stats(); } // of the last updateTransforms
+
+        // Entities: a data-oriented alternative to Objects for large numbers of simple copies. Components live in
+        // contiguous per-type arrays of a Registry (Ecs.hpp) and systems walk them linearly or in parallel chunks.
+        // update() runs syncEntityPhysics and updateEntityTransforms; after moving entities by hand call
+        // updateEntityTransforms(getEntities()) before rendering. Both render paths cull entities against the
+        // frustum (if any) and draw them at LOD 0 grouped by asset and material, instanced with
+        // vert_instanced.glsl. No meshlets, LODs, batching, sorting, occlusion culling or record().
+        Entity addEntity(const Object& prototype) {
+            const Entity entity = entities.create();
+            entities.add<Transform>(entity, prototype.position, prototype.rotation, prototype.scale);
+            entities.add<WorldTransform>(entity, prototype.getModelMatrix());
+            entities.add<EntityFlags>(entity, uint8_t(prototype.visible ? EntityFlags::Visible : 0));
+            if (prototype.assets.size() == 1 && prototype.shader) {
+                const std::shared_ptr<MeshAsset>& asset = prototype.assets[0];
+                glm::vec3 minBounds(FLT_MAX), maxBounds(-FLT_MAX);
+                for (const auto& mesh : asset->meshes) {
+                    minBounds = glm::min(minBounds, mesh->minBounds);
+                    maxBounds = glm::max(maxBounds, mesh->maxBounds);
+                }
+                const auto* textures = &getTextureSets().get(getTextureSets().intern(prototype.textures));
+                entities.add<Renderable>(entity, asset, prototype.shader, textures, minBounds, maxBounds);
+            }
+            return entity;
+        }
+
+        // False if entity is stale
+        bool removeEntity(Entity entity) { return entities.destroy(entity); }
+        Registry& getEntities() { return entities; }
+        const EntityStats& getEntityStats() const { return entityStats; } // of the last render
+
+        // Spatial index: objects and players in a DynamicBvh by world bounds (Bvh.hpp), or as a point at their
+        // position until they have meshes. update() refreshes it after physics; after moving objects or loading
+        // models by hand call updateSpatialIndex(), which only touches the tree for objects that left their fat box.
+        // Queries test the real bounds, so results are exact as of the last refresh.
+        void updateSpatialIndex() {
+            for (auto& obj : objects) indexObject(*obj);
+            for (auto& player : players) indexObject(*player);
+        }
+
+        void updateSpatialIndex(Object& obj) {
+            if (obj.bvhProxy != DynamicBvh::NONE) indexObject(obj);
+        }
+
+        void queryBox(const glm::vec3& minBounds, const glm::vec3& maxBounds, std::vector<Object*>& result) const {
+            result.clear();
+            spatialIndex.queryAabb(minBounds, maxBounds, [&](int32_t proxy) {
+                Object* obj = static_cast<Object*>(spatialIndex.getUserData(proxy));
+                glm::vec3 objMin, objMax;
+                indexBounds(*obj, objMin, objMax);
+                if (glm::all(glm::lessThanEqual(objMin, maxBounds)) && glm::all(glm::greaterThanEqual(objMax, minBounds))) result.push_back(obj);
+                return true;
+            });
+        }
+
+        void querySphere(const glm::vec3& center, float radius, std::vector<Object*>& result) const {
+            result.clear();
+            spatialIndex.querySphere(center, radius, [&](int32_t proxy) {
+                Object* obj = static_cast<Object*>(spatialIndex.getUserData(proxy));
+                glm::vec3 objMin, objMax;
+                indexBounds(*obj, objMin, objMax);
+                const glm::vec3 d = glm::clamp(center, objMin, objMax) - center;
+                if (glm::dot(d, d) <= radius * radius) result.push_back(obj);
+                return true;
+            });
+        }
+
+        void queryFrustum(const Frustum& frustum, std::vector<Object*>& result) const {
+            result.clear();
+            spatialIndex.queryFrustum(frustum, [&](int32_t proxy) {
+                Object* obj = static_cast<Object*>(spatialIndex.getUserData(proxy));
+                glm::vec3 objMin, objMax;
+                indexBounds(*obj, objMin, objMax);
+                if (frustum.intersectsAabb(objMin, objMax)) result.push_back(obj);
+                return true;
+            });
+        }
+
+        // Nearest object whose world bounds the ray origin + t * direction, t in [0, maxDistance], hits;
+        // distance gets its t. nullptr if none.
+        Object* raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance = FLT_MAX, float* distance = nullptr) const {
+            const glm::vec3 inverse = 1.0f / direction;
+            Object* nearest = nullptr;
+            float nearestT = maxDistance;
+            spatialIndex.raycast(origin, direction, maxDistance, [&](int32_t proxy) {
+                Object* obj = static_cast<Object*>(spatialIndex.getUserData(proxy));
+                glm::vec3 objMin, objMax;
+                float t;
+                indexBounds(*obj, objMin, objMax);
+                if (rayAabb(origin, inverse, objMin, objMax, nearestT, t) && (!nearest || t < nearestT)) {
+                    nearest = obj;
+                    nearestT = t;
+                }
+                return nearestT;
+            });
+            if (nearest && distance) *distance = nearestT;
+            return nearest;
         }
 
+        const DynamicBvh& getSpatialIndex() const { return spatialIndex; }
+
         // Getters
         const std::string& getName() const { return name; }
         size_t getObjectCount() const { return objects.size(); }
         size_t getPlayerCount() const { return players.size(); }
+        size_t getTrianglesRendered() const { return trianglesRendered; }
+        const MeshletCullStats& getCullStats() const { return cullStats; }
+        const BindStats& getBindStats() const { return binds; } // of the last render
+        const StateStats& getStateStats() const { return state; } // GL calls issued and skipped by the last render
 
-        std::vector<std::shared_ptr<Object>> getObjects() const { return objects; }
+        std::vector<std::shared_ptr<Object>> getObjects() const { return objects.values(); }
         std::vector<std::shared_ptr<Object>> getPlayers() const { return players; }
 
         std::shared_ptr<Object> findObject(const std::string& name) {
-            for (auto& obj : objects) {
-                if (obj->name == name) return obj;
+            const std::shared_ptr<Object>* slot = objects.get(findHandle(name));
+            return slot ? *slot : nullptr;
+        }
+
+        // Invalid handle if there is no such object
+        SlotHandle findHandle(const std::string& name) const {
+            if (nameIndexed) {
+                auto it = nameIndex.find(name);
+                return it != nameIndex.end() ? it->second : SlotHandle();
+            }
+            for (const auto& obj : objects) {
+                if (obj->name == name) return obj->handle;
+            }
+            return SlotHandle();
+        }
+
+        // Group visible objects that consist of exactly one shared asset by (asset, shader, textures).
+        // Batches with more than one object can be drawn instanced.
+        void buildInstanceBatches(std::vector<InstanceBatch>& batches) const {
+            batches.clear();
+
+            using Key = std::tuple<const MeshAsset*, const gl::shader*, uint32_t>; // textures as a TextureSets id
+            struct KeyHash {
+                size_t operator()(const Key& k) const {
+                    return std::hash<const void*>()(std::get<0>(k)) ^ (std::hash<const void*>()(std::get<1>(k)) << 1)
+                        ^ static_cast<size_t>(uint64_t(std::get<2>(k)) * 0x9e3779b97f4a7c15ull);
+                }
+            };
+            std::unordered_map<Key, size_t, KeyHash> lookup;
+
+            auto add = [&](const std::shared_ptr<Object>& obj) {
+                if (!obj->visible || !obj->shader || obj->assets.size() != 1 || obj->meshes.size() != obj->assets[0]->meshes.size()) return;
+
+                const Key key{ obj->assets[0].get(), obj->shader.get(), getTextureSets().intern(obj->textures) };
+                auto [it, inserted] = lookup.emplace(key, batches.size());
+                if (inserted) batches.push_back({ obj->assets[0], obj->shader, {} });
+                batches[it->second].objects.push_back(obj.get());
+            };
+
+            for (const auto& obj : objects) add(obj);
+            for (const auto& player : players) add(player);
+        }
+
+    private:
+        void renderCulled(const camera& cam, const Frustum* frustum, float viewportHeight, float pixelError) {
+            const float lodScale = viewportHeight / (2.0f * std::tan(glm::radians(cam.getFov()) * 0.5f)) / pixelError;
+            const glm::vec3 eye = cam.getPos();
+
+            beginFrame();
+            trianglesRendered = 0;
+            cullStats = MeshletCullStats();
+            instanceStats = InstanceStats();
+            const bool prepass = depthPrepass && depthShader;
+            if (frustum || occlusionCulling) cullObjects(frustum);
+            if (overdrawCounting) {
+                depthSamples.beginFrame();
+                shadedSamples.beginFrame();
+                shadedSamples.begin();
+            }
+            if (instancing) trianglesRendered += renderInstanced(eye, lodScale, frustum);
+            trianglesRendered += renderEntities(frustum);
+
+            if (batched && !prepass) drawQueue.clear();
+            if (sorted || prepass) renderQueue.clear();
+            auto draw = [&](Object& obj) {
+                if (obj.instancedFrame == frame || obj.culledFrame == frame) return;
+                if (prepass) trianglesRendered += obj.queueDraws(renderQueue, eye, lodScale, frustum, &cullStats);
+                else if (batched && obj.vertexFormat != VertexFormat::Packed)
+                    trianglesRendered += obj.gatherDraws(drawQueue, eye, lodScale, frustum, &cullStats);
+                else if (sorted) trianglesRendered += obj.queueDraws(renderQueue, eye, lodScale, frustum, &cullStats);
+                else trianglesRendered += obj.render(eye, lodScale, frustum, &cullStats);
+            };
+            for (auto& obj : objects) draw(*obj);
+            for (auto& player : players) draw(*player);
+
+            if (prepass) {
+                if (overdrawCounting) {
+                    shadedSamples.end();
+                    depthSamples.begin();
+                }
+                renderQueue.submitDepth(*depthShader);
+                if (overdrawCounting) {
+                    depthSamples.end();
+                    shadedSamples.begin();
+                }
+            }
+            if (batched && !prepass) drawQueue.submit();
+            if (sorted || prepass) renderQueue.submit(prepass);
+            if (overdrawCounting) shadedSamples.end();
+            binds = bindStats;
+            state = getGLState().stats();
+
+            if (occlusionCulling) {
+                const FrameUniforms& uniforms = getFrameUniforms().current();
+                occlusion.capture(uniforms.viewProjection, int(uniforms.viewport.x), int(uniforms.viewport.y));
             }
-            return nullptr;
+        }
+
+        // Cull the renderable entities, counting-sort the visible ones' matrices by (asset, shader, textures)
+        // and draw each group: one instanced draw per mesh if the shader reads instanceModel, else one per entity
+        size_t renderEntities(const Frustum* frustum) {
+            ComponentPool<Renderable>& renderables = entities.pool<Renderable>();
+            ComponentPool<WorldTransform>& worlds = entities.pool<WorldTransform>();
+            ComponentPool<EntityFlags>& flags = entities.pool<EntityFlags>();
+            entityStats = EntityStats();
+            entityStats.entities = renderables.size();
+            if (!renderables.size()) return 0;
+            cullEntities(entities, frustum);
+
+            using Key = std::tuple<const MeshAsset*, const gl::shader*, const void*>;
+            struct KeyHash {
+                size_t operator()(const Key& k) const {
+                    return std::hash<const void*>()(std::get<0>(k)) ^ (std::hash<const void*>()(std::get<1>(k)) << 1)
+                        ^ (std::hash<const void*>()(std::get<2>(k)) << 2);
+                }
+            };
+            thread_local std::unordered_map<Key, uint32_t, KeyHash> lookup;
+            lookup.clear();
+            entityBatches.clear();
+            entityBatchOf.assign(renderables.size(), UINT32_MAX);
+
+            for (size_t i = 0; i < renderables.size(); i++) {
+                const uint32_t entity = renderables.entities()[i];
+                const Renderable& renderable = renderables.data()[i];
+                if ((flags.has(entity) && (flags.get(entity).bits & EntityFlags::Culled)) || !worlds.has(entity) || !renderable.asset || !renderable.shader) {
+                    entityStats.culled++;
+                    continue;
+                }
+                const Key key{ renderable.asset.get(), renderable.shader.get(), renderable.textures };
+                auto [it, inserted] = lookup.emplace(key, static_cast<uint32_t>(entityBatches.size()));
+                if (inserted) entityBatches.push_back({ &renderable, 0, 0 });
+                entityBatches[it->second].count++;
+                entityBatchOf[i] = it->second;
+            }
+            if (entityBatches.empty()) return 0;
+
+            size_t total = 0;
+            for (EntityBatch& batch : entityBatches) {
+                batch.first = total;
+                total += batch.count;
+                batch.count = 0;
+            }
+            entityMatrices.resize(total);
+            for (size_t i = 0; i < renderables.size(); i++) {
+                if (entityBatchOf[i] == UINT32_MAX) continue;
+                EntityBatch& batch = entityBatches[entityBatchOf[i]];
+                entityMatrices[batch.first + batch.count++] = worlds.get(renderables.entities()[i]).model;
+            }
+
+            InstanceStream& stream = getInstanceStream();
+            stream.upload(entityMatrices);
+            size_t triangles = 0;
+            for (const EntityBatch& batch : entityBatches) {
+                const Renderable& renderable = *batch.renderable;
+                gl::shader& program = *renderable.shader;
+                program.useProgram();
+                if (renderable.textures) bindMaterialTextures(program, *renderable.textures);
+                const bool readsInstance = stream.readsInstanceModel(program.getProgram());
+                const bool instanced = readsInstance && renderable.asset->format != VertexFormat::Packed;
+                const GLint modelLoc = program.getUniformLoc("model");
+                entityStats.batches++;
+
+                for (const auto& meshPtr : renderable.asset->meshes) {
+                    const Mesh& mesh = *meshPtr;
+                    if (!mesh.VAO) continue;
+                    const Mesh::Lod range = mesh.getLod(0);
+                    triangles += batch.count * (range.indexCount / 3);
+
+                    if (instanced) {
+                        const size_t indexSize = mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+                        useVertexArray(mesh.VAO);
+                        stream.attach(mesh.VAO, batch.first);
+                        glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(range.indexCount), mesh.indexType,
+                            reinterpret_cast<void*>(mesh.indexByteOffset() + size_t(range.firstIndex) * indexSize),
+                            static_cast<GLsizei>(batch.count), mesh.baseVertex());
+                        entityStats.drawCalls++;
+                        continue;
+                    }
+
+                    if (readsInstance) {
+                        useVertexArray(mesh.VAO);
+                        stream.detach(mesh.VAO);
+                    }
+                    if (mesh.format == VertexFormat::Packed) {
+                        program.setUniform3fv("posOffset", mesh.minBounds);
+                        program.setUniform3fv("posScale", mesh.getSize());
+                    }
+                    for (size_t i = 0; i < batch.count; i++) {
+                        const glm::mat4& model = entityMatrices[batch.first + i];
+                        if (modelLoc >= 0) glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+                        if (readsInstance) InstanceStream::setConstant(model);
+                        mesh.draw(0);
+                        entityStats.drawCalls++;
+                    }
+                }
+            }
+            return triangles;
+        }
+
+        void unindexName(const std::string& objName, SlotHandle handle) {
+            auto [first, last] = nameIndex.equal_range(objName);
+            for (auto it = first; it != last; ++it) {
+                if (it->second == handle) {
+                    nameIndex.erase(it);
+                    return;
+                }
+            }
+        }
+
+        static void indexBounds(const Object& obj, glm::vec3& minBounds, glm::vec3& maxBounds) {
+            if (!obj.getWorldBounds(minBounds, maxBounds)) minBounds = maxBounds = obj.position;
+        }
+
+        // Insert obj into the spatial index, or refit its leaf
+        void indexObject(Object& obj) {
+            glm::vec3 minBounds, maxBounds;
+            indexBounds(obj, minBounds, maxBounds);
+            if (obj.bvhProxy == DynamicBvh::NONE) obj.bvhProxy = spatialIndex.createProxy(minBounds, maxBounds, &obj);
+            else spatialIndex.moveProxy(obj.bvhProxy, minBounds, maxBounds);
+        }
+
+        // Mark the objects outside frustum (if any) as culled this frame and leave the rest in inFrustum.
+        // World bounds go into SoA arrays so cullAabbs tests 4 or 8 per instruction. Touches no GL.
+        void cullFrustum(const Frustum* frustum) {
+            worldBounds.clear();
+            boundsObjects.clear();
+            auto add = [&](Object& obj) {
+                glm::vec3 minBounds, maxBounds;
+                if (!obj.visible || !obj.shader || !obj.getWorldBounds(minBounds, maxBounds)) return;
+                worldBounds.push_back(minBounds, maxBounds);
+                boundsObjects.push_back(&obj);
+            };
+            for (auto& obj : objects) add(*obj);
+            for (auto& player : players) add(*player);
+
+            inFrustum.clear();
+            if (frustum) cullAabbs(*frustum, worldBounds, inFrustum);
+            else for (size_t i = 0; i < boundsObjects.size(); i++) inFrustum.push_back(static_cast<uint32_t>(i));
+
+            size_t next = 0;
+            for (size_t i = 0; i < boundsObjects.size(); i++) {
+                if (next < inFrustum.size() && inFrustum[next] == i) next++;
+                else boundsObjects[i]->culledFrame = frame;
+            }
+            frustumStats.tested = boundsObjects.size();
+            frustumStats.culled = boundsObjects.size() - inFrustum.size();
+        }
+
+        // Bounds of the objects left in inFrustum; returns a key of those objects, so late results match up
+        uint64_t gatherOcclusionBounds(std::vector<OcclusionBounds>& bounds) const {
+            bounds.clear();
+            uint64_t key = 0xcbf29ce484222325ull;
+            for (uint32_t i : inFrustum) {
+                bounds.push_back({ glm::vec4(worldBounds.getMin(i), 0.0f), glm::vec4(worldBounds.getMax(i), 0.0f) });
+                key = (key ^ reinterpret_cast<uintptr_t>(boundsObjects[i])) * 0x100000001b3ull;
+            }
+            return key;
+        }
+
+        // Frustum cull, then with occlusion culling also mark the objects hidden in the last captured depth pyramid
+        void cullObjects(const Frustum* frustum) {
+            cullFrustum(frustum);
+            if (!occlusionCulling) return;
+
+            const uint64_t key = gatherOcclusionBounds(occlusionBounds);
+            occlusion.test(occlusionBounds, occlusionVisible, key);
+            for (size_t j = 0; j < inFrustum.size(); j++) {
+                if (!occlusionVisible[j]) boundsObjects[inFrustum[j]]->culledFrame = frame;
+            }
+        }
+
+        // Occlusion for record(), after cullFrustum: apply what list's last Hi-Z test found if it tested the same
+        // objects, and queue this frame's test on the render thread ahead of the scene
+        void recordOcclusion(CommandList& list) {
+            RecordedOcclusion& recorded = recordedOcclusion[&list];
+            const uint64_t key = gatherOcclusionBounds(occlusionBounds);
+            if (recorded.key == key && recorded.visible.size() == inFrustum.size()) {
+                for (size_t j = 0; j < inFrustum.size(); j++) {
+                    if (!recorded.visible[j]) boundsObjects[inFrustum[j]]->culledFrame = frame;
+                }
+            }
+            recorded.bounds = occlusionBounds;
+            recorded.key = key;
+            list.run([this, &recorded] { occlusion.test(recorded.bounds, recorded.visible, recorded.key); });
+        }
+
+        // Draw every instance batch of GL_INSTANCE_MIN_BATCH or more objects and mark its objects as drawn.
+        // Instances are frustum culled as whole objects and pick a LOD per mesh; matrices are sorted by LOD
+        // so each (mesh, LOD) is one contiguous instanced draw. Meshlet culling is per object and is skipped here.
+        size_t renderInstanced(const glm::vec3& eye, float lodScale, const Frustum* frustum) {
+            InstanceStream& stream = getInstanceStream();
+            buildInstanceBatches(instanceBatches);
+            instanceMatrices.clear();
+            instancedDraws.clear();
+
+            struct Instance {
+                glm::mat4 model;
+                float maxScale;
+            };
+            thread_local std::vector<Instance> visibleInstances;
+            thread_local std::vector<size_t> lods, lodStarts;
+
+            size_t triangles = 0;
+            for (size_t b = 0; b < instanceBatches.size(); b++) {
+                const InstanceBatch& batch = instanceBatches[b];
+                if (batch.objects.size() < GL_INSTANCE_MIN_BATCH || batch.asset->format == VertexFormat::Packed) continue;
+                if (!stream.readsInstanceModel(batch.shader->getProgram())) continue;
+
+                // Object-space bounds of the whole asset, for the per-instance frustum test
+                glm::vec3 minBounds(FLT_MAX), maxBounds(-FLT_MAX);
+                for (const auto& mesh : batch.asset->meshes) {
+                    minBounds = glm::min(minBounds, mesh->minBounds);
+                    maxBounds = glm::max(maxBounds, mesh->maxBounds);
+                }
+                const glm::vec3 center = (minBounds + maxBounds) * 0.5f;
+                const float radius = glm::length(maxBounds - minBounds) * 0.5f;
+
+                visibleInstances.clear();
+                for (Object* obj : batch.objects) {
+                    obj->instancedFrame = frame; // culled instances are done too
+                    if (obj->culledFrame == frame) continue;
+                    const glm::mat4 model = obj->getModelMatrix();
+                    const float maxScale = glm::max(glm::abs(obj->scale.x), glm::max(glm::abs(obj->scale.y), glm::abs(obj->scale.z)));
+                    if (frustum && !frustum->intersectsSphere(glm::vec3(model * glm::vec4(center, 1.0f)), radius * maxScale)) continue;
+                    visibleInstances.push_back({ model, maxScale });
+                }
+                if (visibleInstances.empty()) continue;
+                instanceStats.batches++;
+                instanceStats.instances += visibleInstances.size();
+
+                for (const auto& meshPtr : batch.asset->meshes) {
+                    const Mesh& mesh = *meshPtr;
+                    if (!mesh.VAO) continue;
+
+                    // LOD per instance, then a counting sort so each LOD's matrices are contiguous
+                    lods.assign(visibleInstances.size(), 0);
+                    lodStarts.assign(mesh.lodCount() + 1, 0);
+                    for (size_t i = 0; i < visibleInstances.size(); i++) {
+                        if (lodScale > 0.0f && mesh.lodCount() > 1) {
+                            const Instance& inst = visibleInstances[i];
+                            glm::vec3 meshCenter = glm::vec3(inst.model * glm::vec4(mesh.getCenter(), 1.0f));
+                            float meshRadius = glm::length(mesh.getExtents()) * inst.maxScale;
+                            float distance = glm::max(glm::length(meshCenter - eye) - meshRadius, 0.0f);
+                            lods[i] = mesh.selectLod(distance, lodScale * inst.maxScale);
+                        }
+                        lodStarts[lods[i] + 1]++;
+                    }
+                    const size_t base = instanceMatrices.size();
+                    for (size_t l = 0; l < mesh.lodCount(); l++) {
+                        const size_t count = lodStarts[l + 1];
+                        lodStarts[l + 1] = lodStarts[l] + count;
+                        if (count == 0) continue;
+                        instancedDraws.push_back({ b, &mesh, l, base + lodStarts[l], count });
+                        triangles += count * (mesh.getLod(l).indexCount / 3);
+                    }
+                    instanceMatrices.resize(base + visibleInstances.size());
+                    for (size_t i = 0; i < visibleInstances.size(); i++) {
+                        instanceMatrices[base + lodStarts[lods[i]]++] = visibleInstances[i].model;
+                    }
+                }
+            }
+            if (instancedDraws.empty()) return triangles;
+
+            stream.upload(instanceMatrices);
+            size_t currentBatch = SIZE_MAX;
+            for (const auto& draw : instancedDraws) {
+                const InstanceBatch& batch = instanceBatches[draw.batch];
+                if (draw.batch != currentBatch) {
+                    batch.shader->useProgram();
+                    bindMaterialTextures(*batch.shader, batch.objects.front()->textures);
+                    currentBatch = draw.batch;
+                }
+
+                const Mesh& mesh = *draw.mesh;
+                const Mesh::Lod range = mesh.getLod(draw.lod);
+                const size_t indexSize = mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+
+                useVertexArray(mesh.VAO);
+                stream.attach(mesh.VAO, draw.first);
+                glDrawElementsInstancedBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(range.indexCount), mesh.indexType,
+                    reinterpret_cast<void*>(mesh.indexByteOffset() + size_t(range.firstIndex) * indexSize),
+                    static_cast<GLsizei>(draw.count), mesh.baseVertex());
+                instanceStats.drawCalls++;
+            }
+            return triangles;
+        }
+
+        // State changed since the last frame (UI, user code) is unknown to the state cache
+        void beginFrame() {
+            getGLState().invalidate();
+            getGLState().resetStats();
+            bindStats = BindStats();
+            getInstanceStream().beginFrame();
+            frame++;
         }
     };
 
@@ -0,0 +1,420 @@
+#pragma once
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <glm.hpp>
+
+#include <cfloat>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <iostream>
+
+#ifndef GL_MESH_CACHE_DIR
+#define GL_MESH_CACHE_DIR "cache/mesh"
+#endif
+
+namespace gl {
+
+    // ============ MAPPED FILE ============
+    // Read-only memory mapping of a whole file. The view stays valid until close().
+    class MappedFile {
+    private:
+        const unsigned char* m_Data = nullptr;
+        size_t m_Size = 0;
+#ifdef _WIN32
+        HANDLE m_File = INVALID_HANDLE_VALUE;
+        HANDLE m_Mapping = nullptr;
+#else
+        int m_File = -1;
+#endif
+
+    public:
+        MappedFile() = default;
+
+        explicit MappedFile(const std::string& path) { open(path); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        ~MappedFile() { close(); }
+
+        bool open(const std::string& path) {
+            close();
+#ifdef _WIN32
+            m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (m_File == INVALID_HANDLE_VALUE) return false;
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(m_File, &size) || size.QuadPart == 0) {
+                close();
+                return false;
+            }
+            m_Size = static_cast<size_t>(size.QuadPart);
+
+            m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!m_Mapping) {
+                close();
+                return false;
+            }
+
+            m_Data = static_cast<const unsigned char*>(MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+            m_File = ::open(path.c_str(), O_RDONLY);
+            if (m_File < 0) return false;
+
+            struct stat st;
+            if (fstat(m_File, &st) != 0 || st.st_size == 0) {
+                close();
+                return false;
+            }
+            m_Size = static_cast<size_t>(st.st_size);
+
+            void* view = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, m_File, 0);
+            m_Data = (view == MAP_FAILED) ? nullptr : static_cast<const unsigned char*>(view);
+#endif
+            if (!m_Data) {
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        void close() {
+#ifdef _WIN32
+            if (m_Data) UnmapViewOfFile(m_Data);
+            if (m_Mapping) CloseHandle(m_Mapping);
+            if (m_File != INVALID_HANDLE_VALUE) CloseHandle(m_File);
+            m_Mapping = nullptr;
+            m_File = INVALID_HANDLE_VALUE;
+#else
+            if (m_Data) munmap(const_cast<unsigned char*>(m_Data), m_Size);
+            if (m_File >= 0) ::close(m_File);
+            m_File = -1;
+#endif
+            m_Data = nullptr;
+            m_Size = 0;
+        }
+
+        bool isOpen() const { return m_Data != nullptr; }
+
+        const unsigned char* data() const { return m_Data; }
+
+        size_t size() const { return m_Size; }
+    };
+
+    // ============ COOKED MESH FORMAT ============
+    // Layout: Header | Submesh table | LOD table | vertex blob | index blob.
+    // Blobs are 16-byte aligned so they can be handed to glBufferData as-is.
+    // Indices are stored relative to their submesh's first vertex; a submesh's index range
+    // holds every LOD back to back, described by its slice of the LOD table.
+    namespace cooked {
+
+        constexpr uint32_t MAGIC = 0x434D4C47; // "GLMC"
+        constexpr uint32_t VERSION = 3; // bump when the layout or the import pipeline output changes
+
+        struct Header {
+            uint32_t magic;
+            uint32_t version;
+            uint64_t sourceHash;
+            uint32_t importFlags;
+            uint32_t vertexStride;
+            uint32_t vertexCount;
+            uint32_t indexCount;
+            uint32_t submeshCount;
+            uint32_t lodCount;
+            float minBounds[3];
+            float maxBounds[3];
+            uint64_t submeshOffset;
+            uint64_t lodOffset;
+            uint64_t vertexOffset;
+            uint64_t indexOffset;
+        };
+
+        struct Submesh {
+            uint32_t firstVertex;
+            uint32_t vertexCount;
+            uint32_t firstIndex;
+            uint32_t indexCount; // all LODs
+            uint32_t firstLod;
+            uint32_t lodCount;
+            float minBounds[3];
+            float maxBounds[3];
+        };
+
+        struct Lod {
+            uint32_t firstIndex; // relative to the submesh's first index
+            uint32_t indexCount;
+            float error;         // object-space simplification error
+            uint32_t reserved;
+        };
+
+        inline uint64_t align16(uint64_t value) { return (value + 15) & ~uint64_t(15); }
+    }
+
+    // Input for MeshCache::store, one per submesh. lodIndices follow indices in the cooked
+    // index range; an empty lods list stores a single LOD covering indices.
+    struct CookedSource {
+        const void* vertices = nullptr;
+        uint32_t vertexCount = 0;
+        const unsigned int* indices = nullptr;
+        uint32_t indexCount = 0;
+        const unsigned int* lodIndices = nullptr;
+        uint32_t lodIndexCount = 0;
+        std::vector<cooked::Lod> lods;
+        glm::vec3 minBounds = glm::vec3(0.0f);
+        glm::vec3 maxBounds = glm::vec3(0.0f);
+    };
+
+    // Views into a mapped cooked file, valid as long as the owning CookedModel lives
+    struct CookedSubmesh {
+        const void* vertices = nullptr;
+        uint32_t vertexCount = 0;
+        const unsigned int* indices = nullptr;
+        uint32_t indexCount = 0; // all LODs
+        const cooked::Lod* lods = nullptr;
+        uint32_t lodCount = 0;
+        glm::vec3 minBounds = glm::vec3(0.0f);
+        glm::vec3 maxBounds = glm::vec3(0.0f);
+    };
+
+    struct CookedModel {
+        MappedFile file;
+        std::vector<CookedSubmesh> submeshes;
+        glm::vec3 minBounds = glm::vec3(0.0f);
+        glm::vec3 maxBounds = glm::vec3(0.0f);
+    };
+
+    // ============ MESH CACHE ============
+    class MeshCache {
+    private:
+        std::filesystem::path m_Directory;
+
+        static uint64_t fnv1a(const unsigned char* data, size_t size, uint64_t hash) {
+            for (size_t i = 0; i < size; i++) {
+                hash ^= data[i];
+                hash *= 0x100000001b3ull;
+            }
+            return hash;
+        }
+
+    public:
+        MeshCache(const std::filesystem::path& directory = GL_MESH_CACHE_DIR)
+            : m_Directory(directory)
+        {
+        }
+
+        // Key = hash(source bytes, import flags, vertex stride, format version, settings salt).
+        // Returns 0 if the source is unreadable.
+        static uint64_t hashSource(const std::string& path, unsigned int importFlags, uint32_t vertexStride, uint64_t settings = 0) {
+            MappedFile source(path);
+            if (!source.isOpen()) return 0;
+
+            uint64_t hash = fnv1a(source.data(), source.size(), 0xcbf29ce484222325ull);
+
+            const uint32_t salt[3] = { importFlags, vertexStride, cooked::VERSION };
+            hash = fnv1a(reinterpret_cast<const unsigned char*>(salt), sizeof(salt), hash);
+            hash = fnv1a(reinterpret_cast<const unsigned char*>(&settings), sizeof(settings), hash);
+            return hash ? hash : 1;
+        }
+
+        std::filesystem::path entryPath(uint64_t key) const {
+            char name[32];
+            std::snprintf(name, sizeof(name), "%016llx.mesh", static_cast<unsigned long long>(key));
+            return m_Directory / name;
+        }
+
+        bool contains(uint64_t key) const {
+            std::error_code ec;
+            return std::filesystem::exists(entryPath(key), ec);
+        }
+
+        void invalidate(uint64_t key) const {
+            std::error_code ec;
+            std::filesystem::remove(entryPath(key), ec);
+        }
+
+        // Map a cooked entry. Fails (and the caller falls back to a full import) on any mismatch.
+        bool load(uint64_t key, uint32_t vertexStride, CookedModel& out) const {
+            if (!out.file.open(entryPath(key).string())) return false;
+
+            const unsigned char* base = out.file.data();
+            const size_t size = out.file.size();
+
+            if (size < sizeof(cooked::Header)) return false;
+
+            cooked::Header header;
+            std::memcpy(&header, base, sizeof(header));
+
+            if (header.magic != cooked::MAGIC || header.version != cooked::VERSION ||
+                header.sourceHash != key || header.vertexStride != vertexStride)
+                return false;
+
+            const uint64_t submeshEnd = header.submeshOffset + uint64_t(header.submeshCount) * sizeof(cooked::Submesh);
+            const uint64_t lodEnd = header.lodOffset + uint64_t(header.lodCount) * sizeof(cooked::Lod);
+            const uint64_t vertexEnd = header.vertexOffset + uint64_t(header.vertexCount) * vertexStride;
+            const uint64_t indexEnd = header.indexOffset + uint64_t(header.indexCount) * sizeof(unsigned int);
+            if (submeshEnd > size || lodEnd > size || vertexEnd > size || indexEnd > size) return false;
+
+            const unsigned char* vertexBlob = base + header.vertexOffset;
+            const unsigned int* indexBlob = reinterpret_cast<const unsigned int*>(base + header.indexOffset);
+            const cooked::Lod* lodTable = reinterpret_cast<const cooked::Lod*>(base + header.lodOffset);
+
+            out.submeshes.clear();
+            out.submeshes.reserve(header.submeshCount);
+            for (uint32_t i = 0; i < header.submeshCount; i++) {
+                cooked::Submesh entry;
+                std::memcpy(&entry, base + header.submeshOffset + i * sizeof(cooked::Submesh), sizeof(entry));
+
+                if (uint64_t(entry.firstVertex) + entry.vertexCount > header.vertexCount ||
+                    uint64_t(entry.firstIndex) + entry.indexCount > header.indexCount ||
+                    entry.lodCount == 0 || uint64_t(entry.firstLod) + entry.lodCount > header.lodCount)
+                    return false;
+
+                for (uint32_t l = 0; l < entry.lodCount; l++) {
+                    const cooked::Lod& lod = lodTable[entry.firstLod + l];
+                    if (uint64_t(lod.firstIndex) + lod.indexCount > entry.indexCount) return false;
+                }
+
+                CookedSubmesh view;
+                view.vertices = vertexBlob + uint64_t(entry.firstVertex) * vertexStride;
+                view.vertexCount = entry.vertexCount;
+                view.indices = indexBlob + entry.firstIndex;
+                view.indexCount = entry.indexCount;
+                view.lods = lodTable + entry.firstLod;
+                view.lodCount = entry.lodCount;
+                view.minBounds = glm::vec3(entry.minBounds[0], entry.minBounds[1], entry.minBounds[2]);
+                view.maxBounds = glm::vec3(entry.maxBounds[0], entry.maxBounds[1], entry.maxBounds[2]);
+                out.submeshes.push_back(view);
+            }
+
+            out.minBounds = glm::vec3(header.minBounds[0], header.minBounds[1], header.minBounds[2]);
+            out.maxBounds = glm::vec3(header.maxBounds[0], header.maxBounds[1], header.maxBounds[2]);
+            return true;
+        }
+
+        // Write a cooked entry. Written to a temp file first so a crash never leaves a torn entry behind.
+        bool store(uint64_t key, unsigned int importFlags, uint32_t vertexStride, const std::vector<CookedSource>& submeshes) const {
+            std::error_code ec;
+            std::filesystem::create_directories(m_Directory, ec);
+
+            cooked::Header header{};
+            header.magic = cooked::MAGIC;
+            header.version = cooked::VERSION;
+            header.sourceHash = key;
+            header.importFlags = importFlags;
+            header.vertexStride = vertexStride;
+            header.submeshCount = static_cast<uint32_t>(submeshes.size());
+
+            glm::vec3 minBounds(FLT_MAX), maxBounds(-FLT_MAX);
+            std::vector<cooked::Submesh> table;
+            std::vector<cooked::Lod> lodTable;
+            table.reserve(submeshes.size());
+            for (const auto& src : submeshes) {
+                cooked::Submesh entry{};
+                entry.firstVertex = header.vertexCount;
+                entry.vertexCount = src.vertexCount;
+                entry.firstIndex = header.indexCount;
+                entry.indexCount = src.indexCount + src.lodIndexCount;
+                entry.firstLod = static_cast<uint32_t>(lodTable.size());
+
+                if (src.lods.empty()) lodTable.push_back({ 0, src.indexCount, 0.0f, 0 });
+                else lodTable.insert(lodTable.end(), src.lods.begin(), src.lods.end());
+                entry.lodCount = static_cast<uint32_t>(lodTable.size()) - entry.firstLod;
+
+                for (int k = 0; k < 3; k++) {
+                    entry.minBounds[k] = src.minBounds[k];
+                    entry.maxBounds[k] = src.maxBounds[k];
+                }
+                table.push_back(entry);
+
+                header.vertexCount += src.vertexCount;
+                header.indexCount += entry.indexCount;
+                minBounds = glm::min(minBounds, src.minBounds);
+                maxBounds = glm::max(maxBounds, src.maxBounds);
+            }
+            for (int k = 0; k < 3; k++) {
+                header.minBounds[k] = minBounds[k];
+                header.maxBounds[k] = maxBounds[k];
+            }
+
+            header.submeshOffset = cooked::align16(sizeof(cooked::Header));
+            header.lodCount = static_cast<uint32_t>(lodTable.size());
+            header.lodOffset = cooked::align16(header.submeshOffset + table.size() * sizeof(cooked::Submesh));
+            header.vertexOffset = cooked::align16(header.lodOffset + lodTable.size() * sizeof(cooked::Lod));
+            header.indexOffset = cooked::align16(header.vertexOffset + uint64_t(header.vertexCount) * vertexStride);
+
+            const auto finalPath = entryPath(key);
+            auto tempPath = finalPath;
+            tempPath += "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+
+            {
+                std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+                if (!file.is_open()) return false;
+
+                const char zeros[16] = {};
+                auto padTo = [&](uint64_t offset) {
+                    uint64_t pos = static_cast<uint64_t>(file.tellp());
+                    if (offset > pos) file.write(zeros, static_cast<std::streamsize>(offset - pos));
+                };
+
+                file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                padTo(header.submeshOffset);
+                file.write(reinterpret_cast<const char*>(table.data()), static_cast<std::streamsize>(table.size() * sizeof(cooked::Submesh)));
+
+                padTo(header.lodOffset);
+                file.write(reinterpret_cast<const char*>(lodTable.data()), static_cast<std::streamsize>(lodTable.size() * sizeof(cooked::Lod)));
+
+                padTo(header.vertexOffset);
+                for (const auto& src : submeshes)
+                    file.write(static_cast<const char*>(src.vertices), static_cast<std::streamsize>(uint64_t(src.vertexCount) * vertexStride));
+
+                padTo(header.indexOffset);
+                for (const auto& src : submeshes) {
+                    file.write(reinterpret_cast<const char*>(src.indices), static_cast<std::streamsize>(uint64_t(src.indexCount) * sizeof(unsigned int)));
+                    if (src.lodIndexCount)
+                        file.write(reinterpret_cast<const char*>(src.lodIndices), static_cast<std::streamsize>(uint64_t(src.lodIndexCount) * sizeof(unsigned int)));
+                }
+
+                if (!file.good()) {
+                    file.close();
+                    std::filesystem::remove(tempPath, ec);
+                    return false;
+                }
+            }
+
+            std::filesystem::rename(tempPath, finalPath, ec);
+            if (ec) {
+                std::cerr << "Failed to write mesh cache entry: " << finalPath.string() << std::endl;
+                std::filesystem::remove(tempPath, ec);
+                return false;
+            }
+            return true;
+        }
+    };
+
+    MeshCache& getMeshCache() {
+        static MeshCache cache;
+        return cache;
+    }
+
+} // namespace gl
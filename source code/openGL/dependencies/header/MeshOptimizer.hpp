@@ -0,0 +1,273 @@
+#pragma once
+
+#include <glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+// Import-time index/vertex optimisation. Everything works on raw arrays (vertex blob + stride,
+// 32-bit indices) so it does not depend on a particular vertex layout.
+namespace gl::meshopt {
+
+    // ============ ANALYSIS ============
+    struct CacheStats {
+        float acmr = 0.0f;       // transformed vertices per triangle (3.0 = no reuse, ~0.5 = ideal)
+        float atvr = 0.0f;       // transformed vertices per unique vertex (1.0 = ideal)
+        unsigned int misses = 0;
+    };
+
+    // FIFO post-transform cache simulation
+    CacheStats analyzeVertexCache(const unsigned int* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = 16) {
+        CacheStats stats;
+        if (indexCount < 3 || vertexCount == 0) return stats;
+
+        std::vector<unsigned int> timestamps(vertexCount, 0);
+        unsigned int time = cacheSize + 1;
+
+        for (size_t i = 0; i < indexCount; i++) {
+            unsigned int v = indices[i];
+            if (time - timestamps[v] > cacheSize) {
+                timestamps[v] = time++;
+                stats.misses++;
+            }
+        }
+
+        stats.acmr = float(stats.misses) / float(indexCount / 3);
+        stats.atvr = float(stats.misses) / float(vertexCount);
+        return stats;
+    }
+
+    // ============ WELDING ============
+    // Build a remap table that merges bitwise-identical vertices. Returns the unique vertex count.
+    size_t generateWeldRemap(std::vector<unsigned int>& remap, const void* vertices, size_t vertexCount, size_t stride) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(vertices);
+
+        struct Hasher {
+            const unsigned char* bytes;
+            size_t stride;
+            size_t operator()(unsigned int v) const {
+                const unsigned char* p = bytes + size_t(v) * stride;
+                uint64_t h = 0xcbf29ce484222325ull;
+                for (size_t i = 0; i < stride; i++) {
+                    h ^= p[i];
+                    h *= 0x100000001b3ull;
+                }
+                return static_cast<size_t>(h);
+            }
+        };
+        struct Equal {
+            const unsigned char* bytes;
+            size_t stride;
+            bool operator()(unsigned int a, unsigned int b) const {
+                return std::memcmp(bytes + size_t(a) * stride, bytes + size_t(b) * stride, stride) == 0;
+            }
+        };
+
+        std::unordered_map<unsigned int, unsigned int, Hasher, Equal> unique(
+            vertexCount, Hasher{ bytes, stride }, Equal{ bytes, stride });
+
+        remap.resize(vertexCount);
+        unsigned int next = 0;
+        for (size_t v = 0; v < vertexCount; v++) {
+            auto [it, inserted] = unique.emplace(static_cast<unsigned int>(v), next);
+            remap[v] = it->second;
+            if (inserted) next++;
+        }
+        return next;
+    }
+
+    // dst[remap[i]] = src[i]; dst must hold the remapped vertex count
+    void remapVertexBuffer(void* dst, const void* src, size_t vertexCount, size_t stride, const unsigned int* remap) {
+        unsigned char* out = static_cast<unsigned char*>(dst);
+        const unsigned char* in = static_cast<const unsigned char*>(src);
+        for (size_t v = 0; v < vertexCount; v++)
+            std::memcpy(out + size_t(remap[v]) * stride, in + v * stride, stride);
+    }
+
+    void remapIndexBuffer(unsigned int* indices, size_t indexCount, const unsigned int* remap) {
+        for (size_t i = 0; i < indexCount; i++)
+            indices[i] = remap[indices[i]];
+    }
+
+    // ============ VERTEX CACHE (TIPSIFY) ============
+    // Sander, Nehab, Barczak - "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (2007).
+    // clusters receives the triangle index at which each hard cache boundary starts; used by optimizeOverdraw.
+    void optimizeVertexCache(unsigned int* dst, const unsigned int* indices, size_t indexCount, size_t vertexCount,
+        unsigned int cacheSize = 16, std::vector<unsigned int>* clusters = nullptr)
+    {
+        const size_t triangleCount = indexCount / 3;
+        if (clusters) clusters->clear();
+        if (triangleCount == 0 || vertexCount == 0) return;
+
+        // Vertex -> triangle adjacency
+        std::vector<unsigned int> liveCount(vertexCount, 0);
+        for (size_t i = 0; i < triangleCount * 3; i++) liveCount[indices[i]]++;
+
+        std::vector<unsigned int> offsets(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; v++) offsets[v + 1] = offsets[v] + liveCount[v];
+
+        std::vector<unsigned int> adjacency(triangleCount * 3);
+        std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++)
+            for (int k = 0; k < 3; k++)
+                adjacency[fill[indices[t * 3 + k]]++] = static_cast<unsigned int>(t);
+
+        std::vector<unsigned int> timestamps(vertexCount, 0);
+        std::vector<char> emitted(triangleCount, 0);
+        std::vector<unsigned int> deadEnd;
+        deadEnd.reserve(indexCount);
+        std::vector<unsigned int> candidates;
+
+        unsigned int time = cacheSize + 1;
+        size_t cursor = 1;
+        size_t written = 0;
+        long long fanning = 0;
+
+        if (clusters) clusters->push_back(0);
+
+        while (fanning >= 0) {
+            candidates.clear();
+            const unsigned int f = static_cast<unsigned int>(fanning);
+
+            for (unsigned int a = offsets[f]; a < offsets[f + 1]; a++) {
+                unsigned int t = adjacency[a];
+                if (emitted[t]) continue;
+
+                for (int k = 0; k < 3; k++) {
+                    unsigned int v = indices[t * 3 + k];
+                    dst[written++] = v;
+                    deadEnd.push_back(v);
+                    candidates.push_back(v);
+                    liveCount[v]--;
+                    if (time - timestamps[v] > cacheSize) timestamps[v] = time++;
+                }
+                emitted[t] = 1;
+            }
+
+            // Pick the candidate that is still in cache and has the most remaining triangles
+            long long best = -1;
+            int bestPriority = -1;
+            for (unsigned int v : candidates) {
+                if (liveCount[v] == 0) continue;
+                int priority = 0;
+                if (time - timestamps[v] + 2 * liveCount[v] <= cacheSize) priority = int(time - timestamps[v]);
+                if (priority > bestPriority) {
+                    bestPriority = priority;
+                    best = v;
+                }
+            }
+
+            if (best < 0) {
+                // Dead end: walk back the emitted vertices, then scan forward
+                while (!deadEnd.empty()) {
+                    unsigned int d = deadEnd.back();
+                    deadEnd.pop_back();
+                    if (liveCount[d] > 0) {
+                        best = d;
+                        break;
+                    }
+                }
+                while (best < 0 && cursor < vertexCount) {
+                    if (liveCount[cursor] > 0) best = static_cast<long long>(cursor);
+                    else cursor++;
+                }
+                unsigned int boundary = static_cast<unsigned int>(written / 3);
+                if (best >= 0 && clusters && boundary < triangleCount && clusters->back() != boundary)
+                    clusters->push_back(boundary);
+            }
+
+            fanning = best;
+        }
+    }
+
+    // ============ OVERDRAW ============
+    // Sort the Tipsify clusters so outward-facing ones are drawn first and occlude the rest
+    void optimizeOverdraw(unsigned int* dst, const unsigned int* indices, size_t indexCount,
+        const float* positions, size_t positionStride, const std::vector<unsigned int>& clusters)
+    {
+        const size_t triangleCount = indexCount / 3;
+        if (triangleCount == 0 || clusters.size() <= 1) {
+            if (dst != indices) std::memcpy(dst, indices, indexCount * sizeof(unsigned int));
+            return;
+        }
+
+        auto position = [&](unsigned int v) {
+            const float* p = reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(positions) + size_t(v) * positionStride);
+            return glm::vec3(p[0], p[1], p[2]);
+        };
+
+        // Area-weighted mesh centroid
+        glm::vec3 meshCentroid(0.0f);
+        float meshArea = 0.0f;
+        for (size_t t = 0; t < triangleCount; t++) {
+            glm::vec3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), c = position(indices[t * 3 + 2]);
+            float area = glm::length(glm::cross(b - a, c - a));
+            meshCentroid += (a + b + c) * (area / 3.0f);
+            meshArea += area;
+        }
+        if (meshArea > 0.0f) meshCentroid /= meshArea;
+
+        struct Cluster {
+            unsigned int begin, end;
+            float sortKey;
+        };
+        std::vector<Cluster> sorted;
+        sorted.reserve(clusters.size());
+
+        for (size_t c = 0; c < clusters.size(); c++) {
+            unsigned int begin = clusters[c];
+            unsigned int end = (c + 1 < clusters.size()) ? clusters[c + 1] : static_cast<unsigned int>(triangleCount);
+
+            glm::vec3 centroid(0.0f), normal(0.0f);
+            float area = 0.0f;
+            for (unsigned int t = begin; t < end; t++) {
+                glm::vec3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), c3 = position(indices[t * 3 + 2]);
+                glm::vec3 n = glm::cross(b - a, c3 - a);
+                float triArea = glm::length(n);
+                centroid += (a + b + c3) * (triArea / 3.0f);
+                normal += n;
+                area += triArea;
+            }
+            if (area > 0.0f) centroid /= area;
+
+            float len = glm::length(normal);
+            float key = len > 0.0f ? glm::dot(centroid - meshCentroid, normal / len) : 0.0f;
+            sorted.push_back({ begin, end, key });
+        }
+
+        std::stable_sort(sorted.begin(), sorted.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+        std::vector<unsigned int> result;
+        result.reserve(indexCount);
+        for (const auto& cluster : sorted)
+            result.insert(result.end(), indices + size_t(cluster.begin) * 3, indices + size_t(cluster.end) * 3);
+
+        std::memcpy(dst, result.data(), result.size() * sizeof(unsigned int));
+    }
+
+    // ============ VERTEX FETCH ============
+    // Remap vertices into first-use order of the index buffer. Unreferenced vertices are dropped.
+    // Returns the referenced vertex count; remap is ~0u for dropped vertices.
+    size_t generateFetchRemap(std::vector<unsigned int>& remap, const unsigned int* indices, size_t indexCount, size_t vertexCount) {
+        remap.assign(vertexCount, ~0u);
+        unsigned int next = 0;
+        for (size_t i = 0; i < indexCount; i++) {
+            unsigned int v = indices[i];
+            if (remap[v] == ~0u) remap[v] = next++;
+        }
+        return next;
+    }
+
+    // dst[remap[i]] = src[i], skipping dropped vertices
+    void remapVertexBufferSparse(void* dst, const void* src, size_t vertexCount, size_t stride, const unsigned int* remap) {
+        unsigned char* out = static_cast<unsigned char*>(dst);
+        const unsigned char* in = static_cast<const unsigned char*>(src);
+        for (size_t v = 0; v < vertexCount; v++)
+            if (remap[v] != ~0u) std::memcpy(out + size_t(remap[v]) * stride, in + v * stride, stride);
+    }
+
+} // namespace gl::meshopt
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <glm.hpp>
+
+#include <Culling.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#ifndef GL_MESHLET_MAX_VERTICES
+#define GL_MESHLET_MAX_VERTICES 64
+#endif
+
+#ifndef GL_MESHLET_MAX_TRIANGLES
+#define GL_MESHLET_MAX_TRIANGLES 124
+#endif
+
+namespace gl {
+
+    // ============ MESHLET ============
+    // A contiguous run of a mesh's index buffer with its own culling bounds.
+    // Meshlets split the existing (cache-optimised) triangle order, so the index buffer is untouched.
+    struct Meshlet {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        uint32_t vertexCount; // unique vertices referenced
+        glm::vec3 center;     // bounding sphere, object space
+        float radius;
+        glm::vec3 coneAxis;   // average facing direction
+        float coneCutoff;     // sin of the cone's half angle; 1 = no usable cone
+    };
+
+    // Visible index range after culling, adjacent meshlets merged
+    struct MeshletRange {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+    };
+
+    struct MeshletCullStats {
+        size_t meshlets = 0;
+        size_t meshletsCulled = 0;
+        size_t triangles = 0;
+        size_t frustumCulled = 0; // triangles
+        size_t coneCulled = 0;    // triangles
+
+        MeshletCullStats& operator+=(const MeshletCullStats& o) {
+            meshlets += o.meshlets;
+            meshletsCulled += o.meshletsCulled;
+            triangles += o.triangles;
+            frustumCulled += o.frustumCulled;
+            coneCulled += o.coneCulled;
+            return *this;
+        }
+    };
+
+    namespace meshopt {
+
+        // Greedily split the index buffer into meshlets of at most maxVertices unique vertices and maxTriangles triangles
+        void buildMeshlets(std::vector<Meshlet>& meshlets, const unsigned int* indices, size_t indexCount,
+            const float* positions, size_t positionStride, size_t vertexCount,
+            size_t maxVertices = GL_MESHLET_MAX_VERTICES, size_t maxTriangles = GL_MESHLET_MAX_TRIANGLES)
+        {
+            auto position = [&](unsigned int v) {
+                const float* p = reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(positions) + size_t(v) * positionStride);
+                return glm::vec3(p[0], p[1], p[2]);
+            };
+
+            meshlets.clear();
+            const size_t triangleCount = indexCount / 3;
+            if (triangleCount == 0) return;
+
+            std::vector<uint32_t> stamp(vertexCount, ~0u);
+            std::vector<unsigned int> used;
+            used.reserve(maxVertices);
+
+            auto finish = [&](uint32_t firstTriangle, uint32_t endTriangle) {
+                Meshlet m{};
+                m.firstIndex = firstTriangle * 3;
+                m.indexCount = (endTriangle - firstTriangle) * 3;
+                m.vertexCount = static_cast<uint32_t>(used.size());
+
+                glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+                for (unsigned int v : used) {
+                    lo = glm::min(lo, position(v));
+                    hi = glm::max(hi, position(v));
+                }
+                m.center = (lo + hi) * 0.5f;
+                m.radius = 0.0f;
+                for (unsigned int v : used) m.radius = glm::max(m.radius, glm::length(position(v) - m.center));
+
+                // Normal cone from the unit triangle normals
+                std::vector<glm::vec3> normals;
+                normals.reserve(endTriangle - firstTriangle);
+                glm::vec3 axis(0.0f);
+                for (uint32_t t = firstTriangle; t < endTriangle; t++) {
+                    glm::vec3 a = position(indices[t * 3]), b = position(indices[t * 3 + 1]), c = position(indices[t * 3 + 2]);
+                    glm::vec3 n = glm::cross(b - a, c - a);
+                    float length = glm::length(n);
+                    if (length <= 0.0f) continue;
+                    normals.push_back(n / length);
+                    axis += normals.back();
+                }
+
+                m.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+                m.coneCutoff = 1.0f;
+                float axisLength = glm::length(axis);
+                if (axisLength > 0.0f && !normals.empty()) {
+                    axis /= axisLength;
+                    float minDot = 1.0f;
+                    for (const auto& n : normals) minDot = glm::min(minDot, glm::dot(axis, n));
+
+                    // Cones close to a hemisphere are almost never entirely back-facing
+                    if (minDot > 0.1f) {
+                        m.coneAxis = axis;
+                        m.coneCutoff = std::sqrt(glm::max(1.0f - minDot * minDot, 0.0f));
+                    }
+                }
+
+                meshlets.push_back(m);
+                used.clear();
+            };
+
+            uint32_t first = 0;
+            uint32_t id = 0;
+            for (uint32_t t = 0; t < triangleCount; t++) {
+                size_t fresh = 0;
+                for (int k = 0; k < 3; k++) {
+                    unsigned int v = indices[t * 3 + k];
+                    if (stamp[v] != id) fresh++;
+                }
+
+                if (t > first && (used.size() + fresh > maxVertices || t - first >= maxTriangles)) {
+                    finish(first, t);
+                    first = t;
+                    id++;
+                }
+
+                for (int k = 0; k < 3; k++) {
+                    unsigned int v = indices[t * 3 + k];
+                    if (stamp[v] != id) {
+                        stamp[v] = id;
+                        used.push_back(v);
+                    }
+                }
+            }
+            finish(first, static_cast<uint32_t>(triangleCount));
+        }
+
+        // Cull meshlets against a world-space frustum and, when eye is given in object space, by their
+        // normal cones. Cone culling is skipped for non-uniform scale, where object-space normals lie.
+        // Visible ranges are appended to out, merging neighbours so they can go to one glMultiDrawElements.
+        void cullMeshlets(std::vector<MeshletRange>& out, const Meshlet* meshlets, size_t count,
+            const glm::mat4& model, const Frustum* frustum, const glm::vec3* eyeObjectSpace,
+            MeshletCullStats* stats = nullptr)
+        {
+            const glm::vec3 scale(glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])));
+            const float maxScale = glm::max(scale.x, glm::max(scale.y, scale.z));
+            const float minScale = glm::min(scale.x, glm::min(scale.y, scale.z));
+            const bool coneCulling = eyeObjectSpace && maxScale - minScale <= maxScale * 1e-3f;
+
+            MeshletCullStats local;
+            local.meshlets = count;
+
+            for (size_t i = 0; i < count; i++) {
+                const Meshlet& m = meshlets[i];
+                const size_t triangles = m.indexCount / 3;
+                local.triangles += triangles;
+
+                if (frustum) {
+                    glm::vec3 center = glm::vec3(model * glm::vec4(m.center, 1.0f));
+                    if (!frustum->intersectsSphere(center, m.radius * maxScale)) {
+                        local.meshletsCulled++;
+                        local.frustumCulled += triangles;
+                        continue;
+                    }
+                }
+
+                if (coneCulling && m.coneCutoff < 1.0f) {
+                    glm::vec3 view = m.center - *eyeObjectSpace;
+                    if (glm::dot(view, m.coneAxis) >= m.coneCutoff * glm::length(view) + m.radius) {
+                        local.meshletsCulled++;
+                        local.coneCulled += triangles;
+                        continue;
+                    }
+                }
+
+                if (!out.empty() && out.back().firstIndex + out.back().indexCount == m.firstIndex)
+                    out.back().indexCount += m.indexCount;
+                else
+                    out.push_back({ m.firstIndex, m.indexCount });
+            }
+
+            if (stats) *stats += local;
+        }
+
+    }
+
+} // namespace gl
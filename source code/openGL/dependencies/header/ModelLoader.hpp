@@ -0,0 +1,122 @@
+#pragma once
+
+#include <Mesh.hpp>
+#include <ThreadPool.hpp>
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace gl {
+
+    // ============ MODEL LOADER ============
+    // Asynchronous model loading. File I/O, Assimp parsing and mesh conversion run on the
+    // thread pool, both across files and across the aiMeshes of one file; embedded textures are decoded
+    // alongside. Only the GL uploads are queued back to the context thread, which drains them with
+    // processUploads(): one job per texture, then one for the meshes.
+    class ModelLoader {
+    private:
+        // Shared with in-flight tasks so the loader can go away before they finish
+        struct UploadQueue {
+            std::mutex mutex;
+            std::deque<std::function<void()>> jobs;
+            std::atomic<size_t> pending{ 0 };
+        };
+
+        ThreadPool& m_Pool;
+        std::shared_ptr<UploadQueue> m_Queue = std::make_shared<UploadQueue>();
+
+    public:
+        explicit ModelLoader(ThreadPool& pool = getThreadPool())
+            : m_Pool(pool)
+        {
+        }
+
+        // Start loading path into object. The future becomes ready once the meshes are uploaded
+        // and appended to object->meshes, i.e. during a later processUploads() call.
+        // Assets already resident skip the pool and are attached by the next processUploads().
+        std::future<bool> loadAsync(const std::shared_ptr<Object>& object, const std::string& path, bool useCache = true) {
+            auto promise = std::make_shared<std::promise<bool>>();
+            std::future<bool> future = promise->get_future();
+
+            auto queue = m_Queue;
+            queue->pending++;
+
+            if (useCache) {
+                if (auto asset = getAssetRegistry().find(path, object->vertexFormat)) {
+                    std::lock_guard<std::mutex> lock(queue->mutex);
+                    queue->jobs.push_back([object, asset, promise]() {
+                        object->addAsset(asset);
+                        promise->set_value(true);
+                    });
+                    return future;
+                }
+            }
+
+            m_Pool.submit([queue, object, path, useCache, promise]() {
+                auto model = std::make_shared<ImportedModel>();
+                bool imported = false;
+                try {
+                    imported = Object::importModel(path, *model, useCache);
+                }
+                catch (...) {
+                    promise->set_exception(std::current_exception());
+                    queue->pending--;
+                    return;
+                }
+
+                if (!imported) {
+                    promise->set_value(false);
+                    queue->pending--;
+                    return;
+                }
+
+                std::lock_guard<std::mutex> lock(queue->mutex);
+                queue->pending += model->images.size();
+                for (size_t i = 0; i < model->images.size(); i++)
+                    queue->jobs.push_back([model, i]() { model->uploadImage(i); });
+                queue->jobs.push_back([object, model, promise]() {
+                    object->addModel(*model);
+                    promise->set_value(true);
+                });
+            });
+
+            return future;
+        }
+
+        // Run queued GL uploads. Call once per frame on the context thread.
+        size_t processUploads(size_t maxUploads = SIZE_MAX) {
+            size_t processed = 0;
+            while (processed < maxUploads) {
+                std::function<void()> job;
+                {
+                    std::lock_guard<std::mutex> lock(m_Queue->mutex);
+                    if (m_Queue->jobs.empty()) break;
+                    job = std::move(m_Queue->jobs.front());
+                    m_Queue->jobs.pop_front();
+                }
+                job();
+                m_Queue->pending--;
+                processed++;
+            }
+            return processed;
+        }
+
+        // Block the context thread until every started load is uploaded (e.g. at startup)
+        void finish() {
+            while (m_Queue->pending.load() > 0) {
+                if (processUploads() == 0) std::this_thread::yield();
+            }
+        }
+
+        size_t pending() const { return m_Queue->pending.load(); }
+
+        bool busy() const { return pending() > 0; }
+    };
+
+} // namespace gl
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <Utils.hpp>
+#include <GeometryBuffer.hpp>
+#include <Instancing.hpp>
+#include <StreamBuffer.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace gl {
+
+    // Layout fixed by GL for glMultiDrawElementsIndirect
+    struct DrawElementsIndirectCommand {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex; // in indices, not bytes
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    // Bind an object's material textures to consecutive units and point the samplers at them.
+    // Goes through the state cache: units already holding the texture and samplers already set are skipped.
+    inline void bindMaterialTextures(shader& program, const std::unordered_map<std::string, GLuint>& textures) {
+        GLuint texUnit = 0;
+        for (auto& [name, texId] : textures) {
+            getGLState().bindTexture(texUnit, GL_TEXTURE_2D, texId);
+            getGLState().uniform1i(program.getUniformLoc(name), static_cast<GLint>(texUnit));
+            texUnit++;
+        }
+    }
+
+    // ============ TEXTURE SETS ============
+    // Interns material texture sets (sampler name -> texture) to dense ids: equal sets share an id and
+    // different sets never do, as a hash match is confirmed by comparing the sets. Ids can therefore key
+    // buckets, batches and sort keys. Interned copies are kept at a stable address for the program's
+    // lifetime, so a draw may refer to one after the object it came from has changed. Thread-safe.
+    class TextureSets {
+    public:
+        using Set = std::unordered_map<std::string, GLuint>;
+
+    private:
+        std::mutex m_Mutex;
+        std::unordered_multimap<uint64_t, uint32_t> m_ByHash;
+        std::deque<Set> m_Sets; // by id
+
+    public:
+        // Order-independent; different sets may collide
+        static uint64_t hash(const Set& textures) {
+            uint64_t key = 0;
+            for (const auto& [name, id] : textures) {
+                uint64_t h = std::hash<std::string>()(name) ^ (uint64_t(id) * 0x9e3779b97f4a7c15ull);
+                h ^= h >> 31;
+                h *= 0xbf58476d1ce4e5b9ull;
+                key += h ^ (h >> 29);
+            }
+            return key;
+        }
+
+        uint32_t intern(const Set& textures) {
+            const uint64_t h = hash(textures);
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            auto [first, last] = m_ByHash.equal_range(h);
+            for (auto it = first; it != last; ++it) {
+                if (m_Sets[it->second] == textures) return it->second;
+            }
+            const uint32_t id = static_cast<uint32_t>(m_Sets.size());
+            m_Sets.push_back(textures);
+            m_ByHash.emplace(h, id);
+            return id;
+        }
+
+        // The interned set; id must come from intern()
+        const Set& get(uint32_t id) {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_Sets[id];
+        }
+    };
+
+    TextureSets& getTextureSets() {
+        static TextureSets sets;
+        return sets;
+    }
+
+    struct MultiDrawStats {
+        size_t buckets = 0;   // non-empty this frame
+        size_t draws = 0;     // commands
+        size_t drawCalls = 0; // GL calls issued for them
+        bool indirect = false;
+    };
+
+    // ============ MULTI-DRAW QUEUE ============
+    // Collects a frame's draws into buckets of equal state (program, textures, VAO, index type) and
+    // submits each bucket with one glMultiDrawElementsIndirect. Model matrices go to the InstanceStream,
+    // which the program reads as a per-instance attribute, indexed by each command's baseInstance.
+    // Without ARB_multi_draw_indirect + ARB_base_instance (plain GL 3.3) every command becomes a
+    // glDrawElementsBaseVertex, with the matrix passed as a constant vertex attribute.
+    // Programs without the instanceModel attribute (vert.glsl) are drawn the same way through the "model" uniform.
+    class MultiDrawQueue {
+    private:
+        struct Key {
+            GLuint program;
+            GLuint vao;
+            GLenum indexType;
+            uint32_t textures; // TextureSets id
+
+            bool operator==(const Key& o) const {
+                return program == o.program && vao == o.vao && indexType == o.indexType && textures == o.textures;
+            }
+        };
+
+        struct KeyHash {
+            size_t operator()(const Key& k) const {
+                uint64_t h = (uint64_t(k.textures) << 44) ^ (uint64_t(k.program) << 24) ^ (uint64_t(k.vao) << 20) ^ k.indexType;
+                h ^= h >> 33;
+                h *= 0xff51afd7ed558ccdull;
+                h ^= h >> 33;
+                return static_cast<size_t>(h);
+            }
+        };
+
+        struct Bucket {
+            shader* program = nullptr;
+            const std::unordered_map<std::string, GLuint>* textures = nullptr; // valid while commands is not empty
+            GLuint vao = 0;
+            GLenum indexType = GL_UNSIGNED_INT;
+            std::vector<DrawElementsIndirectCommand> commands;
+        };
+
+        std::vector<Bucket> m_Buckets;
+        std::unordered_map<Key, size_t, KeyHash> m_Lookup;
+        std::vector<glm::mat4> m_Instances;
+        StreamBuffer m_Commands{ GL_DRAW_INDIRECT_BUFFER, 1u << 20 };
+        MultiDrawStats m_Stats;
+
+    public:
+        bool useIndirect = true; // false forces the GL 3.3 path, e.g. to compare
+
+        MultiDrawQueue() = default;
+        MultiDrawQueue(const MultiDrawQueue&) = delete;
+        MultiDrawQueue& operator=(const MultiDrawQueue&) = delete;
+
+        static bool indirectSupported() {
+            return GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance && glMultiDrawElementsIndirect != nullptr;
+        }
+
+        // Start a frame; bucket storage is kept
+        void clear() {
+            m_Commands.beginFrame();
+            for (auto& bucket : m_Buckets) bucket.commands.clear();
+            m_Instances.clear();
+        }
+
+        // Returns the baseInstance to put in this object's commands
+        GLuint addInstance(const glm::mat4& model) {
+            m_Instances.push_back(model);
+            return static_cast<GLuint>(m_Instances.size() - 1);
+        }
+
+        // textureSet = getTextureSets().intern(textures)
+        void add(shader& program, const std::unordered_map<std::string, GLuint>& textures, uint32_t textureSet,
+            GLuint vao, GLenum indexType, const DrawElementsIndirectCommand& command)
+        {
+            const Key key{ program.getProgram(), vao, indexType, textureSet };
+            auto [it, inserted] = m_Lookup.emplace(key, m_Buckets.size());
+            if (inserted) m_Buckets.emplace_back();
+
+            Bucket& bucket = m_Buckets[it->second];
+            if (bucket.commands.empty()) {
+                bucket.program = &program;
+                bucket.textures = &textures;
+                bucket.vao = vao;
+                bucket.indexType = indexType;
+            }
+            bucket.commands.push_back(command);
+        }
+
+        // Draw everything added since clear(). Leaves the last bucket's program and VAO bound.
+        void submit() {
+            m_Stats = MultiDrawStats();
+            m_Stats.indirect = useIndirect && indirectSupported();
+
+            size_t commandOffset = 0;
+            if (m_Stats.indirect) {
+                // Buckets are copied straight into the stream, in submission order
+                size_t total = 0;
+                for (const auto& bucket : m_Buckets) total += bucket.commands.size();
+                StreamBuffer::Allocation commands = m_Commands.allocate(total * sizeof(DrawElementsIndirectCommand), alignof(DrawElementsIndirectCommand));
+                auto* out = static_cast<DrawElementsIndirectCommand*>(commands.data);
+                for (const auto& bucket : m_Buckets) out = std::copy(bucket.commands.begin(), bucket.commands.end(), out);
+                m_Commands.flush();
+                commandOffset = commands.offset;
+                getGLState().bindBuffer(GL_DRAW_INDIRECT_BUFFER, m_Commands.buffer());
+                getInstanceStream().upload(m_Instances);
+            }
+
+            size_t uploadOffset = 0;
+            for (auto& bucket : m_Buckets) {
+                if (bucket.commands.empty()) continue;
+                m_Stats.buckets++;
+                m_Stats.draws += bucket.commands.size();
+
+                bucket.program->useProgram();
+                bindMaterialTextures(*bucket.program, *bucket.textures);
+                useVertexArray(bucket.vao);
+
+                const bool instanced = getInstanceStream().readsInstanceModel(bucket.program->getProgram());
+                const size_t indexSize = bucket.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+
+                if (instanced && m_Stats.indirect) {
+                    getInstanceStream().attach(bucket.vao, 0);
+                    glMultiDrawElementsIndirect(GL_TRIANGLES, bucket.indexType,
+                        reinterpret_cast<const void*>(commandOffset + uploadOffset * sizeof(DrawElementsIndirectCommand)),
+                        static_cast<GLsizei>(bucket.commands.size()), 0);
+                    m_Stats.drawCalls++;
+                }
+                else {
+                    if (instanced) getInstanceStream().detach(bucket.vao);
+
+                    GLuint lastInstance = ~0u;
+                    for (const auto& cmd : bucket.commands) {
+                        if (cmd.baseInstance != lastInstance) {
+                            const glm::mat4& model = m_Instances[cmd.baseInstance];
+                            if (instanced) InstanceStream::setConstant(model);
+                            else bucket.program->setUniformMat4fv("model", model);
+                            lastInstance = cmd.baseInstance;
+                        }
+                        glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(cmd.count), bucket.indexType,
+                            reinterpret_cast<void*>(size_t(cmd.firstIndex) * indexSize), cmd.baseVertex);
+                        m_Stats.drawCalls++;
+                    }
+                }
+                uploadOffset += bucket.commands.size();
+            }
+        }
+
+        const MultiDrawStats& stats() const { return m_Stats; }
+    };
+
+} // namespace gl
@@ -0,0 +1,439 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm.hpp>
+
+#include <Utils.hpp>
+#include <GLState.hpp>
+#include <GeometryBuffer.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+// The CPU path reads back the first pyramid level at most this wide and builds the coarser ones itself
+#ifndef GL_HIZ_READBACK_WIDTH
+#define GL_HIZ_READBACK_WIDTH 256
+#endif
+
+// Readbacks / GPU results in flight; each is used once its fence has passed, never waited on
+#define GL_HIZ_FRAMES 3
+
+namespace gl {
+
+    // World-space box of one object, laid out as comp_hiz_cull.glsl reads it (std430, two vec4)
+    struct OcclusionBounds {
+        glm::vec4 minBounds; // w unused
+        glm::vec4 maxBounds;
+    };
+
+    struct OcclusionStats {
+        size_t tested = 0;
+        size_t occluded = 0;
+        bool gpu = false;        // tested by comp_hiz_cull.glsl, else on the CPU
+        bool hasResult = false;  // false until a pyramid (GPU: a test result) has come back; nothing is culled before
+    };
+
+    // Conservative Hi-Z test, mirrored by comp_hiz_cull.glsl: the box's nearest depth against the farthest depth
+    // stored in the at most 2x2 texels of the finest level (>= firstLevel) its screen rectangle fits in.
+    // size is pyramid level 0, levels its mip count; fetch(level, x, y) returns a texel's farthest depth.
+    // Boxes crossing the camera plane or off screen count as visible (frustum culling's job).
+    template <typename Fetch>
+    bool hiZOccluded(const glm::mat4& viewProjection, const glm::vec3& minBounds, const glm::vec3& maxBounds,
+        const glm::ivec2& size, int levels, int firstLevel, Fetch&& fetch)
+    {
+        glm::vec2 lo(FLT_MAX), hi(-FLT_MAX);
+        float nearest = 1.0f;
+        for (int i = 0; i < 8; i++) {
+            const glm::vec4 p = viewProjection * glm::vec4(
+                i & 1 ? maxBounds.x : minBounds.x, i & 2 ? maxBounds.y : minBounds.y, i & 4 ? maxBounds.z : minBounds.z, 1.0f);
+            if (p.w <= 1e-5f) return false;
+            const glm::vec3 ndc = glm::vec3(p) / p.w;
+            lo = glm::min(lo, glm::vec2(ndc));
+            hi = glm::max(hi, glm::vec2(ndc));
+            nearest = std::min(nearest, ndc.z * 0.5f + 0.5f);
+        }
+        if (nearest <= 0.0f || hi.x < -1.0f || hi.y < -1.0f || lo.x > 1.0f || lo.y > 1.0f) return false;
+
+        // Rectangle in level-0 texels; shifting right by the level gives the texels covering it at that level
+        const glm::ivec2 last = size - 1;
+        const glm::ivec2 p0 = glm::clamp(glm::ivec2(glm::floor((lo * 0.5f + 0.5f) * glm::vec2(size))), glm::ivec2(0), last);
+        const glm::ivec2 p1 = glm::clamp(glm::ivec2(glm::floor((hi * 0.5f + 0.5f) * glm::vec2(size))), glm::ivec2(0), last);
+
+        int level = firstLevel;
+        while (level < levels - 1 && ((p1.x >> level) - (p0.x >> level) > 1 || (p1.y >> level) - (p0.y >> level) > 1)) level++;
+
+        // The last texel of a level also covers the column / row an odd size drops
+        const glm::ivec2 levelLast(std::max(size.x >> level, 1) - 1, std::max(size.y >> level, 1) - 1);
+        const glm::ivec2 a = glm::min(glm::ivec2(p0.x >> level, p0.y >> level), levelLast);
+        const glm::ivec2 b = glm::min(glm::ivec2(p1.x >> level, p1.y >> level), levelLast);
+        const float farthest = std::max(std::max(fetch(level, a.x, a.y), fetch(level, b.x, a.y)),
+            std::max(fetch(level, a.x, b.y), fetch(level, b.x, b.y)));
+        return nearest > farthest;
+    }
+
+    // ============ HI-Z OCCLUSION ============
+    // Max-depth pyramid of the last captured depth buffer and a conservative test of world-space boxes against it.
+    // capture() copies the default framebuffer's depth after a frame's draws, reduces it level by level
+    // (frag_hiz_reduce.glsl) and keeps that frame's view-projection; the next frame's test() projects its boxes
+    // with it. Occlusion is therefore a frame old: an object uncovered by a fast camera turn can appear a frame late.
+    //
+    // With compute shaders (GL 4.3) the boxes are tested by comp_hiz_cull.glsl and the visibility comes back
+    // through a fenced buffer one or two frames later. Without, a coarse pyramid level is read back through a
+    // pixel pack buffer (GL_HIZ_READBACK_WIDTH) and the boxes are tested on the CPU. Neither path waits on the
+    // GPU; until a result has arrived every box counts as visible.
+    class HiZCuller {
+    private:
+        struct Readback {
+            GLuint buffer = 0;
+            GLsync fence = nullptr;
+            glm::mat4 viewProjection = glm::mat4(1.0f);
+            glm::ivec2 size = glm::ivec2(0); // pyramid level 0
+            int levels = 0;
+            int level = 0; // the one read back
+        };
+
+        struct GpuResult {
+            GLuint buffer = 0; // one uint per box, 1 = visible
+            GLsync fence = nullptr;
+            size_t count = 0;
+            uint64_t key = 0;
+        };
+
+        // Levels firstLevel.. of the pyramid, finished on the CPU from the readback
+        struct CpuPyramid {
+            glm::mat4 viewProjection = glm::mat4(1.0f);
+            glm::ivec2 size = glm::ivec2(0);
+            int levels = 0;
+            int firstLevel = 0;
+            std::vector<glm::ivec2> sizes;
+            std::vector<std::vector<float>> texels;
+        };
+
+        bool m_Initialized = false;
+        std::shared_ptr<shader> m_Reduce;
+        std::shared_ptr<shader> m_Cull; // null: CPU path
+        GLuint m_EmptyVao = 0;
+
+        GLuint m_Depth = 0;   // copy of the depth buffer
+        GLuint m_Pyramid = 0; // R32F, farthest depth per texel
+        std::vector<GLuint> m_Framebuffers; // one per pyramid level
+        glm::ivec2 m_Size = glm::ivec2(0);
+        int m_Levels = 0;
+        bool m_Captured = false;
+        glm::mat4 m_ViewProjection = glm::mat4(1.0f);
+
+        Readback m_Readbacks[GL_HIZ_FRAMES];
+        size_t m_NextReadback = 0;
+        CpuPyramid m_Cpu;
+
+        GLuint m_BoundsBuffer = 0;
+        GpuResult m_Results[GL_HIZ_FRAMES];
+        size_t m_NextResult = 0;
+        std::vector<uint32_t> m_Visibility;
+        size_t m_VisibilityCount = 0;
+        uint64_t m_VisibilityKey = 0;
+        bool m_HasVisibility = false;
+
+        OcclusionStats m_Stats;
+
+        static bool signalled(GLsync fence) {
+            const GLenum status = glClientWaitSync(fence, 0, 0);
+            return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+        }
+
+        static void dropFence(GLsync& fence) {
+            if (fence) glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        void init() {
+            m_Initialized = true;
+            m_Reduce = std::make_shared<shader>("resource/shader/vert_fullscreen.glsl", "resource/shader/frag_hiz_reduce.glsl");
+            glGenVertexArrays(1, &m_EmptyVao);
+            if (useCompute && GLEW_VERSION_4_3) {
+                try {
+                    m_Cull = shader::compute("resource/shader/comp_hiz_cull.glsl");
+                }
+                catch (const std::runtime_error& e) {
+                    std::cerr << "Hi-Z: compute culling unavailable, testing on the CPU\n" << e.what() << std::endl;
+                }
+            }
+        }
+
+        void release() {
+            getGLState().deleteTextures(1, &m_Depth);
+            getGLState().deleteTextures(1, &m_Pyramid);
+            if (!m_Framebuffers.empty()) glDeleteFramebuffers(static_cast<GLsizei>(m_Framebuffers.size()), m_Framebuffers.data());
+            m_Depth = m_Pyramid = 0;
+            m_Framebuffers.clear();
+            m_Captured = false;
+        }
+
+        void resize(glm::ivec2 size) {
+            release();
+            m_Size = size;
+            m_Levels = 1;
+            while ((std::max(size.x, size.y) >> m_Levels) > 0) m_Levels++;
+
+            glGenTextures(1, &m_Depth);
+            getGLState().bindTexture(0, GL_TEXTURE_2D, m_Depth);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, size.x, size.y, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+
+            glGenTextures(1, &m_Pyramid);
+            getGLState().bindTexture(0, GL_TEXTURE_2D, m_Pyramid);
+            for (int level = 0; level < m_Levels; level++) {
+                glTexImage2D(GL_TEXTURE_2D, level, GL_R32F, std::max(size.x >> level, 1), std::max(size.y >> level, 1), 0, GL_RED, GL_FLOAT, nullptr);
+            }
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_Levels - 1);
+
+            m_Framebuffers.resize(m_Levels);
+            glGenFramebuffers(m_Levels, m_Framebuffers.data());
+            for (int level = 0; level < m_Levels; level++) {
+                glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_Framebuffers[level]);
+                glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_Pyramid, level);
+            }
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        }
+
+        // Queue a copy of the first level at most GL_HIZ_READBACK_WIDTH wide
+        void readBack() {
+            Readback& slot = m_Readbacks[m_NextReadback];
+            m_NextReadback = (m_NextReadback + 1) % GL_HIZ_FRAMES;
+            dropFence(slot.fence); // never collected: overwritten
+
+            int level = 0;
+            while (level < m_Levels - 1 && (m_Size.x >> level) > GL_HIZ_READBACK_WIDTH) level++;
+            const size_t bytes = size_t(std::max(m_Size.x >> level, 1)) * size_t(std::max(m_Size.y >> level, 1)) * sizeof(float);
+
+            if (!slot.buffer) glGenBuffers(1, &slot.buffer);
+            getGLState().bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+            getGLState().bindTexture(0, GL_TEXTURE_2D, m_Pyramid);
+            glPixelStorei(GL_PACK_ALIGNMENT, 4);
+            glGetTexImage(GL_TEXTURE_2D, level, GL_RED, GL_FLOAT, nullptr);
+            getGLState().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            slot.viewProjection = m_ViewProjection;
+            slot.size = m_Size;
+            slot.levels = m_Levels;
+            slot.level = level;
+        }
+
+        // Take the newest finished readback into m_Cpu and reduce the remaining levels
+        void collectReadback() {
+            Readback* newest = nullptr;
+            for (size_t i = 0; i < GL_HIZ_FRAMES; i++) {
+                Readback& slot = m_Readbacks[(m_NextReadback + i) % GL_HIZ_FRAMES]; // oldest first
+                if (!slot.fence) continue;
+                if (!signalled(slot.fence)) break;
+                dropFence(slot.fence);
+                newest = &slot;
+            }
+            if (!newest) return;
+
+            m_Cpu.viewProjection = newest->viewProjection;
+            m_Cpu.size = newest->size;
+            m_Cpu.levels = newest->levels;
+            m_Cpu.firstLevel = newest->level;
+            m_Cpu.sizes.clear();
+            for (int level = newest->level; level < newest->levels; level++)
+                m_Cpu.sizes.push_back({ std::max(newest->size.x >> level, 1), std::max(newest->size.y >> level, 1) });
+            m_Cpu.texels.resize(m_Cpu.sizes.size());
+
+            std::vector<float>& first = m_Cpu.texels[0];
+            first.resize(size_t(m_Cpu.sizes[0].x) * size_t(m_Cpu.sizes[0].y));
+            getGLState().bindBuffer(GL_PIXEL_PACK_BUFFER, newest->buffer);
+            glGetBufferSubData(GL_PIXEL_PACK_BUFFER, 0, first.size() * sizeof(float), first.data());
+            getGLState().bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            // Same reduction as frag_hiz_reduce.glsl
+            for (size_t l = 1; l < m_Cpu.sizes.size(); l++) {
+                const glm::ivec2 src = m_Cpu.sizes[l - 1], dst = m_Cpu.sizes[l];
+                const std::vector<float>& in = m_Cpu.texels[l - 1];
+                std::vector<float>& out = m_Cpu.texels[l];
+                out.resize(size_t(dst.x) * size_t(dst.y));
+                for (int y = 0; y < dst.y; y++) {
+                    const int y1 = (src.y & 1) && y == dst.y - 1 ? 2 : 1;
+                    for (int x = 0; x < dst.x; x++) {
+                        const int x1 = (src.x & 1) && x == dst.x - 1 ? 2 : 1;
+                        float farthest = 0.0f;
+                        for (int dy = 0; dy <= y1; dy++) {
+                            const int sy = std::min(2 * y + dy, src.y - 1);
+                            for (int dx = 0; dx <= x1; dx++) {
+                                farthest = std::max(farthest, in[size_t(sy) * src.x + std::min(2 * x + dx, src.x - 1)]);
+                            }
+                        }
+                        out[size_t(y) * dst.x + x] = farthest;
+                    }
+                }
+            }
+        }
+
+        void testCpu(const std::vector<OcclusionBounds>& boxes, std::vector<uint8_t>& visible) {
+            collectReadback();
+            if (m_Cpu.texels.empty()) return;
+            m_Stats.hasResult = true;
+
+            auto fetch = [&](int level, int x, int y) {
+                const int l = level - m_Cpu.firstLevel;
+                return m_Cpu.texels[l][size_t(y) * m_Cpu.sizes[l].x + x];
+            };
+            for (size_t i = 0; i < boxes.size(); i++) {
+                if (hiZOccluded(m_Cpu.viewProjection, glm::vec3(boxes[i].minBounds), glm::vec3(boxes[i].maxBounds),
+                    m_Cpu.size, m_Cpu.levels, m_Cpu.firstLevel, fetch)) visible[i] = 0;
+            }
+        }
+
+        void testGpu(const std::vector<OcclusionBounds>& boxes, std::vector<uint8_t>& visible, uint64_t key) {
+            // Newest finished result
+            for (size_t i = 0; i < GL_HIZ_FRAMES; i++) {
+                GpuResult& slot = m_Results[(m_NextResult + i) % GL_HIZ_FRAMES]; // oldest first
+                if (!slot.fence) continue;
+                if (!signalled(slot.fence)) break;
+                dropFence(slot.fence);
+                m_Visibility.resize(slot.count);
+                getGLState().bindBuffer(GL_SHADER_STORAGE_BUFFER, slot.buffer);
+                glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, slot.count * sizeof(uint32_t), m_Visibility.data());
+                m_VisibilityCount = slot.count;
+                m_VisibilityKey = slot.key;
+                m_HasVisibility = true;
+            }
+
+            // This frame's boxes, read back in a later frame
+            if (m_Captured && !boxes.empty()) {
+                GpuResult& slot = m_Results[m_NextResult];
+                m_NextResult = (m_NextResult + 1) % GL_HIZ_FRAMES;
+                dropFence(slot.fence);
+
+                if (!m_BoundsBuffer) glGenBuffers(1, &m_BoundsBuffer);
+                if (!slot.buffer) glGenBuffers(1, &slot.buffer);
+                const GLsizeiptr boundsBytes = GLsizeiptr(boxes.size() * sizeof(OcclusionBounds));
+                const GLsizeiptr resultBytes = GLsizeiptr(boxes.size() * sizeof(uint32_t));
+                getGLState().bindBuffer(GL_SHADER_STORAGE_BUFFER, m_BoundsBuffer);
+                glBufferData(GL_SHADER_STORAGE_BUFFER, boundsBytes, boxes.data(), GL_STREAM_DRAW);
+                getGLState().bindBuffer(GL_SHADER_STORAGE_BUFFER, slot.buffer);
+                glBufferData(GL_SHADER_STORAGE_BUFFER, resultBytes, nullptr, GL_STREAM_READ);
+                getGLState().bindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_BoundsBuffer, 0, boundsBytes);
+                getGLState().bindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, slot.buffer, 0, resultBytes);
+
+                m_Cull->useProgram();
+                getGLState().bindTexture(0, GL_TEXTURE_2D, m_Pyramid);
+                m_Cull->setUniform1i("hiZ", 0);
+                m_Cull->setUniformMat4fv("viewProjection", m_ViewProjection);
+                m_Cull->setUniform2f("size", glm::vec2(m_Size));
+                m_Cull->setUniform1i("levels", m_Levels);
+                m_Cull->setUniform1i("count", static_cast<int>(boxes.size()));
+                glDispatchCompute(static_cast<GLuint>((boxes.size() + 63) / 64), 1, 1);
+                glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+                slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                slot.count = boxes.size();
+                slot.key = key;
+            }
+
+            // Results belong to the object list they were tested for
+            if (!m_HasVisibility || m_VisibilityKey != key || m_VisibilityCount != boxes.size()) return;
+            m_Stats.hasResult = true;
+            for (size_t i = 0; i < boxes.size(); i++) {
+                if (!m_Visibility[i]) visible[i] = 0;
+            }
+        }
+
+    public:
+        bool useCompute = true; // read once, at the first capture()
+
+        HiZCuller() = default;
+        HiZCuller(const HiZCuller&) = delete;
+        HiZCuller& operator=(const HiZCuller&) = delete;
+
+        ~HiZCuller() {
+            release();
+            for (Readback& slot : m_Readbacks) {
+                dropFence(slot.fence);
+                getGLState().deleteBuffers(1, &slot.buffer);
+            }
+            for (GpuResult& slot : m_Results) {
+                dropFence(slot.fence);
+                getGLState().deleteBuffers(1, &slot.buffer);
+            }
+            getGLState().deleteBuffers(1, &m_BoundsBuffer);
+            getGLState().deleteVertexArrays(1, &m_EmptyVao);
+        }
+
+        // Build the pyramid from the default framebuffer's depth, drawn with viewProjection into a width x height
+        // viewport. Call after the frame's opaque draws; leaves depth testing enabled and the default framebuffer bound.
+        void capture(const glm::mat4& viewProjection, int width, int height) {
+            if (width <= 0 || height <= 0) return;
+            if (!m_Initialized) init();
+            if (m_Size != glm::ivec2(width, height)) resize({ width, height });
+
+            getGLState().bindTexture(0, GL_TEXTURE_2D, m_Depth);
+            glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+
+            StateCache& state = getGLState();
+            state.setEnabled(GL_DEPTH_TEST, false);
+            state.setEnabled(GL_BLEND, false);
+            state.colorMask(true);
+            m_Reduce->useProgram();
+            m_Reduce->setUniform1i("src", 0);
+            useVertexArray(m_EmptyVao);
+
+            for (int level = 0; level < m_Levels; level++) {
+                glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_Framebuffers[level]);
+                glViewport(0, 0, std::max(width >> level, 1), std::max(height >> level, 1));
+                if (level == 0) {
+                    state.bindTexture(0, GL_TEXTURE_2D, m_Depth);
+                    m_Reduce->setUniform1i("copyDepth", 1);
+                }
+                else {
+                    // Sample only the level below the one being written
+                    state.bindTexture(0, GL_TEXTURE_2D, m_Pyramid);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level - 1);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, level - 1);
+                    m_Reduce->setUniform1i("copyDepth", 0);
+                }
+                glDrawArrays(GL_TRIANGLES, 0, 3);
+            }
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_Levels - 1);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glViewport(0, 0, width, height);
+            state.setEnabled(GL_DEPTH_TEST, true);
+
+            m_ViewProjection = viewProjection;
+            m_Captured = true;
+            if (!m_Cull) readBack();
+        }
+
+        // visible[i] = 0 for boxes hidden in the last available pyramid, 1 otherwise. key identifies the list of
+        // objects the boxes belong to (GPU results come back a frame or two later and are dropped if it changed).
+        void test(const std::vector<OcclusionBounds>& boxes, std::vector<uint8_t>& visible, uint64_t key = 0) {
+            m_Stats = OcclusionStats();
+            m_Stats.tested = boxes.size();
+            m_Stats.gpu = m_Cull != nullptr;
+            visible.assign(boxes.size(), 1);
+            if (!m_Initialized) return;
+
+            if (m_Cull) testGpu(boxes, visible, key);
+            else testCpu(boxes, visible);
+            m_Stats.occluded = size_t(std::count(visible.begin(), visible.end(), uint8_t(0)));
+        }
+
+        // Of the last test()
+        const OcclusionStats& stats() const { return m_Stats; }
+
+        bool computeSupported() const { return m_Cull != nullptr; }
+    };
+
+} // namespace gl
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm.hpp>
+#include <gtc/packing.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace gl {
+
+    enum class VertexFormat {
+        Standard, // Mesh::Vertex, 56 bytes, 32-bit indices
+        Packed,   // PackedVertex, 20 bytes, 16-bit indices below 65536 vertices
+        Split     // one buffer per attribute uploaded from a mapped .glb, see Mesh::uploadStreams
+    };
+
+    // ============ PACKED VERTEX ============
+    // Decoded by resource/shader/vert_packed.glsl:
+    // - position: unorm16 xyz against the mesh bounds (uniforms posOffset/posScale), w = bitangent sign
+    // - normal/tangent: octahedral snorm16x2
+    // - texCoords: half floats
+    struct PackedVertex {
+        uint16_t position[4];
+        int16_t normal[2];
+        uint16_t texCoords[2];
+        int16_t tangent[2];
+    };
+
+    static_assert(sizeof(PackedVertex) == 20, "PackedVertex must stay 20 bytes");
+
+    namespace pack {
+
+        inline uint16_t unorm16(float v) {
+            return static_cast<uint16_t>(std::lround(glm::clamp(v, 0.0f, 1.0f) * 65535.0f));
+        }
+
+        inline int16_t snorm16(float v) {
+            return static_cast<int16_t>(std::lround(glm::clamp(v, -1.0f, 1.0f) * 32767.0f));
+        }
+
+        // Octahedral mapping of a unit vector onto [-1, 1]^2
+        inline glm::vec2 octEncode(glm::vec3 n) {
+            float sum = std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z);
+            if (sum <= 0.0f) return glm::vec2(0.0f, 0.0f);
+            n /= sum;
+
+            glm::vec2 p(n.x, n.y);
+            if (n.z < 0.0f) {
+                p = glm::vec2(
+                    (1.0f - std::fabs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+                    (1.0f - std::fabs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+            }
+            return p;
+        }
+
+        inline glm::vec3 octDecode(glm::vec2 e) {
+            glm::vec3 n(e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y));
+            float t = glm::max(-n.z, 0.0f);
+            n.x += n.x >= 0.0f ? -t : t;
+            n.y += n.y >= 0.0f ? -t : t;
+            return glm::normalize(n);
+        }
+
+    }
+
+    PackedVertex packVertex(
+        const glm::vec3& position, const glm::vec3& normal, const glm::vec2& texCoords,
+        const glm::vec3& tangent, const glm::vec3& bitangent,
+        const glm::vec3& boundsMin, const glm::vec3& boundsExtent)
+    {
+        PackedVertex out;
+
+        for (int k = 0; k < 3; k++) {
+            float range = boundsExtent[k];
+            out.position[k] = pack::unorm16(range > 0.0f ? (position[k] - boundsMin[k]) / range : 0.0f);
+        }
+
+        // Mirrored UVs flip the bitangent; everything else rebuilds it as cross(N, T)
+        bool flipped = glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f;
+        out.position[3] = flipped ? 0 : 65535;
+
+        glm::vec2 n = pack::octEncode(normal);
+        out.normal[0] = pack::snorm16(n.x);
+        out.normal[1] = pack::snorm16(n.y);
+
+        glm::vec3 t = glm::dot(tangent, tangent) > 0.0f ? tangent : glm::vec3(1.0f, 0.0f, 0.0f);
+        glm::vec2 te = pack::octEncode(t);
+        out.tangent[0] = pack::snorm16(te.x);
+        out.tangent[1] = pack::snorm16(te.y);
+
+        out.texCoords[0] = glm::packHalf1x16(texCoords.x);
+        out.texCoords[1] = glm::packHalf1x16(texCoords.y);
+        return out;
+    }
+
+    // Attribute layout matching vert_packed.glsl; the VAO and VBO must be bound
+    void packedVertexAttributes() {
+        const GLsizei stride = sizeof(PackedVertex);
+
+        glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, position));
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, normal));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(PackedVertex, texCoords));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(3, 2, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, tangent));
+        glEnableVertexAttribArray(3);
+    }
+
+} // namespace gl
@@ -0,0 +1,360 @@
+#pragma once
+
+#include <Utils.hpp>
+#include <GeometryBuffer.hpp>
+#include <GLState.hpp>
+#include <Instancing.hpp>
+#include <Meshlet.hpp>
+#include <MultiDraw.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// glPolygonOffset factor and units of the depth pre-pass, so the shading pass's GL_LEQUAL absorbs rounding
+// differences between vert_depth.glsl and the shading vertex shaders (see RenderQueue::submitDepth)
+#ifndef GL_DEPTH_PREPASS_OFFSET
+#define GL_DEPTH_PREPASS_OFFSET 1.0f
+#endif
+
+namespace gl {
+
+    // Submission order of an object's draws; layers go out in this order
+    enum class RenderLayer : uint8_t {
+        Opaque = 0,      // sorted by state, then front to back
+        Transparent = 1, // back to front, blended, no depth writes
+        Overlay = 2,     // after everything else, e.g. the weapon viewmodel
+    };
+
+    // ============ SORT KEYS ============
+    // 64-bit draw keys, most significant field first:
+    //   opaque / overlay: layer (2) | program (16) | material (22) | depth (24)
+    //   transparent:      layer (2) | ~depth (24)  | program (16)  | material (22)
+    // Programs and materials only group draws: folding GL names and TextureSets ids into their fields can
+    // merge two of them, which costs state changes but never correctness, as submission compares the full
+    // program and texture-set id of consecutive draws.
+    namespace sortkey {
+
+        // Top 24 bits of a non-negative float, whose bit pattern orders like its value
+        inline uint64_t depthBits(float depth) {
+            depth = depth > 0.0f ? depth : 0.0f;
+            uint32_t bits;
+            std::memcpy(&bits, &depth, sizeof(bits));
+            return bits >> 7;
+        }
+
+        inline uint64_t make(RenderLayer layer, GLuint program, uint32_t material, float depth) {
+            const uint64_t l = uint64_t(layer) & 0x3;
+            const uint64_t p = program & 0xFFFF;
+            const uint64_t m = material & 0x3FFFFF;
+            const uint64_t d = depthBits(depth);
+
+            if (layer == RenderLayer::Transparent) return (l << 62) | ((~d & 0xFFFFFF) << 38) | (p << 22) | m;
+            return (l << 62) | (p << 46) | (m << 24) | d;
+        }
+
+        inline RenderLayer layer(uint64_t key) { return RenderLayer(key >> 62); }
+
+    } // namespace sortkey
+
+    // ============ RADIX SORT ============
+    // Key and payload index of one draw
+    struct SortItem {
+        uint64_t key;
+        uint32_t index;
+    };
+
+    // Stable LSD radix sort on the key, a byte per pass. Passes whose byte is equal for every item
+    // (common: unused layers, few programs) are skipped. scratch is resized to items.size().
+    inline void radixSort(std::vector<SortItem>& items, std::vector<SortItem>& scratch) {
+        const size_t n = items.size();
+        if (n < 64) {
+            std::stable_sort(items.begin(), items.end(), [](const SortItem& a, const SortItem& b) { return a.key < b.key; });
+            return;
+        }
+
+        size_t counts[8][256] = {};
+        for (const SortItem& item : items) {
+            for (int pass = 0; pass < 8; pass++) counts[pass][(item.key >> (pass * 8)) & 0xFF]++;
+        }
+
+        scratch.resize(n);
+        SortItem* src = items.data();
+        SortItem* dst = scratch.data();
+        for (int pass = 0; pass < 8; pass++) {
+            const int shift = pass * 8;
+            size_t* count = counts[pass];
+            if (count[(src[0].key >> shift) & 0xFF] == n) continue;
+
+            size_t offset = 0;
+            for (int b = 0; b < 256; b++) {
+                const size_t c = count[b];
+                count[b] = offset;
+                offset += c;
+            }
+            for (size_t i = 0; i < n; i++) dst[count[(src[i].key >> shift) & 0xFF]++] = src[i];
+            std::swap(src, dst);
+        }
+        if (src != items.data()) std::copy(src, src + n, items.data());
+    }
+
+    // Program, material and VAO switches needed to submit draws in some order
+    struct StateChanges {
+        size_t program = 0;
+        size_t material = 0;
+        size_t vertexArray = 0;
+
+        size_t total() const { return program + material + vertexArray; }
+    };
+
+    struct RenderQueueStats {
+        size_t draws = 0;
+        size_t depthDraws = 0; // of the last submitDepth
+        StateChanges unsorted; // in the order the draws were added (Scene::objects order)
+        StateChanges sorted;   // in the order they were submitted
+        double sortMs = 0.0;
+    };
+
+    // ============ RENDER QUEUE ============
+    // Collects a frame's visible draws with a sort key each, radix sorts them and submits them in key order:
+    // opaque draws grouped by program and material and front to back within a group (early-Z friendly),
+    // then transparent draws back to front, then overlays. Draws are plain GL records, so anything with a
+    // VAO and an index range can be queued; Object::queueDraws queues an object's meshes.
+    class RenderQueue {
+    public:
+        struct Draw {
+            shader* program = nullptr;
+            const std::unordered_map<std::string, GLuint>* textures = nullptr; // valid until submit()
+            uint32_t textureSet = 0;  // getTextureSets().intern(*textures)
+            GLuint vao = 0;
+            GLuint depthVao = 0;      // positions only (Mesh::depthVAO), for submitDepth; 0 = use vao
+            GLenum indexType = GL_UNSIGNED_INT;
+            size_t indexOffset = 0;   // bytes, of the mesh's first index
+            GLint baseVertex = 0;
+            uint32_t instance = 0;    // from addInstance
+            bool packed = false;      // VertexFormat::Packed: needs posOffset / posScale
+            glm::vec3 posOffset = glm::vec3(0.0f);
+            glm::vec3 posScale = glm::vec3(1.0f);
+            uint32_t firstRange = 0;  // set by add()
+            uint32_t rangeCount = 0;
+            float depth = 0.0f;
+        };
+
+    private:
+        std::vector<Draw> m_Draws;
+        std::vector<MeshletRange> m_Ranges;
+        std::vector<glm::mat4> m_Instances;
+        std::vector<SortItem> m_Items;
+        std::vector<SortItem> m_Scratch;
+        std::vector<SortItem> m_DepthItems;
+        RenderQueueStats m_Stats;
+
+        // Switches needed to submit m_Draws in the order of m_Items
+        StateChanges countChanges(bool sortedOrder) const {
+            StateChanges changes;
+            const Draw* last = nullptr;
+            for (size_t i = 0; i < m_Items.size(); i++) {
+                const Draw& draw = m_Draws[sortedOrder ? m_Items[i].index : i];
+                if (!last || draw.program != last->program) changes.program++;
+                if (!last || draw.program != last->program || draw.textureSet != last->textureSet) changes.material++;
+                if (!last || draw.vao != last->vao) changes.vertexArray++;
+                last = &draw;
+            }
+            return changes;
+        }
+
+        // depthEqual: the depth buffer already holds this layer's depth (submitDepth), so only the
+        // nearest surface passes and nothing needs writing. Tested with GL_LEQUAL against the pre-pass's
+        // offset depth rather than GL_EQUAL, see submitDepth.
+        static void setLayerState(RenderLayer layer, bool depthEqual) {
+            const bool blended = layer == RenderLayer::Transparent;
+            getGLState().setEnabled(GL_BLEND, blended);
+            if (blended) getGLState().blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            getGLState().depthMask(!blended && !depthEqual);
+            getGLState().depthFunc(depthEqual && !blended ? GL_LEQUAL : GL_LESS);
+        }
+
+        // Issue draw's index ranges from the bound VAO
+        void drawRanges(const Draw& draw) const {
+            thread_local std::vector<GLsizei> counts;
+            thread_local std::vector<void*> offsets; // GLEW declares the BaseVertex entry points without const
+            thread_local std::vector<GLint> baseVertices;
+
+            const size_t indexSize = draw.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+            const MeshletRange* ranges = m_Ranges.data() + draw.firstRange;
+            if (draw.rangeCount == 1) {
+                glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(ranges[0].indexCount), draw.indexType,
+                    reinterpret_cast<void*>(draw.indexOffset + size_t(ranges[0].firstIndex) * indexSize), draw.baseVertex);
+                return;
+            }
+
+            counts.clear();
+            offsets.clear();
+            for (uint32_t r = 0; r < draw.rangeCount; r++) {
+                counts.push_back(static_cast<GLsizei>(ranges[r].indexCount));
+                offsets.push_back(reinterpret_cast<void*>(draw.indexOffset + size_t(ranges[r].firstIndex) * indexSize));
+            }
+            baseVertices.assign(draw.rangeCount, draw.baseVertex);
+            glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), draw.indexType, offsets.data(),
+                static_cast<GLsizei>(draw.rangeCount), baseVertices.data());
+        }
+
+    public:
+        bool sortEnabled = true; // false submits in insertion order, e.g. to compare
+        bool copyMaterials = false; // draw from the interned texture sets, for queues submitted on another thread
+
+        RenderQueue() = default;
+        RenderQueue(const RenderQueue&) = delete;
+        RenderQueue& operator=(const RenderQueue&) = delete;
+
+        // Start a frame; storage is kept
+        void clear() {
+            m_Draws.clear();
+            m_Ranges.clear();
+            m_Instances.clear();
+            m_Items.clear();
+        }
+
+        // Returns the Draw::instance for this model matrix
+        uint32_t addInstance(const glm::mat4& model) {
+            m_Instances.push_back(model);
+            return static_cast<uint32_t>(m_Instances.size() - 1);
+        }
+
+        // Queue draw over index ranges (relative to the mesh's first index); depth is the distance from the eye
+        void add(RenderLayer layer, float depth, const Draw& draw, const MeshletRange* ranges, size_t rangeCount) {
+            if (rangeCount == 0) return;
+            const uint32_t index = static_cast<uint32_t>(m_Draws.size());
+            m_Draws.push_back(draw);
+            if (copyMaterials) m_Draws.back().textures = &getTextureSets().get(draw.textureSet);
+            m_Draws.back().firstRange = static_cast<uint32_t>(m_Ranges.size());
+            m_Draws.back().rangeCount = static_cast<uint32_t>(rangeCount);
+            m_Draws.back().depth = depth;
+            m_Ranges.insert(m_Ranges.end(), ranges, ranges + rangeCount);
+            m_Items.push_back({ sortkey::make(layer, draw.program->getProgram(), draw.textureSet, depth), index });
+        }
+
+        // Depth-only pass over the opaque and overlay draws: front to back, colour writes off, through each mesh's
+        // position-only VAO where it has one. program is vert_depth.glsl. A following submit(true) then shades
+        // every covered pixel once.
+        // The shading pass only matches the pre-pass if both produce the same depth, which invariant gl_Position
+        // guarantees only for the same expression on the same inputs. vert_depth.glsl dequantises the position
+        // stream with a uniform model matrix, while vert.glsl reads the full vertex and vert_instanced.glsl an
+        // instanced matrix, so the low bits may differ. The pre-pass is therefore pushed back by
+        // GL_DEPTH_PREPASS_OFFSET and the shading pass tests GL_LEQUAL: surfaces within that offset of the
+        // nearest one may shade as well, but none is dropped.
+        void submitDepth(shader& program) {
+            m_DepthItems.clear();
+            for (const SortItem& item : m_Items) {
+                if (sortkey::layer(item.key) != RenderLayer::Transparent)
+                    m_DepthItems.push_back({ sortkey::depthBits(m_Draws[item.index].depth), item.index });
+            }
+            m_Stats.depthDraws = m_DepthItems.size();
+            if (m_DepthItems.empty()) return;
+            radixSort(m_DepthItems, m_Scratch);
+
+            setLayerState(RenderLayer::Opaque, false);
+            getGLState().colorMask(false);
+            getGLState().setEnabled(GL_POLYGON_OFFSET_FILL, true);
+            glPolygonOffset(GL_DEPTH_PREPASS_OFFSET, GL_DEPTH_PREPASS_OFFSET);
+            program.useProgram();
+            program.setUniform3fv("posOffset", glm::vec3(0.0f));
+            program.setUniform3fv("posScale", glm::vec3(1.0f));
+
+            uint32_t lastInstance = ~0u;
+            bool packed = false;
+            for (const SortItem& item : m_DepthItems) {
+                const Draw& draw = m_Draws[item.index];
+                if (draw.instance != lastInstance) {
+                    program.setUniformMat4fv("model", m_Instances[draw.instance]);
+                    lastInstance = draw.instance;
+                }
+                if (draw.packed) {
+                    program.setUniform3fv("posOffset", draw.posOffset);
+                    program.setUniform3fv("posScale", draw.posScale);
+                    packed = true;
+                }
+                else if (packed) {
+                    program.setUniform3fv("posOffset", glm::vec3(0.0f));
+                    program.setUniform3fv("posScale", glm::vec3(1.0f));
+                    packed = false;
+                }
+
+                useVertexArray(draw.depthVao ? draw.depthVao : draw.vao);
+                drawRanges(draw);
+            }
+            getGLState().setEnabled(GL_POLYGON_OFFSET_FILL, false);
+            getGLState().colorMask(true);
+        }
+
+        // Sort and draw everything added since clear(). depthEqual after submitDepth: opaque and overlay
+        // draws test GL_LEQUAL against the pre-pass without writing depth. Leaves blending off, depth writes on
+        // and GL_LESS.
+        void submit(bool depthEqual = false) {
+            const size_t depthDraws = m_Stats.depthDraws;
+            m_Stats = RenderQueueStats();
+            m_Stats.draws = m_Draws.size();
+            m_Stats.depthDraws = depthDraws;
+            if (m_Draws.empty()) return;
+
+            m_Stats.unsorted = countChanges(false);
+            if (sortEnabled) {
+                const auto start = std::chrono::steady_clock::now();
+                radixSort(m_Items, m_Scratch);
+                m_Stats.sortMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            else {
+                // Insertion order within each layer
+                std::stable_sort(m_Items.begin(), m_Items.end(), [](const SortItem& a, const SortItem& b) {
+                    return sortkey::layer(a.key) < sortkey::layer(b.key);
+                });
+            }
+            m_Stats.sorted = countChanges(true);
+
+            InstanceStream& stream = getInstanceStream();
+            const Draw* last = nullptr;
+            bool instanced = false;
+            RenderLayer layer = RenderLayer::Opaque;
+            setLayerState(layer, depthEqual);
+
+            for (const SortItem& item : m_Items) {
+                const Draw& draw = m_Draws[item.index];
+                const bool programChanged = !last || draw.program != last->program;
+
+                if (sortkey::layer(item.key) != layer) {
+                    layer = sortkey::layer(item.key);
+                    setLayerState(layer, depthEqual);
+                }
+                if (programChanged) {
+                    draw.program->useProgram();
+                    instanced = stream.readsInstanceModel(draw.program->getProgram());
+                }
+                if (programChanged || draw.textureSet != last->textureSet) bindMaterialTextures(*draw.program, *draw.textures);
+                if (programChanged || draw.instance != last->instance) {
+                    const glm::mat4& model = m_Instances[draw.instance];
+                    if (instanced) InstanceStream::setConstant(model);
+                    else draw.program->setUniformMat4fv("model", model);
+                }
+
+                useVertexArray(draw.vao);
+                if (instanced) stream.detach(draw.vao);
+                if (draw.packed) {
+                    draw.program->setUniform3fv("posOffset", draw.posOffset);
+                    draw.program->setUniform3fv("posScale", draw.posScale);
+                }
+
+                drawRanges(draw);
+                last = &draw;
+            }
+            setLayerState(RenderLayer::Opaque, false);
+        }
+
+        const RenderQueueStats& stats() const { return m_Stats; } // of the last submit
+    };
+
+} // namespace gl
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm.hpp>
+
+#include <imgui.h>
+#include <imgui_impl_opengl3.h>
+
+#include <GLState.hpp>
+#include <FrameUniforms.hpp>
+#include <RenderQueue.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace gl {
+
+    // ============ COMMAND LIST ============
+    // One frame of rendering, recorded without touching GL: what to clear, the frame's uniform block, scenes
+    // as sort-key RenderQueues (Scene::record), UI draw data and GL work that has to run on the context's
+    // thread (uploads, deletes). Executed in recording order by RenderThread::execute.
+    //
+    // Everything the recorded draws point at must stay alive until the list has executed: retain() it, and
+    // the reference is dropped on the executing thread, so a last release that deletes GL objects happens there.
+    class CommandList {
+    public:
+        enum class Type : uint8_t { Clear, Frame, Scene, Run, UI, Present };
+
+        struct Command {
+            Type type;
+            uint32_t index; // into the payload array of its type
+        };
+
+    private:
+        std::vector<Command> m_Commands;
+        std::vector<glm::vec4> m_Clears;
+        std::vector<FrameUniforms> m_Frames;
+        std::vector<std::unique_ptr<RenderQueue>> m_Scenes; // pooled; m_SceneCount in use
+        size_t m_SceneCount = 0;
+        std::vector<std::function<void()>> m_Tasks;
+        std::vector<std::shared_ptr<const void>> m_Retained;
+        ImDrawData m_UI;
+
+        friend class RenderThread;
+
+        void releaseUI() {
+            for (ImDrawList* list : m_UI.CmdLists) IM_DELETE(list);
+            m_UI.Clear();
+        }
+
+    public:
+        // Filled in by the thread that executed the list
+        double executeMs = 0.0;
+
+        CommandList() = default;
+        CommandList(const CommandList&) = delete;
+        CommandList& operator=(const CommandList&) = delete;
+
+        ~CommandList() { releaseUI(); }
+
+        // Drop everything recorded; storage is kept. RenderThread calls this after executing the list.
+        void reset() {
+            m_Commands.clear();
+            m_Clears.clear();
+            m_Frames.clear();
+            m_SceneCount = 0;
+            m_Tasks.clear();
+            m_Retained.clear();
+            releaseUI();
+        }
+
+        void clear(const glm::vec4& color) {
+            m_Commands.push_back({ Type::Clear, static_cast<uint32_t>(m_Clears.size()) });
+            m_Clears.push_back(color);
+        }
+
+        // Uploaded to the Frame block; its viewport also sets glViewport
+        void frame(const FrameUniforms& uniforms) {
+            m_Commands.push_back({ Type::Frame, static_cast<uint32_t>(m_Frames.size()) });
+            m_Frames.push_back(uniforms);
+        }
+
+        // An empty queue to record a scene into, submitted at this point of the list
+        RenderQueue& scene() {
+            if (m_SceneCount == m_Scenes.size()) {
+                m_Scenes.push_back(std::make_unique<RenderQueue>());
+                m_Scenes.back()->copyMaterials = true;
+            }
+            RenderQueue& queue = *m_Scenes[m_SceneCount];
+            queue.clear();
+            m_Commands.push_back({ Type::Scene, static_cast<uint32_t>(m_SceneCount++) });
+            return queue;
+        }
+
+        // GL work to run on the executing thread at this point of the list
+        void run(std::function<void()> task) {
+            m_Commands.push_back({ Type::Run, static_cast<uint32_t>(m_Tasks.size()) });
+            m_Tasks.push_back(std::move(task));
+        }
+
+        // Copy of ImGui's draw data (ImGui::Render() output), as the context rebuilds it next frame.
+        // One UI per list.
+        void ui(const ImDrawData* data) {
+            if (!data || !data->Valid) return;
+            releaseUI();
+            m_UI.Valid = true;
+            m_UI.DisplayPos = data->DisplayPos;
+            m_UI.DisplaySize = data->DisplaySize;
+            m_UI.FramebufferScale = data->FramebufferScale;
+            for (ImDrawList* list : data->CmdLists) {
+                if (list->CmdBuffer.Size > 0) m_UI.AddDrawList(list->CloneOutput());
+            }
+            m_Commands.push_back({ Type::UI, 0 });
+        }
+
+        // Swap the window's buffers
+        void present() { m_Commands.push_back({ Type::Present, 0 }); }
+
+        void retain(std::shared_ptr<const void> resource) { m_Retained.push_back(std::move(resource)); }
+
+        size_t size() const { return m_Commands.size(); }
+    };
+
+    struct RenderThreadStats {
+        size_t frames = 0;
+        double simulationWaitMs = 0.0; // recording thread blocked on a list still being executed
+        double executeMs = 0.0;        // render thread executing lists
+    };
+
+    // ============ RENDER THREAD ============
+    // Owns the GL context and executes frame N-1's CommandList while the simulation thread records frame N.
+    // Two lists change hands through an atomic state per list, so neither side takes a lock: the recorder
+    // waits only when it is two frames ahead, the render thread only when nothing has been submitted.
+    //
+    // GLFW input must stay on the main thread, so that thread simulates and records; the render thread is the
+    // one started here. While it runs, the recording thread must not call GL: window::ifRun no longer makes
+    // the context current after window::releaseContext, and GL work goes into the list with run().
+    class RenderThread {
+    private:
+        enum State : uint8_t { Free, Ready, Quit };
+
+        GLFWwindow* m_Window = nullptr;
+        std::thread m_Thread;
+        CommandList m_Lists[2];
+        std::atomic<uint8_t> m_States[2] = { Free, Free };
+        std::atomic<bool> m_Started{ false };
+        size_t m_Record = 0;  // list the recorder writes next
+        size_t m_Execute = 0; // list the render thread executes next, render thread only
+        RenderThreadStats m_Stats;
+
+        using clock = std::chrono::steady_clock;
+
+        static double since(clock::time_point start) {
+            return std::chrono::duration<double, std::milli>(clock::now() - start).count();
+        }
+
+        // Block until state leaves from; returns the new value
+        static uint8_t waitWhile(std::atomic<uint8_t>& state, uint8_t from) {
+            uint8_t value;
+            while ((value = state.load(std::memory_order_acquire)) == from) state.wait(from, std::memory_order_acquire);
+            return value;
+        }
+
+        void loop(std::function<void()> init) {
+            glfwMakeContextCurrent(m_Window);
+            ImGui_ImplOpenGL3_NewFrame(); // the renderer backend creates its GL objects on this thread
+            if (init) init();
+            m_Started.store(true, std::memory_order_release);
+            m_Started.notify_all();
+
+            for (;;) {
+                std::atomic<uint8_t>& state = m_States[m_Execute];
+                if (waitWhile(state, Free) == Quit) break;
+
+                CommandList& list = m_Lists[m_Execute];
+                execute(list, m_Window);
+                list.reset();
+
+                state.store(Free, std::memory_order_release);
+                state.notify_one();
+                m_Execute ^= 1;
+            }
+            glfwMakeContextCurrent(nullptr);
+        }
+
+    public:
+        RenderThread() = default;
+        RenderThread(const RenderThread&) = delete;
+        RenderThread& operator=(const RenderThread&) = delete;
+
+        ~RenderThread() { stop(); }
+
+        // Hand window's context to a new render thread, which runs init first. Call with the context current
+        // on this thread (it is released here) and returns once the render thread owns it.
+        void start(GLFWwindow* window, std::function<void()> init = {}) {
+            if (m_Thread.joinable()) return;
+            m_Window = window;
+            m_Record = m_Execute = 0;
+            m_States[0] = m_States[1] = Free;
+            m_Started = false;
+
+            glfwMakeContextCurrent(nullptr);
+            m_Thread = std::thread([this, init = std::move(init)]() mutable { loop(std::move(init)); });
+            m_Started.wait(false, std::memory_order_acquire);
+        }
+
+        // Finish the submitted frames and join; the context is current on no thread afterwards
+        void stop() {
+            if (!m_Thread.joinable()) return;
+            std::atomic<uint8_t>& state = m_States[m_Record];
+            waitWhile(state, Ready);
+            state.store(Quit, std::memory_order_release);
+            state.notify_one();
+            m_Thread.join();
+        }
+
+        bool running() const { return m_Thread.joinable(); }
+
+        // The list to record the next frame into; waits while the render thread still executes it
+        CommandList& begin() {
+            std::atomic<uint8_t>& state = m_States[m_Record];
+            if (state.load(std::memory_order_acquire) != Free) {
+                const auto start = clock::now();
+                waitWhile(state, Ready);
+                m_Stats.simulationWaitMs += since(start);
+            }
+            CommandList& list = m_Lists[m_Record];
+            m_Stats.executeMs += list.executeMs; // written by the render thread before it freed the list
+            list.executeMs = 0.0;
+            return list;
+        }
+
+        // Pass the list from begin() to the render thread
+        void submit() {
+            std::atomic<uint8_t>& state = m_States[m_Record];
+            state.store(Ready, std::memory_order_release);
+            state.notify_one();
+            m_Record ^= 1;
+            m_Stats.frames++;
+        }
+
+        // Recorder side: execute times lag by up to two frames
+        const RenderThreadStats& stats() const { return m_Stats; }
+
+        // Run a list on the calling thread, which must have the context current
+        static void execute(CommandList& list, GLFWwindow* window) {
+            const auto start = clock::now();
+            getGLState().invalidate(); // ImGui's renderer changes state behind the cache
+            for (const CommandList::Command& command : list.m_Commands) {
+                switch (command.type) {
+                case CommandList::Type::Clear: {
+                    const glm::vec4& color = list.m_Clears[command.index];
+                    glClearColor(color.r, color.g, color.b, color.a);
+                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                    break;
+                }
+                case CommandList::Type::Frame: {
+                    const FrameUniforms& frame = list.m_Frames[command.index];
+                    if (frame.viewport.x > 0.0f && frame.viewport.y > 0.0f)
+                        glViewport(0, 0, static_cast<GLsizei>(frame.viewport.x), static_cast<GLsizei>(frame.viewport.y));
+                    getFrameUniforms().upload(frame);
+                    break;
+                }
+                case CommandList::Type::Scene:
+                    list.m_Scenes[command.index]->submit();
+                    break;
+                case CommandList::Type::Run:
+                    list.m_Tasks[command.index]();
+                    break;
+                case CommandList::Type::UI:
+                    ImGui_ImplOpenGL3_RenderDrawData(&list.m_UI);
+                    getGLState().invalidate();
+                    break;
+                case CommandList::Type::Present:
+                    glfwSwapBuffers(window);
+                    break;
+                }
+            }
+            list.executeMs = since(start);
+        }
+    };
+
+} // namespace gl
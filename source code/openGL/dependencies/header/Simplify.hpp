@@ -0,0 +1,233 @@
+#pragma once
+
+#include <glm.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+// Quadric-error mesh simplification (Garland & Heckbert) using half-edge collapses onto existing
+// vertices, so the simplified index buffer can keep sharing the original vertex buffer.
+namespace gl::meshopt {
+
+    struct Quadric {
+        double a00 = 0, a01 = 0, a02 = 0, a11 = 0, a12 = 0, a22 = 0;
+        double b0 = 0, b1 = 0, b2 = 0;
+        double c = 0;
+        double w = 0;
+
+        static Quadric fromPlane(const glm::dvec3& n, double d, double weight) {
+            Quadric q;
+            q.a00 = n.x * n.x * weight; q.a01 = n.x * n.y * weight; q.a02 = n.x * n.z * weight;
+            q.a11 = n.y * n.y * weight; q.a12 = n.y * n.z * weight; q.a22 = n.z * n.z * weight;
+            q.b0 = n.x * d * weight; q.b1 = n.y * d * weight; q.b2 = n.z * d * weight;
+            q.c = d * d * weight;
+            q.w = weight;
+            return q;
+        }
+
+        Quadric& operator+=(const Quadric& o) {
+            a00 += o.a00; a01 += o.a01; a02 += o.a02; a11 += o.a11; a12 += o.a12; a22 += o.a22;
+            b0 += o.b0; b1 += o.b1; b2 += o.b2;
+            c += o.c;
+            w += o.w;
+            return *this;
+        }
+
+        // Sum of squared distances (area weighted) from p to the accumulated planes
+        double error(const glm::vec3& p) const {
+            double x = p.x, y = p.y, z = p.z;
+            double e = a00 * x * x + a11 * y * y + a22 * z * z
+                + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+            return e > 0.0 ? e : 0.0;
+        }
+
+        // Weighted mean squared distance, i.e. comparable to a squared world-space error
+        double distanceSq(const glm::vec3& p) const {
+            return w > 0.0 ? error(p) / w : 0.0;
+        }
+    };
+
+    // Simplify a triangle list towards targetIndexCount without exceeding targetError (world units).
+    // Border and UV/normal seam vertices are locked so the result never cracks.
+    // Returns the new index count written to dst (dst must hold indexCount entries);
+    // resultError receives the largest error introduced, in world units.
+    size_t simplify(unsigned int* dst, const unsigned int* indices, size_t indexCount,
+        const float* positions, size_t positionStride, size_t vertexCount,
+        size_t targetIndexCount, float targetError, float* resultError = nullptr)
+    {
+        auto position = [&](unsigned int v) {
+            const float* p = reinterpret_cast<const float*>(reinterpret_cast<const unsigned char*>(positions) + size_t(v) * positionStride);
+            return glm::vec3(p[0], p[1], p[2]);
+        };
+
+        std::vector<unsigned int> result(indices, indices + indexCount);
+        if (resultError) *resultError = 0.0f;
+
+        // Canonical vertex per position, so seams share one quadric
+        std::vector<unsigned int> canonical(vertexCount);
+        std::vector<unsigned int> wedges(vertexCount, 0);
+        {
+            struct Key {
+                float x, y, z;
+                bool operator==(const Key& o) const { return x == o.x && y == o.y && z == o.z; }
+            };
+            struct KeyHash {
+                size_t operator()(const Key& k) const {
+                    uint32_t h[3];
+                    std::memcpy(h, &k, sizeof(h));
+                    return (size_t(h[0]) * 73856093u) ^ (size_t(h[1]) * 19349663u) ^ (size_t(h[2]) * 83492791u);
+                }
+            };
+            std::unordered_map<Key, unsigned int, KeyHash> lookup(vertexCount);
+            for (size_t v = 0; v < vertexCount; v++) {
+                glm::vec3 p = position(static_cast<unsigned int>(v));
+                auto it = lookup.emplace(Key{ p.x, p.y, p.z }, static_cast<unsigned int>(v)).first;
+                canonical[v] = it->second;
+                wedges[it->second]++;
+            }
+        }
+
+        std::vector<Quadric> quadrics(vertexCount);
+        for (size_t i = 0; i + 2 < result.size(); i += 3) {
+            glm::dvec3 a = position(result[i]), b = position(result[i + 1]), c = position(result[i + 2]);
+            glm::dvec3 n = glm::cross(b - a, c - a);
+            double area = glm::length(n);
+            if (area <= 0.0) continue;
+            n /= area;
+            Quadric q = Quadric::fromPlane(n, -glm::dot(n, a), area * 0.5);
+            quadrics[canonical[result[i]]] += q;
+            quadrics[canonical[result[i + 1]]] += q;
+            quadrics[canonical[result[i + 2]]] += q;
+        }
+
+        // Lock seams and open borders
+        std::vector<char> locked(vertexCount, 0);
+        {
+            std::unordered_map<uint64_t, int> edgeUse;
+            edgeUse.reserve(result.size());
+            for (size_t i = 0; i + 2 < result.size(); i += 3) {
+                for (int k = 0; k < 3; k++) {
+                    uint64_t a = canonical[result[i + k]], b = canonical[result[i + (k + 1) % 3]];
+                    edgeUse[a < b ? (a << 32) | b : (b << 32) | a]++;
+                }
+            }
+            for (const auto& [edge, count] : edgeUse) {
+                if (count != 2) {
+                    locked[edge >> 32] = 1;
+                    locked[edge & 0xFFFFFFFFull] = 1;
+                }
+            }
+            for (size_t v = 0; v < vertexCount; v++)
+                if (wedges[v] > 1) locked[v] = 1;
+        }
+
+        const double maxCost = double(targetError) * double(targetError);
+        double worstCost = 0.0;
+
+        struct Collapse {
+            unsigned int from, to;
+            double cost;
+        };
+        std::vector<Collapse> candidates;
+        std::vector<unsigned int> remap(vertexCount);
+        std::vector<char> touched(vertexCount);
+        std::vector<unsigned int> adjacencyOffsets(vertexCount + 1);
+        std::vector<unsigned int> adjacency;
+
+        while (result.size() > targetIndexCount) {
+            const size_t triangleCount = result.size() / 3;
+
+            // Vertex -> triangle adjacency for the flip test
+            std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+            for (unsigned int v : result) adjacencyOffsets[v + 1]++;
+            for (size_t v = 0; v < vertexCount; v++) adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+            adjacency.resize(result.size());
+            {
+                std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+                for (size_t t = 0; t < triangleCount; t++)
+                    for (int k = 0; k < 3; k++)
+                        adjacency[fill[result[t * 3 + k]]++] = static_cast<unsigned int>(t);
+            }
+
+            candidates.clear();
+            for (size_t t = 0; t < triangleCount; t++) {
+                for (int k = 0; k < 3; k++) {
+                    unsigned int a = result[t * 3 + k], b = result[t * 3 + (k + 1) % 3];
+                    unsigned int ca = canonical[a], cb = canonical[b];
+                    if (ca == cb) continue;
+
+                    Quadric q = quadrics[ca];
+                    q += quadrics[cb];
+                    if (!locked[ca]) candidates.push_back({ a, b, q.distanceSq(position(b)) });
+                    if (!locked[cb]) candidates.push_back({ b, a, q.distanceSq(position(a)) });
+                }
+            }
+            if (candidates.empty()) break;
+
+            std::sort(candidates.begin(), candidates.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+            for (size_t v = 0; v < vertexCount; v++) remap[v] = static_cast<unsigned int>(v);
+            std::fill(touched.begin(), touched.end(), 0);
+
+            size_t removedEstimate = 0;
+            const size_t removeGoal = (result.size() - targetIndexCount) / 3;
+            size_t collapses = 0;
+
+            for (const auto& collapse : candidates) {
+                if (collapse.cost > maxCost || removedEstimate >= removeGoal) break;
+
+                unsigned int ca = canonical[collapse.from], cb = canonical[collapse.to];
+                if (touched[ca] || touched[cb]) continue;
+
+                // Reject collapses that flip a neighbouring triangle
+                const glm::vec3 target = position(collapse.to);
+                bool flips = false;
+                size_t shared = 0;
+                for (unsigned int a = adjacencyOffsets[collapse.from]; a < adjacencyOffsets[collapse.from + 1] && !flips; a++) {
+                    const unsigned int* tri = &result[size_t(adjacency[a]) * 3];
+                    if (canonical[tri[0]] == cb || canonical[tri[1]] == cb || canonical[tri[2]] == cb) {
+                        shared++;
+                        continue;
+                    }
+
+                    glm::vec3 p[3] = { position(tri[0]), position(tri[1]), position(tri[2]) };
+                    glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    for (int k = 0; k < 3; k++)
+                        if (tri[k] == collapse.from) p[k] = target;
+                    glm::vec3 after = glm::cross(p[1] - p[0], p[2] - p[0]);
+                    if (glm::dot(before, after) <= 0.0f) flips = true;
+                }
+                if (flips) continue;
+
+                remap[collapse.from] = collapse.to;
+                touched[ca] = touched[cb] = 1;
+                quadrics[cb] += quadrics[ca];
+                worstCost = std::max(worstCost, collapse.cost);
+                removedEstimate += shared;
+                collapses++;
+            }
+
+            if (collapses == 0) break;
+
+            size_t write = 0;
+            for (size_t i = 0; i + 2 < result.size(); i += 3) {
+                unsigned int a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+                if (canonical[a] == canonical[b] || canonical[b] == canonical[c] || canonical[a] == canonical[c]) continue;
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+        }
+
+        std::memcpy(dst, result.data(), result.size() * sizeof(unsigned int));
+        if (resultError) *resultError = static_cast<float>(std::sqrt(worstCost));
+        return result.size();
+    }
+
+} // namespace gl::meshopt
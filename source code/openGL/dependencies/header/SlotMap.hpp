@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace gl {
+
+    // Stable reference into a SlotMap: slot index plus the generation it was issued for. A default
+    // handle is never valid.
+    struct SlotHandle {
+        uint32_t index = 0;
+        uint32_t generation = 0;
+
+        bool operator==(const SlotHandle&) const = default;
+        explicit operator bool() const { return generation != 0; }
+    };
+
+    // ============ SLOT MAP ============
+    // O(1) insert, erase and lookup by handle over values kept densely packed for iteration. Erasing moves
+    // the last value into the gap, so iteration order is not insertion order. Each slot's generation is
+    // bumped when its value is erased; a handle whose generation no longer matches is stale and get()
+    // returns nullptr instead of someone else's value. Slots are reused through a free list.
+    template <typename T>
+    class SlotMap {
+    private:
+        struct Slot {
+            uint32_t dense = 0;      // index into m_Values while occupied, next free slot otherwise
+            uint32_t generation = 1; // never 0, so default Handles stay invalid
+        };
+
+        static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+        std::vector<T> m_Values;
+        std::vector<uint32_t> m_DenseToSlot;
+        std::vector<Slot> m_Slots;
+        uint32_t m_FreeList = NO_SLOT;
+
+    public:
+        SlotHandle insert(T value) {
+            uint32_t index;
+            if (m_FreeList != NO_SLOT) {
+                index = m_FreeList;
+                m_FreeList = m_Slots[index].dense;
+            }
+            else {
+                index = static_cast<uint32_t>(m_Slots.size());
+                m_Slots.emplace_back();
+            }
+            m_Slots[index].dense = static_cast<uint32_t>(m_Values.size());
+            m_Values.push_back(std::move(value));
+            m_DenseToSlot.push_back(index);
+            return { index, m_Slots[index].generation };
+        }
+
+        // False if handle is stale
+        bool erase(SlotHandle handle) {
+            if (!contains(handle)) return false;
+            Slot& slot = m_Slots[handle.index];
+            const uint32_t dense = slot.dense;
+            const uint32_t last = static_cast<uint32_t>(m_Values.size() - 1);
+            if (dense != last) {
+                m_Values[dense] = std::move(m_Values[last]);
+                m_DenseToSlot[dense] = m_DenseToSlot[last];
+                m_Slots[m_DenseToSlot[dense]].dense = dense;
+            }
+            m_Values.pop_back();
+            m_DenseToSlot.pop_back();
+
+            if (++slot.generation == 0) slot.generation = 1;
+            slot.dense = m_FreeList;
+            m_FreeList = handle.index;
+            return true;
+        }
+
+        bool contains(SlotHandle handle) const {
+            return handle.generation != 0 && handle.index < m_Slots.size() && m_Slots[handle.index].generation == handle.generation;
+        }
+
+        // nullptr if handle is stale
+        T* get(SlotHandle handle) { return contains(handle) ? &m_Values[m_Slots[handle.index].dense] : nullptr; }
+        const T* get(SlotHandle handle) const { return contains(handle) ? &m_Values[m_Slots[handle.index].dense] : nullptr; }
+
+        // Handle of the value at dense position i, for iteration
+        SlotHandle handleAt(size_t i) const {
+            const uint32_t index = m_DenseToSlot[i];
+            return { index, m_Slots[index].generation };
+        }
+
+        void clear() {
+            while (!m_Values.empty()) erase(handleAt(m_Values.size() - 1));
+        }
+
+        size_t size() const { return m_Values.size(); }
+        bool empty() const { return m_Values.empty(); }
+        const std::vector<T>& values() const { return m_Values; }
+
+        auto begin() { return m_Values.begin(); }
+        auto end() { return m_Values.end(); }
+        auto begin() const { return m_Values.begin(); }
+        auto end() const { return m_Values.end(); }
+    };
+
+} // namespace gl
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <GLState.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Regions of a persistently mapped stream; a region is reused only after the GPU has passed its fence
+#ifndef GL_STREAM_BUFFER_REGIONS
+#define GL_STREAM_BUFFER_REGIONS 3
+#endif
+
+namespace gl {
+
+    // ============ STREAM BUFFER ============
+    // Ring of per-frame regions for data written by the CPU every frame (instance matrices, indirect
+    // commands, uniform blocks). With GL_ARB_buffer_storage the buffer is mapped once, persistently, and
+    // allocations are pointers straight into it: nothing is copied by the driver and nothing waits unless
+    // the GPU is still reading the region being reused, which its fence tells. Coherent maps need no flush;
+    // explicit ones flush what was written in flush(). On GL 3.3 drivers the writes go to a CPU copy and
+    // flush() uploads them with glBufferSubData into storage that is orphaned at each region change.
+    //
+    // Allocations stay valid until the next allocate() or beginFrame() on the same stream, either of which
+    // may move to another region: issue the draws that read one before making the next.
+    class StreamBuffer {
+    public:
+        struct Allocation {
+            void* data = nullptr;
+            size_t offset = 0; // in the buffer, for attribute pointers, indirect offsets and glBindBufferRange
+            size_t size = 0;
+
+            explicit operator bool() const { return data != nullptr; }
+        };
+
+        struct Stats {
+            size_t bytes = 0;         // allocated
+            size_t regions = 0;       // region changes
+            size_t waits = 0;         // region changes that had to wait for the GPU
+            double waitMs = 0.0;
+            size_t reallocations = 0; // growth for allocations larger than a region
+        };
+
+    private:
+        static constexpr size_t REGION_ALIGNMENT = 256; // covers GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT on common hardware
+
+        GLenum m_Target;
+        bool m_Coherent;
+        GLuint m_Buffer = 0;
+        size_t m_RegionSize;
+        bool m_Persistent = false;
+        unsigned char* m_Mapped = nullptr;    // persistent: the whole buffer
+        std::vector<unsigned char> m_Staging; // fallback: the current region
+        GLsync m_Fences[GL_STREAM_BUFFER_REGIONS] = {};
+        size_t m_Region = 0;
+        size_t m_Head = 0;    // in the current region
+        size_t m_Flushed = 0; // written up to here is already visible to GL
+        uint64_t m_Generation = 0;
+        Stats m_Stats;
+
+        size_t regionBase() const { return m_Persistent ? m_Region * m_RegionSize : 0; }
+
+        void create() {
+            m_Persistent = persistentSupported();
+            glGenBuffers(1, &m_Buffer);
+            getGLState().bindBuffer(m_Target, m_Buffer);
+
+            if (m_Persistent) {
+                const size_t bytes = m_RegionSize * GL_STREAM_BUFFER_REGIONS;
+                GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | (m_Coherent ? GL_MAP_COHERENT_BIT : 0);
+                glBufferStorage(m_Target, bytes, nullptr, flags);
+                if (!m_Coherent) flags |= GL_MAP_FLUSH_EXPLICIT_BIT;
+                m_Mapped = static_cast<unsigned char*>(glMapBufferRange(m_Target, 0, bytes, flags));
+                if (!m_Mapped) {
+                    getGLState().deleteBuffers(1, &m_Buffer);
+                    glGenBuffers(1, &m_Buffer);
+                    getGLState().bindBuffer(m_Target, m_Buffer);
+                    m_Persistent = false;
+                }
+            }
+            if (!m_Persistent) {
+                glBufferData(m_Target, m_RegionSize, nullptr, GL_STREAM_DRAW);
+                m_Staging.resize(m_RegionSize);
+            }
+            m_Region = 0;
+            m_Head = m_Flushed = 0;
+            m_Generation++;
+        }
+
+        void destroy() {
+            for (auto& fence : m_Fences) {
+                if (fence) glDeleteSync(fence);
+                fence = nullptr;
+            }
+            if (m_Mapped) {
+                getGLState().bindBuffer(m_Target, m_Buffer);
+                glUnmapBuffer(m_Target);
+                m_Mapped = nullptr;
+            }
+            if (m_Buffer) getGLState().deleteBuffers(1, &m_Buffer);
+            m_Buffer = 0;
+            m_Staging.clear();
+        }
+
+        void waitFence(GLsync& fence) {
+            if (!fence) return;
+            GLenum result = glClientWaitSync(fence, 0, 0);
+            if (result == GL_TIMEOUT_EXPIRED) {
+                const auto start = std::chrono::steady_clock::now();
+                do result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+                while (result == GL_TIMEOUT_EXPIRED);
+                m_Stats.waits++;
+                m_Stats.waitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            }
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        // Fence the region just written and move on to the next one once the GPU is done with it
+        void nextRegion() {
+            flush();
+            m_Stats.regions++;
+            if (m_Persistent) {
+                m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                m_Region = (m_Region + 1) % GL_STREAM_BUFFER_REGIONS;
+                waitFence(m_Fences[m_Region]);
+            }
+            else {
+                getGLState().bindBuffer(m_Target, m_Buffer);
+                glBufferData(m_Target, m_RegionSize, nullptr, GL_STREAM_DRAW); // orphan
+            }
+            m_Head = m_Flushed = 0;
+        }
+
+        // Regions too small for one allocation: wait for everything, then rebuild larger
+        void grow(size_t size) {
+            flush();
+            if (m_Persistent) {
+                for (auto& fence : m_Fences) waitFence(fence);
+            }
+            destroy();
+            while (m_RegionSize < size) m_RegionSize *= 2;
+            create();
+            m_Stats.reallocations++;
+        }
+
+    public:
+        // regionSize is per frame; the persistent buffer holds GL_STREAM_BUFFER_REGIONS of them.
+        // Created on first use, so construction needs no context.
+        StreamBuffer(GLenum target, size_t regionSize, bool coherent = true)
+            : m_Target(target), m_Coherent(coherent),
+            m_RegionSize((regionSize + REGION_ALIGNMENT - 1) / REGION_ALIGNMENT * REGION_ALIGNMENT) {}
+
+        StreamBuffer(const StreamBuffer&) = delete;
+        StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+        ~StreamBuffer() { destroy(); }
+
+        static bool persistentSupported() {
+            return GLEW_ARB_buffer_storage && glBufferStorage != nullptr;
+        }
+
+        // Start writing the next frame's region, if anything was written since the last one
+        void beginFrame() {
+            if (m_Buffer && m_Head > 0) nextRegion();
+        }
+
+        // size bytes at an offset aligned to alignment (a power of two)
+        Allocation allocate(size_t size, size_t alignment = 16) {
+            if (!m_Buffer) create();
+
+            size_t start = (m_Head + alignment - 1) & ~(alignment - 1);
+            if (start + size > m_RegionSize) {
+                if (size > m_RegionSize) grow(size);
+                else nextRegion();
+                start = 0;
+            }
+            m_Head = start + size;
+            m_Stats.bytes += size;
+
+            unsigned char* base = m_Persistent ? m_Mapped + regionBase() : m_Staging.data();
+            return { base + start, regionBase() + start, size };
+        }
+
+        // Make what was written since the last flush visible to GL; call before the draws that read it.
+        // Free for coherent persistent maps.
+        void flush() {
+            if (!m_Buffer || m_Flushed >= m_Head) return;
+            if (m_Persistent) {
+                if (!m_Coherent) {
+                    getGLState().bindBuffer(m_Target, m_Buffer);
+                    glFlushMappedBufferRange(m_Target, regionBase() + m_Flushed, m_Head - m_Flushed);
+                }
+            }
+            else {
+                getGLState().bindBuffer(m_Target, m_Buffer);
+                glBufferSubData(m_Target, m_Flushed, m_Head - m_Flushed, m_Staging.data() + m_Flushed);
+            }
+            m_Flushed = m_Head;
+        }
+
+        // Allocate, copy and flush in one go
+        Allocation write(const void* data, size_t size, size_t alignment = 16) {
+            Allocation allocation = allocate(size, alignment);
+            if (size) std::memcpy(allocation.data, data, size);
+            flush();
+            return allocation;
+        }
+
+        GLuint buffer() const { return m_Buffer; }
+
+        GLenum target() const { return m_Target; }
+
+        // Changes whenever the buffer is recreated, so VAOs pointing into it know to re-point
+        uint64_t generation() const { return m_Generation; }
+
+        bool persistent() const { return m_Persistent; }
+
+        size_t regionSize() const { return m_RegionSize; }
+
+        const Stats& stats() const { return m_Stats; }
+
+        void resetStats() { m_Stats = Stats(); }
+    };
+
+} // namespace gl
@@ -2,6 +2,7 @@
 
 #include <Utils.hpp>
 #include <Window.hpp>
+#include <ImageDecoder.hpp>
 
 namespace gl {
 
@@ -20,7 +21,7 @@ namespace gl {
                 throw std::runtime_error("Failed to load texture: " + path);
 
             glGenTextures(1, &m_Texture);
-            glBindTexture(GL_TEXTURE_2D, m_Texture);
+            getGLState().bindTexture(GL_TEXTURE_2D, m_Texture);
 
             GLenum format;
             switch (m_NrChannels) {
@@ -66,7 +67,7 @@ namespace gl {
                 throw std::runtime_error("Texture data is null");
 
             glGenTextures(1, &m_Texture);
-            glBindTexture(GL_TEXTURE_2D, m_Texture);
+            getGLState().bindTexture(GL_TEXTURE_2D, m_Texture);
 
             GLenum format;
             switch (channels) {
@@ -99,12 +100,12 @@ namespace gl {
         }
 
         void bind(GLenum textureUnit = GL_TEXTURE0) const {
-            glActiveTexture(textureUnit);
-            glBindTexture(GL_TEXTURE_2D, m_Texture);
+            getGLState().activeTexture(textureUnit - GL_TEXTURE0);
+            getGLState().bindTexture(GL_TEXTURE_2D, m_Texture);
         }
 
         ~texture2D() {
-            glDeleteTextures(1, &m_Texture);
+            getGLState().deleteTextures(1, &m_Texture);
         }
 
         GLuint getTexture() const { return m_Texture; }
@@ -129,7 +130,7 @@ namespace gl {
             m_Layers = static_cast<int>(textures.size());
 
             glGenTextures(1, &m_Texture);
-            glBindTexture(GL_TEXTURE_2D_ARRAY, m_Texture);
+            getGLState().bindTexture(GL_TEXTURE_2D_ARRAY, m_Texture);
 
             // Allocate empty array storage
             glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, m_Width, m_Height, m_Layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
@@ -150,11 +151,11 @@ namespace gl {
         }
 
         void bind(GLenum textureUnit = GL_TEXTURE0) const {
-            glActiveTexture(textureUnit);
-            glBindTexture(GL_TEXTURE_2D_ARRAY, m_Texture);
+            getGLState().activeTexture(textureUnit - GL_TEXTURE0);
+            getGLState().bindTexture(GL_TEXTURE_2D_ARRAY, m_Texture);
         }
 
-        ~texture2DArray() { glDeleteTextures(1, &m_Texture); }
+        ~texture2DArray() { getGLState().deleteTextures(1, &m_Texture); }
 
         int layers() const { return m_Layers; }
     };
@@ -189,7 +190,7 @@ namespace gl {
             }
 
             glGenTextures(1, &m_Texture);
-            glBindTexture(GL_TEXTURE_3D, m_Texture);
+            getGLState().bindTexture(GL_TEXTURE_3D, m_Texture);
 
             glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, width, height, static_cast<GLsizei>(paths.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE, dataAll.data());
 
@@ -221,7 +222,7 @@ namespace gl {
             }
 
             glGenTextures(1, &m_Texture);
-            glBindTexture(GL_TEXTURE_3D, m_Texture);
+            getGLState().bindTexture(GL_TEXTURE_3D, m_Texture);
 
             glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, width, height, static_cast<GLsizei>(size), 0, GL_RGBA, GL_UNSIGNED_BYTE, dataAll.data());
 
@@ -255,7 +256,7 @@ namespace gl {
             }
 
             glGenTextures(1, &m_Texture);
-            glBindTexture(GL_TEXTURE_3D, m_Texture);
+            getGLState().bindTexture(GL_TEXTURE_3D, m_Texture);
 
             glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, width, height, static_cast<GLsizei>(paths.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE, dataAll.data());
 
@@ -287,7 +288,7 @@ namespace gl {
             }
 
             glGenTextures(1, &m_Texture);
-            glBindTexture(GL_TEXTURE_3D, m_Texture);
+            getGLState().bindTexture(GL_TEXTURE_3D, m_Texture);
 
             glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, width, height, static_cast<GLsizei>(size), 0, GL_RGBA, GL_UNSIGNED_BYTE, dataAll.data());
 
@@ -299,16 +300,52 @@ namespace gl {
         }
 
         void bind(GLenum textureUnit = GL_TEXTURE0) {
-            glActiveTexture(textureUnit);
-            glBindTexture(GL_TEXTURE_3D, m_Texture);
-            glUniform1i(m_Loc, textureUnit - GL_TEXTURE0);
+            getGLState().activeTexture(textureUnit - GL_TEXTURE0);
+            getGLState().bindTexture(GL_TEXTURE_3D, m_Texture);
+            getGLState().uniform1i(m_Loc, textureUnit - GL_TEXTURE0);
         }
 
         ~texture3D() {
-            glDeleteTextures(1, &m_Texture);
+            getGLState().deleteTextures(1, &m_Texture);
         }
 
         GLuint getTexture() const { return m_Texture; }
     };
 
+    // ============ EMBEDDED TEXTURE ============
+    // GL texture made from an image decoded out of a model file; owned by the model's MeshAsset
+    struct EmbeddedTexture {
+        GLuint id = 0;
+        int width = 0, height = 0;
+        std::vector<std::string> slots;
+
+        explicit EmbeddedTexture(const DecodedImage& image)
+            : width(image.width), height(image.height), slots(image.slots)
+        {
+            static const GLenum formats[] = { GL_RED, GL_RED, GL_RG, GL_RGB, GL_RGBA };
+            const GLenum format = formats[image.channels >= 1 && image.channels <= 4 ? image.channels : 4];
+
+            glGenTextures(1, &id);
+            getGLState().bindTexture(GL_TEXTURE_2D, id);
+
+            // Rows of 1- and 3-channel images are not 4-byte aligned
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+            glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, image.pixels.get());
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glGenerateMipmap(GL_TEXTURE_2D);
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        }
+
+        EmbeddedTexture(const EmbeddedTexture&) = delete;
+        EmbeddedTexture& operator=(const EmbeddedTexture&) = delete;
+
+        ~EmbeddedTexture() {
+            if (id) getGLState().deleteTextures(1, &id);
+        }
+    };
+
 }
\ No newline at end of file
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace gl {
+
+    namespace detail {
+        inline thread_local bool poolWorker = false;
+    }
+
+    // ============ TASK GROUP ============
+    // A batch of indexed work items started on the pool with ThreadPool::launch
+    class TaskGroup {
+    private:
+        std::atomic<size_t> m_Next{ 0 };
+        std::atomic<size_t> m_Done{ 0 };
+        size_t m_Count;
+        std::function<void(size_t)> m_Func;
+        std::mutex m_Mutex;
+        std::condition_variable m_Finished;
+
+    public:
+        TaskGroup(size_t count, std::function<void(size_t)> func)
+            : m_Count(count), m_Func(std::move(func))
+        {
+        }
+
+        // Run items on this thread until none are left to start
+        void help() {
+            for (;;) {
+                size_t i = m_Next.fetch_add(1);
+                if (i >= m_Count) return;
+                m_Func(i);
+                if (m_Done.fetch_add(1) + 1 == m_Count) {
+                    std::lock_guard<std::mutex> lock(m_Mutex);
+                    m_Finished.notify_all();
+                }
+            }
+        }
+
+        bool finished() const { return m_Done.load() == m_Count; }
+
+        // Block until every item has run. Pool workers help first so nested waits cannot starve the pool;
+        // other threads (the GL thread) never run the items themselves.
+        void wait() {
+            if (detail::poolWorker) help();
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_Finished.wait(lock, [this] { return finished(); });
+        }
+    };
+
+    // ============ THREAD POOL ============
+    class ThreadPool {
+    private:
+        std::vector<std::thread> m_Workers;
+        std::deque<std::function<void()>> m_Tasks;
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        bool m_Stop = false;
+
+        void workerLoop() {
+            detail::poolWorker = true;
+            for (;;) {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(m_Mutex);
+                    m_Condition.wait(lock, [this] { return m_Stop || !m_Tasks.empty(); });
+                    if (m_Stop && m_Tasks.empty()) return;
+                    task = std::move(m_Tasks.front());
+                    m_Tasks.pop_front();
+                }
+                task();
+            }
+        }
+
+        void enqueue(std::function<void()> task) {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Tasks.push_back(std::move(task));
+            }
+            m_Condition.notify_one();
+        }
+
+    public:
+        explicit ThreadPool(unsigned threadCount = std::max(1u, std::thread::hardware_concurrency() - 1)) {
+            threadCount = std::max(1u, threadCount);
+            m_Workers.reserve(threadCount);
+            for (unsigned i = 0; i < threadCount; i++)
+                m_Workers.emplace_back([this] { workerLoop(); });
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Stop = true;
+            }
+            m_Condition.notify_all();
+            for (auto& worker : m_Workers) worker.join();
+        }
+
+        size_t size() const { return m_Workers.size(); }
+
+        template <class F>
+        auto submit(F&& func) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+            using Result = std::invoke_result_t<std::decay_t<F>>;
+            auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(func));
+            std::future<Result> future = task->get_future();
+            enqueue([task]() { (*task)(); });
+            return future;
+        }
+
+        // Start func(i) for i in [0, count) on up to maxHelpers workers and return without waiting.
+        // The caller must wait() on the group before anything func references goes away.
+        std::shared_ptr<TaskGroup> launch(size_t count, const std::function<void(size_t)>& func, size_t maxHelpers = SIZE_MAX) {
+            auto group = std::make_shared<TaskGroup>(count, func);
+            size_t helpers = std::min({ count, maxHelpers, m_Workers.size() });
+            for (size_t h = 0; h < helpers; h++)
+                enqueue([group]() { group->help(); });
+            return group;
+        }
+
+        // Run func(i) for i in [0, count). The calling thread takes part, and it only ever waits
+        // on indices that are already running, so this is safe to call from inside a pool task.
+        void parallelFor(size_t count, const std::function<void(size_t)>& func) {
+            if (count == 0) return;
+            if (count == 1) {
+                func(0);
+                return;
+            }
+
+            auto group = launch(count, func, count - 1);
+            group->help();
+            group->wait();
+        }
+    };
+
+    ThreadPool& getThreadPool() {
+        static ThreadPool pool;
+        return pool;
+    }
+
+} // namespace gl
@@ -8,9 +8,11 @@
 #include <gtc/type_ptr.hpp> 
 
 #include <Window.hpp>
+#include <GLState.hpp>
 
 #include <fstream>
 #include <filesystem>
+#include <memory>
 #include <string>
 #include <iostream>
 #include <stdexcept>
@@ -23,25 +25,30 @@
 #define GL_VIEW_DISTANCE 10000.0f
 #endif // 
 
+// Uniform buffer binding point of the shared per-frame "Frame" block (see FrameUniforms.hpp)
+#ifndef GL_FRAME_UNIFORM_BINDING
+#define GL_FRAME_UNIFORM_BINDING 0
+#endif
+
 
 namespace gl {
 
     void terminate(GLuint VAO, GLuint VBO, GLuint shaderProgram) {
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
-        glDeleteProgram(shaderProgram);
+        getGLState().deleteVertexArrays(1, &VAO);
+        getGLState().deleteBuffers(1, &VBO);
+        getGLState().deleteProgram(shaderProgram);
 
         glfwTerminate();
     }
 
     void bindVertexArray(GLuint& VAO) {
         glGenVertexArrays(1, &VAO);
-        glBindVertexArray(VAO);
+        getGLState().bindVertexArray(VAO);
     }
 
     void bindVertexBuffer(GLuint& VBO, const GLfloat* vertices, size_t size) {
         glGenBuffers(1, &VBO);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        getGLState().bindBuffer(GL_ARRAY_BUFFER, VBO);
         glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
     }
 
@@ -71,7 +78,7 @@ namespace gl {
                 return;
             }
             glGenTextures(1, &m_Texture);
-            glBindTexture(GL_TEXTURE_2D, m_Texture);
+            getGLState().bindTexture(GL_TEXTURE_2D, m_Texture);
 
             GLenum format = m_NrChannels == 3 ? GL_RGB : GL_RGBA;
             glTexImage2D(GL_TEXTURE_2D, 0, format, m_Width, m_Height, 0, format, GL_UNSIGNED_BYTE, m_Data);
@@ -97,7 +104,7 @@ namespace gl {
             stbi_set_flip_vertically_on_load(true);
 
             glGenTextures(1, &m_Texture);
-            glBindTexture(GL_TEXTURE_2D, m_Texture);
+            getGLState().bindTexture(GL_TEXTURE_2D, m_Texture);
 
             GLenum format = GL_RGBA;
             if (channels == 3) format = GL_RGB;
@@ -113,12 +120,12 @@ namespace gl {
         }
 
         void bind(GLenum unit) const {
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(GL_TEXTURE_2D, m_Texture);
+            getGLState().activeTexture(unit);
+            getGLState().bindTexture(GL_TEXTURE_2D, m_Texture);
         }
 
         ~texture2D() {
-            glDeleteTextures(1, &m_Texture);
+            getGLState().deleteTextures(1, &m_Texture);
         }
 
         GLuint getTexture() const { return m_Texture; }
@@ -158,7 +165,7 @@ namespace gl {
 
             // Generate texture
             glGenTextures(1, &m_Texture);
-            glBindTexture(GL_TEXTURE_2D_ARRAY, m_Texture);
+            getGLState().bindTexture(GL_TEXTURE_2D_ARRAY, m_Texture);
 
             // Allocate storage for the array
             glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, format, m_Width, m_Height, m_Layers, 0, format, GL_UNSIGNED_BYTE, nullptr);
@@ -191,8 +198,8 @@ namespace gl {
         }
 
         void bind(GLenum textureUnit = GL_TEXTURE0) const {
-            glActiveTexture(textureUnit);
-            glBindTexture(GL_TEXTURE_2D_ARRAY, m_Texture);
+            getGLState().activeTexture(textureUnit - GL_TEXTURE0);
+            getGLState().bindTexture(GL_TEXTURE_2D_ARRAY, m_Texture);
         }
 
         GLuint id() const { return m_Texture; }
@@ -201,7 +208,7 @@ namespace gl {
         int layers() const { return m_Layers; }
 
         ~texture2DArray() {
-            if (m_Texture) glDeleteTextures(1, &m_Texture);
+            if (m_Texture) getGLState().deleteTextures(1, &m_Texture);
         }
     };
 
@@ -235,7 +242,7 @@ namespace gl {
             }
 
             glGenTextures(1, &m_Texture);
-            glBindTexture(GL_TEXTURE_3D, m_Texture);
+            getGLState().bindTexture(GL_TEXTURE_3D, m_Texture);
 
             glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, width, height, static_cast<GLsizei>(paths.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE, dataAll.data());
 
@@ -267,7 +274,7 @@ namespace gl {
             }
 
             glGenTextures(1, &m_Texture);
-            glBindTexture(GL_TEXTURE_3D, m_Texture);
+            getGLState().bindTexture(GL_TEXTURE_3D, m_Texture);
 
             glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, width, height, static_cast<GLsizei>(size), 0, GL_RGBA, GL_UNSIGNED_BYTE, dataAll.data());
 
@@ -301,7 +308,7 @@ namespace gl {
             }
 
             glGenTextures(1, &m_Texture);
-            glBindTexture(GL_TEXTURE_3D, m_Texture);
+            getGLState().bindTexture(GL_TEXTURE_3D, m_Texture);
 
             glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, width, height, static_cast<GLsizei>(paths.size()), 0, GL_RGBA, GL_UNSIGNED_BYTE, dataAll.data());
 
@@ -333,7 +340,7 @@ namespace gl {
             }
 
             glGenTextures(1, &m_Texture);
-            glBindTexture(GL_TEXTURE_3D, m_Texture);
+            getGLState().bindTexture(GL_TEXTURE_3D, m_Texture);
 
             glTexImage3D(GL_TEXTURE_3D, 0, GL_RGBA, width, height, static_cast<GLsizei>(size), 0, GL_RGBA, GL_UNSIGNED_BYTE, dataAll.data());
 
@@ -345,13 +352,13 @@ namespace gl {
         }
 
         void bind(GLenum textureUnit = GL_TEXTURE0) {
-            glActiveTexture(textureUnit);
-            glBindTexture(GL_TEXTURE_3D, m_Texture);
-            glUniform1i(m_Loc, textureUnit - GL_TEXTURE0);
+            getGLState().activeTexture(textureUnit - GL_TEXTURE0);
+            getGLState().bindTexture(GL_TEXTURE_3D, m_Texture);
+            getGLState().uniform1i(m_Loc, textureUnit - GL_TEXTURE0);
         }
 
         ~texture3D() {
-            glDeleteTextures(1, &m_Texture);
+            getGLState().deleteTextures(1, &m_Texture);
         }
 
         GLuint getTexture() const { return m_Texture; }
@@ -359,8 +366,8 @@ namespace gl {
 
     void bindTexture(GLsizei n, GLuint& texture, GLenum mode) {
         glGenTextures(n, &texture);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(mode, texture);
+        getGLState().activeTexture(0);
+        getGLState().bindTexture(mode, texture);
     }
 
     void generateTexture(GLenum target, GLint level, GLint internalFormat, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, unsigned char* data) {
@@ -477,7 +484,8 @@ namespace gl {
 
                 std::string typeName =
                     (type == GL_VERTEX_SHADER) ? "VERTEX" :
-                    (type == GL_FRAGMENT_SHADER) ? "FRAGMENT" : "UNKNOWN";
+                    (type == GL_FRAGMENT_SHADER) ? "FRAGMENT" :
+                    (type == GL_COMPUTE_SHADER) ? "COMPUTE" : "UNKNOWN";
 
                 throw std::runtime_error(
                     "Compilation failed (" + typeName + "):\n" +
@@ -502,6 +510,22 @@ namespace gl {
             glDeleteShader(vertex);
             glDeleteShader(fragment);
 
+            return checkProgram(program);
+        }
+
+        GLuint createComputeProgram(const std::string& computeShaderPath) {
+            GLuint compute = compileShader(computeShaderPath, GL_COMPUTE_SHADER);
+
+            GLuint program = glCreateProgram();
+            glAttachShader(program, compute);
+            glLinkProgram(program);
+            glDeleteShader(compute);
+
+            return checkProgram(program);
+        }
+
+        GLuint checkProgram(GLuint program) {
+
             GLint success = 0;
             glGetProgramiv(program, GL_LINK_STATUS, &success);
 
@@ -520,14 +544,31 @@ namespace gl {
             return program;
         }
 
+        struct ComputeTag {};
+
+        shader(ComputeTag, const char* computeShaderName) {
+            m_ShaderProgram = createComputeProgram(computeShaderName);
+            m_Uniforms = getShaderUniforms(m_ShaderProgram);
+            glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &m_MaxTexUnits);
+        }
+
     public:
         shader(const char* vertexShaderName, const char* fragmentShaderName) {
             m_ShaderProgram = createProgram(vertexShaderName, fragmentShaderName);
             m_Uniforms = getShaderUniforms(m_ShaderProgram);
             glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &m_MaxTexUnits);
+
+            // Per-frame camera data comes from the shared block, not from uniforms of this program
+            GLuint frameBlock = glGetUniformBlockIndex(m_ShaderProgram, "Frame");
+            if (frameBlock != GL_INVALID_INDEX) glUniformBlockBinding(m_ShaderProgram, frameBlock, GL_FRAME_UNIFORM_BINDING);
+        }
+
+        // Compute program (GL 4.3 / ARB_compute_shader); throws like the constructor if it does not compile
+        static std::shared_ptr<shader> compute(const char* computeShaderName) {
+            return std::shared_ptr<shader>(new shader(ComputeTag{}, computeShaderName));
         }
 
-        void useProgram() const { glUseProgram(m_ShaderProgram); }
+        void useProgram() const { getGLState().useProgram(m_ShaderProgram); }
 
         GLuint getProgram() const { return m_ShaderProgram; }
 
@@ -561,7 +602,7 @@ namespace gl {
         void setUniform1i(const std::string& name, int value) {
             GLint loc = getUniformLoc(name);
             if (loc >= 0)
-                glUniform1i(loc, value);
+                getGLState().uniform1i(loc, value);
         }
 
         void setUniform1f(const std::string& name, float value) {
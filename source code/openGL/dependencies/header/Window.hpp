@@ -37,7 +37,8 @@ namespace gl {
 
 			gl::window* self = static_cast<gl::window*>(glfwGetWindowUserPointer(window));
 
-			glViewport(0, 0, width, height);
+			// With a RenderThread the context lives on another thread, which sets the viewport from FrameUniforms
+			if (glfwGetCurrentContext() == window) glViewport(0, 0, width, height);
 
 			self->m_WindowCallBack.width = width;
 			self->m_WindowCallBack.height = height;
@@ -225,6 +226,7 @@ namespace gl {
 		keyCallBack m_KeyCallBack;
 		cursorCallBack m_CursorCallBack;
 		UI m_UI;
+		bool m_ContextReleased = false;
 	public:	
 
 		window() = delete;
@@ -276,7 +278,7 @@ namespace gl {
 		}
 
 		bool ifRun() {
-			glfwMakeContextCurrent(m_WindowCallBack.window);
+			if (!m_ContextReleased && glfwGetCurrentContext() != m_WindowCallBack.window) glfwMakeContextCurrent(m_WindowCallBack.window);
 			glfwPollEvents();
 
 			static double lastFrame = 0.0;
@@ -288,12 +290,30 @@ namespace gl {
 				|| glfwWindowShouldClose(m_WindowCallBack.window));
 		}
 
-		void imguiNewFrame() {
-			ImGui_ImplOpenGL3_NewFrame();
+		// renderer = false skips the GL backend, for frames whose draw data a RenderThread renders
+		void imguiNewFrame(bool renderer = true) {
+			if (renderer) ImGui_ImplOpenGL3_NewFrame();
 			ImGui_ImplGlfw_NewFrame();
 			ImGui::NewFrame();
 		}
 
+		// Hand the context to another thread (RenderThread::start) and stop ifRun from taking it back
+		void releaseContext() {
+			glfwMakeContextCurrent(nullptr);
+			m_ContextReleased = true;
+		}
+
+		void acquireContext() {
+			glfwMakeContextCurrent(m_WindowCallBack.window);
+			m_ContextReleased = false;
+		}
+
+		// Finish the ImGui frame without drawing it; the result is valid until the next imguiNewFrame
+		ImDrawData* imguiDrawData() {
+			ImGui::Render();
+			return ImGui::GetDrawData();
+		}
+
 		void imguiRender() {
 			ImGui::Render();
 			ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -0,0 +1,61 @@
+#version 430 core
+
+// Hi-Z occlusion test of world-space boxes (gl::HiZCuller). Same test as gl::hiZOccluded in Occlusion.hpp;
+// keep the two in sync.
+layout(local_size_x = 64) in;
+
+struct Bounds
+{
+    vec4 minBounds; // w unused
+    vec4 maxBounds;
+};
+
+layout(std430, binding = 0) readonly buffer BoundsBuffer { Bounds bounds[]; };
+layout(std430, binding = 1) writeonly buffer VisibilityBuffer { uint visible[]; };
+
+uniform sampler2D hiZ;        // farthest depth per texel, full mip chain
+uniform mat4 viewProjection;  // of the frame the pyramid was captured in
+uniform vec2 size;            // level 0
+uniform int levels;
+uniform int count;
+
+bool occluded(vec3 minB, vec3 maxB)
+{
+    vec2 lo = vec2(1e30);
+    vec2 hi = vec2(-1e30);
+    float nearest = 1.0;
+    for (int i = 0; i < 8; i++) {
+        vec3 corner = vec3((i & 1) != 0 ? maxB.x : minB.x, (i & 2) != 0 ? maxB.y : minB.y, (i & 4) != 0 ? maxB.z : minB.z);
+        vec4 p = viewProjection * vec4(corner, 1.0);
+        if (p.w <= 1e-5) return false; // crosses the camera plane
+        vec3 ndc = p.xyz / p.w;
+        lo = min(lo, ndc.xy);
+        hi = max(hi, ndc.xy);
+        nearest = min(nearest, ndc.z * 0.5 + 0.5);
+    }
+    if (nearest <= 0.0 || hi.x < -1.0 || hi.y < -1.0 || lo.x > 1.0 || lo.y > 1.0) return false;
+
+    // Rectangle in level-0 texels; shifting right by the level gives the texels covering it at that level
+    ivec2 levelSize0 = ivec2(size);
+    ivec2 last = levelSize0 - 1;
+    ivec2 p0 = clamp(ivec2(floor((lo * 0.5 + 0.5) * size)), ivec2(0), last);
+    ivec2 p1 = clamp(ivec2(floor((hi * 0.5 + 0.5) * size)), ivec2(0), last);
+
+    int level = 0;
+    while (level < levels - 1 && ((p1.x >> level) - (p0.x >> level) > 1 || (p1.y >> level) - (p0.y >> level) > 1)) level++;
+
+    // The last texel of a level also covers the column / row an odd size drops
+    ivec2 levelLast = max(levelSize0 >> level, ivec2(1)) - 1;
+    ivec2 a = min(p0 >> level, levelLast);
+    ivec2 b = min(p1 >> level, levelLast);
+    float farthest = max(max(texelFetch(hiZ, a, level).r, texelFetch(hiZ, ivec2(b.x, a.y), level).r),
+                         max(texelFetch(hiZ, ivec2(a.x, b.y), level).r, texelFetch(hiZ, b, level).r));
+    return nearest > farthest;
+}
+
+void main()
+{
+    uint i = gl_GlobalInvocationID.x;
+    if (i >= uint(count)) return;
+    visible[i] = occluded(bounds[i].minBounds.xyz, bounds[i].maxBounds.xyz) ? 0u : 1u;
+}
@@ -11,7 +11,17 @@ uniform sampler2D metallicRoughness;
 uniform sampler2D occlusion;
 uniform sampler2D emissive;
 
-uniform vec3 camPos;
+// Shared per-frame data, one upload for every program (gl::FrameUniforms)
+layout(std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPos;
+    vec4 viewport;
+    float time;
+    float deltaTime;
+};
 
 #define MAX_LIGHTS 8
 uniform int numLights;
@@ -64,7 +74,7 @@ void main()
     float alpha = baseSample.a;
 
     vec3 N = getNormalFromMap();
-    vec3 V = normalize(camPos - FragPos);
+    vec3 V = normalize(cameraPos.xyz - FragPos);
     vec3 emissiveColor = texture(emissive, TexCoords).rgb;
     float ao = texture(occlusion, TexCoords).r;
 
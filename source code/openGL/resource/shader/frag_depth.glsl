@@ -0,0 +1,6 @@
+#version 330 core
+
+// Depth pre-pass: colour writes are masked off, only depth is kept
+void main()
+{
+}
@@ -0,0 +1,36 @@
+#version 330 core
+
+// One level of the Hi-Z pyramid (gl::HiZCuller): the farthest depth of the texels it covers.
+// src's base level is set to the level below, so lod 0 reads that level.
+uniform sampler2D src;
+uniform int copyDepth; // level 0: copy the depth texture as is
+
+out float farthest;
+
+float fetch(ivec2 p, ivec2 last)
+{
+    return texelFetch(src, min(p, last), 0).r;
+}
+
+void main()
+{
+    ivec2 dst = ivec2(gl_FragCoord.xy);
+    if (copyDepth != 0) {
+        farthest = texelFetch(src, dst, 0).r;
+        return;
+    }
+
+    ivec2 srcSize = textureSize(src, 0);
+    ivec2 last = srcSize - 1;
+    ivec2 p = dst * 2;
+    float d = max(max(fetch(p, last), fetch(p + ivec2(1, 0), last)), max(fetch(p + ivec2(0, 1), last), fetch(p + ivec2(1, 1), last)));
+
+    // Halving an odd size drops a column / row; the last texel of the level covers it
+    bool extraX = (srcSize.x & 1) == 1 && dst.x == srcSize.x / 2 - 1;
+    bool extraY = (srcSize.y & 1) == 1 && dst.y == srcSize.y / 2 - 1;
+    if (extraX) d = max(d, max(fetch(p + ivec2(2, 0), last), fetch(p + ivec2(2, 1), last)));
+    if (extraY) d = max(d, max(fetch(p + ivec2(0, 2), last), fetch(p + ivec2(1, 2), last)));
+    if (extraX && extraY) d = max(d, fetch(p + ivec2(2, 2), last));
+
+    farthest = d;
+}
@@ -9,15 +9,28 @@ out vec2 TexCoords;
 out vec3 FragPos;
 out mat3 TBN;
 
+// Not bit-identical to vert_depth.glsl; RenderQueue::submitDepth offsets the pre-pass and shading tests GL_LEQUAL
+invariant gl_Position;
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+
+// Shared per-frame data, one upload for every program (gl::FrameUniforms)
+layout(std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPos;
+    vec4 viewport;
+    float time;
+    float deltaTime;
+};
 
 void main()
 {
     // World-space fragment position
     FragPos = vec3(model * vec4(aPos, 1.0));
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = viewProjection * vec4(FragPos, 1.0);
 
     // Build TBN matrix for tangent-space normal mapping
     mat3 normalMatrix = mat3(transpose(inverse(model)));
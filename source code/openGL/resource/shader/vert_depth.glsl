@@ -0,0 +1,34 @@
+#version 330 core
+
+// Depth pre-pass (gl::RenderQueue::submitDepth). Reads only the position stream: a Standard mesh's
+// position-only VAO (posOffset 0, posScale 1) or a Packed mesh's own VAO with its bounds.
+layout(location = 0) in vec3 aPos;
+
+uniform mat4 model;
+
+// Shared per-frame data, one upload for every program (gl::FrameUniforms)
+layout(std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPos;
+    vec4 viewport;
+    float time;
+    float deltaTime;
+};
+
+// Mesh bounds used to dequantise packed positions
+uniform vec3 posOffset;
+uniform vec3 posScale;
+
+// Does not match vert.glsl, vert_instanced.glsl or vert_packed.glsl bit for bit (different inputs and matrix
+// source), so RenderQueue::submitDepth offsets this pass and the shading pass tests GL_LEQUAL
+invariant gl_Position;
+
+void main()
+{
+    vec3 position = posOffset + aPos * posScale;
+    vec3 worldPos = vec3(model * vec4(position, 1.0));
+    gl_Position = viewProjection * vec4(worldPos, 1.0);
+}
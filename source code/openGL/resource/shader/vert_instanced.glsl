@@ -0,0 +1,50 @@
+#version 330 core
+
+layout(location = 0) in vec3 aPos;
+layout(location = 1) in vec3 aNormal;
+layout(location = 2) in vec2 aTexCoords;
+layout(location = 3) in vec3 aTangent;
+
+// Per-instance model matrix (locations 5-8), fed by the scene's instance batches and multi-draw queue.
+// Object::render passes it as a constant attribute instead.
+layout(location = 5) in mat4 instanceModel;
+
+out vec2 TexCoords;
+out vec3 FragPos;
+out mat3 TBN;
+
+// Not bit-identical to vert_depth.glsl; RenderQueue::submitDepth offsets the pre-pass and shading tests GL_LEQUAL
+invariant gl_Position;
+
+// Shared per-frame data, one upload for every program (gl::FrameUniforms)
+layout(std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPos;
+    vec4 viewport;
+    float time;
+    float deltaTime;
+};
+
+void main()
+{
+    // World-space fragment position
+    FragPos = vec3(instanceModel * vec4(aPos, 1.0));
+    gl_Position = viewProjection * vec4(FragPos, 1.0);
+
+    // Build TBN matrix for tangent-space normal mapping
+    mat3 normalMatrix = mat3(transpose(inverse(instanceModel)));
+
+    vec3 T = normalize(normalMatrix * aTangent);
+    vec3 N = normalize(normalMatrix * aNormal);
+
+    // Orthonormalize tangent to prevent skewed TBN
+    T = normalize(T - dot(T, N) * N);
+    vec3 B = cross(N, T);
+
+    TBN = mat3(T, B, N);
+
+    TexCoords = aTexCoords;
+}
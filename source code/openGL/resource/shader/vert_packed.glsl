@@ -0,0 +1,63 @@
+#version 330 core
+
+// gl::PackedVertex (20 bytes), see PackedVertex.hpp
+layout(location = 0) in vec4 aPos;       // unorm16 xyz within mesh bounds, w = bitangent sign
+layout(location = 1) in vec2 aNormal;    // octahedral snorm16
+layout(location = 2) in vec2 aTexCoords; // half float
+layout(location = 3) in vec2 aTangent;   // octahedral snorm16
+
+out vec2 TexCoords;
+out vec3 FragPos;
+out mat3 TBN;
+
+// Not bit-identical to vert_depth.glsl; RenderQueue::submitDepth offsets the pre-pass and shading tests GL_LEQUAL
+invariant gl_Position;
+
+uniform mat4 model;
+
+// Shared per-frame data, one upload for every program (gl::FrameUniforms)
+layout(std140) uniform Frame
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPos;
+    vec4 viewport;
+    float time;
+    float deltaTime;
+};
+
+// Mesh bounds used to dequantise positions
+uniform vec3 posOffset;
+uniform vec3 posScale;
+
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+void main()
+{
+    vec3 position = posOffset + aPos.xyz * posScale;
+
+    // World-space fragment position
+    FragPos = vec3(model * vec4(position, 1.0));
+    gl_Position = viewProjection * vec4(FragPos, 1.0);
+
+    // Build TBN matrix for tangent-space normal mapping
+    mat3 normalMatrix = mat3(transpose(inverse(model)));
+
+    vec3 T = normalize(normalMatrix * octDecode(aTangent));
+    vec3 N = normalize(normalMatrix * octDecode(aNormal));
+
+    // Orthonormalize tangent to prevent skewed TBN
+    T = normalize(T - dot(T, N) * N);
+    vec3 B = cross(N, T) * (aPos.w > 0.5 ? 1.0 : -1.0);
+
+    TBN = mat3(T, B, N);
+
+    TexCoords = aTexCoords;
+}
@@ -2,11 +2,14 @@
 #include <window.hpp>
 #include <Utils.hpp>
 #include <Mesh.hpp>
+#include <ModelLoader.hpp>
+#include <Benchmark.hpp>
 
 #include <iostream>
 #include <memory>
 #include <thread>
 #include <chrono>
+#include <string>
 
 #include <windows.h>
 
@@ -26,10 +29,10 @@ int WINAPI WinMain(
 ) {
     if (!glfwInit()) return -1;
     auto window = std::make_shared<gl::window>(960, 540, "window");
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
-    glDisable(GL_BLEND);
-    glEnable(GL_DEPTH_TEST);
+    gl::getGLState().setEnabled(GL_CULL_FACE, true);
+    gl::getGLState().cullFace(GL_BACK);
+    gl::getGLState().setEnabled(GL_BLEND, false);
+    gl::getGLState().setEnabled(GL_DEPTH_TEST, true);
 
     if (glewInit() != GLEW_OK) return -1;
 
@@ -39,6 +42,43 @@ int WINAPI WinMain(
 
     shader->useProgram();
 
+    const std::string cmdLine = lpCmdLine ? lpCmdLine : "";
+    const std::vector<std::string> models = {
+        "resource/model/M4A1.glb",
+        "resource/model/USPS.glb",
+        "resource/model/awp.glb",
+        "resource/model/donut.glb",
+        "resource/model/model.glb",
+        "resource/model/player.glb"
+    };
+
+    if (cmdLine.find("--bench-load") != std::string::npos) gl::bench::printModelLoad(models);
+    if (cmdLine.find("--bench-parallel-load") != std::string::npos) gl::bench::printParallelLoad(models);
+    if (cmdLine.find("--bench-mesh-opt") != std::string::npos) gl::bench::printMeshOptimization(models);
+    if (cmdLine.find("--bench-vertex-format") != std::string::npos) gl::bench::printVertexFormats(models);
+    if (cmdLine.find("--bench-lod") != std::string::npos) gl::bench::printLods(models, (float)window->getHeight());
+    if (cmdLine.find("--bench-meshlets") != std::string::npos)
+        gl::bench::printMeshletCulling({ "resource/model/M4A1.glb", "resource/model/USPS.glb", "resource/model/awp.glb" },
+            (float)window->getWidth() / (float)window->getHeight());
+    if (cmdLine.find("--check-alloc") != std::string::npos) return gl::bench::checkMeshAllocations(models) ? 0 : 1;
+    if (cmdLine.find("--bench-registry") != std::string::npos) gl::bench::printAssetRegistry("resource/model/donut.glb");
+    if (cmdLine.find("--bench-glb") != std::string::npos) gl::bench::printGlbLoad(models);
+    if (cmdLine.find("--bench-textures") != std::string::npos) gl::bench::printTextureDecode(models);
+    if (cmdLine.find("--bench-geometry-pool") != std::string::npos) gl::bench::printGeometryPool(models, shader, (float)window->getHeight());
+    if (cmdLine.find("--bench-mdi") != std::string::npos) gl::bench::printMultiDraw("resource/model/donut.glb", (float)window->getHeight());
+    if (cmdLine.find("--bench-instancing") != std::string::npos) gl::bench::printInstancing("resource/model/donut.glb", (float)window->getHeight());
+    if (cmdLine.find("--bench-stream") != std::string::npos) gl::bench::printStreamBuffer();
+    if (cmdLine.find("--bench-state") != std::string::npos) gl::bench::printStateCache("resource/model/donut.glb", (float)window->getHeight());
+    if (cmdLine.find("--bench-render-queue") != std::string::npos) gl::bench::printRenderQueue("resource/model/donut.glb", (float)window->getHeight());
+    if (cmdLine.find("--bench-render-thread") != std::string::npos) gl::bench::printRenderThread("resource/model/donut.glb", (float)window->getHeight());
+    if (cmdLine.find("--bench-depth-prepass") != std::string::npos) gl::bench::printDepthPrepass("resource/model/donut.glb", (float)window->getHeight());
+    if (cmdLine.find("--bench-occlusion") != std::string::npos) gl::bench::printOcclusion("resource/model/donut.glb", (float)window->getHeight());
+    if (cmdLine.find("--bench-frustum") != std::string::npos) gl::bench::printFrustumCulling();
+    if (cmdLine.find("--bench-bvh") != std::string::npos) gl::bench::printBvh();
+    if (cmdLine.find("--bench-scene-lookup") != std::string::npos) gl::bench::printSceneLookup();
+    if (cmdLine.find("--bench-entities") != std::string::npos) gl::bench::printEntities("resource/model/donut.glb", (float)window->getHeight());
+    if (cmdLine.find("--bench-hierarchy") != std::string::npos) gl::bench::printTransformHierarchy();
+
     gl::player player(gl::camera(glm::vec3(0.0f, 0.0f, 5.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f)), 
         window, shader);
 
@@ -106,9 +146,18 @@ int WINAPI WinMain(
         }
     );
 
+    // --render-thread: this thread polls input, simulates and records; a render thread owns the context
+    gl::RenderThread renderThread;
+
     window->addUIWindow("fps counter", glm::vec2(200.0f, 150.0f), glm::vec2(0.0f), true, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoMove,
-        [&window]() {
+        [&window, &renderThread]() {
             ImGui::Text("fps: %.3f", window->getFps());
+            if (renderThread.running()) {
+                const gl::RenderThreadStats& st = renderThread.stats();
+                const double frames = st.frames ? double(st.frames) : 1.0;
+                ImGui::Text("render: %.3f ms", st.executeMs / frames);
+                ImGui::Text("sim wait: %.3f ms", st.simulationWaitMs / frames);
+            }
         }
     );
 
@@ -125,12 +174,21 @@ int WINAPI WinMain(
         0.0f, 0.0f, -5.0f, 1.0f
     );
 
+    if (cmdLine.find("--render-thread") != std::string::npos) {
+        window->releaseContext();
+        renderThread.start(window->getWindow());
+    }
+
     while (window->ifRun()) {
         auto frameStart = std::chrono::high_resolution_clock::now();
 
-        window->clearColor(glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+        // Recorded for the render thread, or null when this thread draws
+        gl::CommandList* list = renderThread.running() ? &renderThread.begin() : nullptr;
+
+        if (list) list->clear(glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
+        else window->clearColor(glm::vec4(1.0f, 1.0f, 1.0f, 1.0f));
   
-        window->imguiNewFrame();
+        window->imguiNewFrame(!list);
   
         if (pause) {
             window->setInputMode(GLFW_CURSOR, GLFW_CURSOR_NORMAL);
@@ -152,17 +210,23 @@ int WINAPI WinMain(
 
             window->getUIWindow("fps counter").render();
             window->setInputMode(GLFW_CURSOR, GLFW_CURSOR_DISABLED);
-            player.update();
+            if (list) player.record(*list);
+            else player.update();
 
             weapon += window->getCursorCallBack().scrollY;
         }
   
-        window->imguiRender();
+        if (list) {
+            list->ui(window->imguiDrawData());
+            list->present();
+            renderThread.submit();
+        }
+        else window->imguiRender();
   
         window->setScrollX(0.0f);
         window->setScrollY(0.0f);
 
-        window->swapBuffers();
+        if (!list) window->swapBuffers();
 
         /*while (true) {
             GLenum err = glGetError();
@@ -173,6 +237,11 @@ int WINAPI WinMain(
         if (sleepTime > 0.0) std::this_thread::sleep_for(std::chrono::duration<double>(sleepTime));
     }
 
+    if (renderThread.running()) {
+        renderThread.stop();
+        window->acquireContext();
+    }
+
     glfwTerminate();
 
     //std::cin.get();